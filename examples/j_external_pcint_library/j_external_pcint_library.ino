@@ -115,7 +115,9 @@ bool getResults(char i, int resultsExpected) {
       char c = mySDI12.peek();
       if (c == '-' || (c >= '0' && c <= '9') || c == '.') {
         float result = mySDI12.parseFloat(SKIP_NONE);
-        Serial.print(String(result, 10));
+        char  text[10];  // no String, so nothing is allocated
+        SDI12::formatValue(result, 6, text);
+        Serial.print(text[0] == '+' ? text + 1 : text);
         if (result != -9999) { resultsReceived++; }
       } else if (c == '+') {
         mySDI12.read();
@@ -0,0 +1,104 @@
+/**
+ * @file l_virtual_sensors.ino
+ * @copyright (c) 2013-2020 Stroud Water Research Center (SWRC)
+ *                          and the EnviroDIY Development Team
+ *            This example is published under the BSD-3 license.
+ *
+ * @brief Example L:  Several Virtual Sensors
+ *
+ * Example sketch demonstrating how to make one Arduino appear on an SDI-12 bus as
+ * several sensors.  Four analog probes are sensors 1 to 4; each averages its probe
+ * for a second after a measurement command, without holding up the others.
+ *
+ * The sensors share one command table and measure handler; the handlers find each
+ * probe's pin and measurement state through the sensor's context.  The data commands
+ * (aD0!-aD9!) are answered from each sensor's SDI12DataPages.
+ */
+
+#include <SDI12.h>
+#include <SDI12Sensor.h>
+#include <SDI12SensorNode.h>
+#include <SDI12DataPages.h>
+
+#define DATA_PIN 7       /*!< The pin of the SDI-12 data bus */
+#define MEASURE_MS 1000  /*!< How long each probe is averaged for */
+
+/**
+ * @brief The state of one probe's measurement
+ */
+struct Probe {
+  uint8_t        pin;      /*!< The analog pin of the probe */
+  uint32_t       started;  /*!< millis() when the measurement started */
+  uint32_t       sum;      /*!< The sum of the readings so far */
+  uint16_t       readings; /*!< The number of readings so far */
+  SDI12DataPages pages;    /*!< The results */
+};
+
+const uint8_t probePins[4] = {A0, A1, A2, A3};
+Probe         probes[4];
+
+// Create object by which to communicate with the SDI-12 bus on SDIPIN
+SDI12 slaveSDI12(DATA_PIN);
+
+int identify(SDI12Sensor&, const char*, char* reply, uint8_t size) {
+  const char id[] = "14ENVIRODIANALOG1001";  // Substitute proper ID String here
+  if (sizeof(id) - 1 > size) return SDI12_NO_REPLY;
+  memcpy(reply, id, sizeof(id) - 1);
+  return sizeof(id) - 1;
+}
+
+bool startMeasurement(SDI12Sensor& sensor, uint8_t index, uint16_t* seconds,
+                      uint8_t* count) {
+  // aM! and aC! only; 1 value ready in 1 s
+  if (index != 0) return false;
+  Probe* probe    = (Probe*)sensor.getContext();
+  probe->started  = millis();
+  probe->sum      = 0;
+  probe->readings = 0;
+  *seconds        = 1;
+  *count          = 1;
+  return true;
+}
+
+// The handlers, checked in order against the start of each command
+const SDI12Command commands[] = {
+  {"I", identify},
+};
+
+SDI12Sensor sensor1(slaveSDI12, '1', commands, 1);
+SDI12Sensor sensor2(slaveSDI12, '2', commands, 1);
+SDI12Sensor sensor3(slaveSDI12, '3', commands, 1);
+SDI12Sensor sensor4(slaveSDI12, '4', commands, 1);
+
+SDI12Sensor* const sensors[] = {&sensor1, &sensor2, &sensor3, &sensor4};
+SDI12SensorNode    node(slaveSDI12, sensors, 4);
+
+void setup() {
+  for (uint8_t i = 0; i < 4; i++) {
+    probes[i].pin = probePins[i];
+    sensors[i]->setContext(&probes[i]);
+    sensors[i]->setDataPages(&probes[i].pages);
+    sensors[i]->setMeasureHandler(startMeasurement);
+  }
+  node.begin();
+}
+
+void loop() {
+  // Answer any command that has come in; the reply has to start within 15 ms of the
+  // end of the command, so nothing else in the loop should take long
+  node.poll();
+
+  // Take one reading on each probe that is measuring, and finish the ones that are done
+  for (uint8_t i = 0; i < 4; i++) {
+    Probe& probe = probes[i];
+    if (!sensors[i]->isMeasuring()) continue;
+    probe.sum += analogRead(probe.pin);
+    probe.readings++;
+    if (millis() - probe.started < MEASURE_MS) continue;
+
+    // This formats the value into the sensor's pages and, for aM!, sends the "service
+    // request" (<address><CR><LF>)
+    float value = (float)probe.sum / probe.readings;
+    sensors[i]->finishMeasurement(&value, 1);
+  }
+}
@@ -0,0 +1,81 @@
+/**
+ * @file m_continuous_sampler.ino
+ * @copyright (c) 2013-2020 Stroud Water Research Center (SWRC)
+ *                          and the EnviroDIY Development Team
+ *            This example is published under the BSD-3 license.
+ *
+ * @brief Example M:  Streaming Continuous Measurements
+ *
+ * Example sketch demonstrating how to read a flow sensor's continuous measurement
+ * (aR0!) back to back with SDI12Sampler.  The sampler parses each response into an
+ * SDI12SampleRing, with the time the command was sent, and the loop prints the samples
+ * and the rate they come in at.
+ */
+
+#include <SDI12.h>
+#include <SDI12Sampler.h>
+
+#define SERIAL_BAUD 115200 /*!< The baud rate for the output serial port */
+#define DATA_PIN 7         /*!< The pin of the SDI-12 data bus */
+#define POWER_PIN 22       /*!< The sensor power pin (or -1 if not switching power) */
+#define SENSOR_ADDRESS "0" /*!< The address of the sensor, or several to read in turn */
+
+/** Define the SDI-12 bus */
+SDI12 mySDI12(DATA_PIN);
+/** The samples, waiting to be printed */
+SDI12SampleRing samples;
+/** Reads the sensor into the ring */
+SDI12Sampler sampler(mySDI12, samples);
+
+uint32_t samplesRead = 0;
+uint32_t firstSample = 0;
+
+void setup() {
+  Serial.begin(SERIAL_BAUD);
+  while (!Serial)
+    ;
+
+  Serial.println("Opening SDI-12 bus...");
+  mySDI12.begin();
+  delay(500);  // allow things to settle
+
+  // Power the sensors;
+  if (POWER_PIN > 0) {
+    Serial.println("Powering up sensors...");
+    pinMode(POWER_PIN, OUTPUT);
+    digitalWrite(POWER_PIN, HIGH);
+    delay(200);
+  }
+
+  sampler.start(SENSOR_ADDRESS, 0);
+}
+
+void loop() {
+  // Take in the response, if it's complete, and send the next command; anything else
+  // in the loop delays the next sample
+  sampler.poll();
+
+  SDI12Sample sample;
+  while (samples.pop(sample)) {
+    if (samplesRead++ == 0) firstSample = sample.timestamp;
+    Serial.print(sample.timestamp);
+    Serial.print(", ");
+    Serial.print(sample.address);
+    for (uint8_t i = 0; i < sample.count && i < SDI12_SAMPLE_MAX_VALUES; i++) {
+      char text[10];  // no String, so nothing is allocated
+      SDI12::formatValue(sample.values[i], 6, text);
+      Serial.print(", ");
+      Serial.print(text[0] == '+' ? text + 1 : text);
+    }
+    Serial.println();
+
+    if (samplesRead % 100 == 0) {
+      Serial.print("Samples/s: ");
+      Serial.print((samplesRead - 1) * 1000000.0 / (sample.timestamp - firstSample));
+      Serial.print(", timeouts: ");
+      Serial.print(sampler.getTimeouts());
+      Serial.print(", dropped: ");
+      Serial.println(samples.dropped());
+    }
+  }
+}
@@ -49,11 +49,16 @@
 
 
 #include "SDI12.h"  //  Header file for this library
+#if defined(SDI12_SLEEP_WAIT) && defined(__AVR__)
+#include <avr/sleep.h>  // idle sleep while waiting for characters
+#endif
 
 /* ================  Set static constants ===========================================*/
 
 // Pointer to active SDI12 object
 SDI12* SDI12::_activeObject = nullptr;
+// no instance is listening until one starts to
+volatile int8_t SDI12::_listeningPin = -1;
 // Timer functions
 SDI12Timer SDI12::sdi12timer;
 
@@ -78,48 +83,425 @@ uint16_t SDI12::prevBitTCNT;                      // previous RX transition in m
 uint8_t  SDI12::rxState = WAITING_FOR_START_BIT;  // 0: got start bit; >0: bits rcvd
 uint8_t  SDI12::rxMask;   // bit mask for building received character
 uint8_t  SDI12::rxValue;  // character being built
+#if defined(SDI12_OVERSAMPLE) && defined(TICKS_PER_SAMPLE_Q8)
+uint8_t SDI12::rxSamplePhase;     // position of the last sample within the bit
+uint8_t SDI12::rxSampleVotes;     // number of samples of the bit that were HIGH
+uint8_t SDI12::rxSampleTicks_Q8;  // fractional ticks until the next sample
+#endif
+#if defined(SDI12_ADAPTIVE_BAUD)
+uint8_t SDI12::rxBitsPerTick_Q10 = BITS_PER_TICK_Q10;  // bits per tick used by bitTimes()
+uint8_t SDI12::rxCharStartTCNT;         // time of the start bit being decoded
+uint8_t SDI12::rxCRTicks     = 0;       // ticks in the last CR, if it was the last char
+uint8_t SDI12::rxAddrEdgesLeft = 0;     // changes to the end of the expected address
+uint8_t SDI12::rxAddrBits;              // bits to the last change in the address
+bool    SDI12::rxAwaitingAddress = false;  // waiting for the address of a response
+char    SDI12::rxResponseAddress;          // address of the current response
+char    SDI12::rxCalAddress[SDI12_CALIBRATION_SLOTS];  // calibrated sensor addresses
+uint8_t SDI12::rxCalBitsPerTick_Q10[SDI12_CALIBRATION_SLOTS];  // their bits per tick
+uint8_t SDI12::rxCalNext = 0;  // the slot to replace next
+#endif
+#if defined(SDI12_NOISE_FILTER)
+uint8_t SDI12::rxGlitchTicks = TICKS_PER_BIT / 4;  // shortest real pulse, in ticks
+uint8_t  SDI12::rxUndoState;        // decoder state from before the previous change
+uint8_t  SDI12::rxUndoMask;         // ...
+uint8_t  SDI12::rxUndoValue;        // ...
+uint16_t SDI12::rxUndoTCNT;         // ...
+uint8_t  SDI12::rxUndoTail;         // ... and the buffer tail
+#if defined(SDI12_LINE_QUEUE)
+uint8_t SDI12::rxUndoLineTail;  // ... and the line end queue tail
+#endif
+uint16_t SDI12::rxUndoMillis;       // low bits of millis() at the previous change
+uint16_t SDI12::rxEdgeWindowStart;  // low bits of millis() at the start of the window
+uint8_t  SDI12::rxEdgeCount;        // changes in the current window
+volatile bool     SDI12::_rxSuspended = false;  // pin interrupts off for an edge storm
+uint32_t          SDI12::_rxSuspendedMillis;    // when they were turned off
+volatile uint16_t SDI12::_glitchCount    = 0;   // glitches thrown away
+volatile uint16_t SDI12::_edgeStormCount = 0;   // edge storms stopped
+#endif
+#if defined(SDI12_EXTENDED_TIMESTAMPS) && defined(SDI12_EXTENDED_TIMER)
+uint32_t SDI12::rxEdgeTimestamp;  // extended time of the previous RX transition
+uint32_t SDI12::rxCharTimestamp;  // extended time of the start bit being decoded
+#if defined(SDI12_NOISE_FILTER)
+uint32_t SDI12::rxUndoEdgeTimestamp;  // rxEdgeTimestamp from before the previous change
+#endif
+uint32_t      SDI12::_listenTimestamp;    // when the line last switched to listening
+uint32_t      SDI12::_responseTimestamp;  // first start bit received since then
+volatile bool SDI12::_awaitingResponse = false;  // nothing received since then
+#endif
+#if defined(SDI12_BREAK_DETECT) && defined(SDI12_EXTENDED_TIMER)
+volatile uint8_t SDI12::_breakCount     = 0;     // breaks seen by the ISR
+uint8_t          SDI12::_breakCountSeen = 0;     // breaks handled by takeBreak()
+volatile uint8_t SDI12::_rxBreakTail    = 0;     // buffer tail at the last break
+uint32_t         SDI12::_breakTimestamp;         // when the last break ended
+void (*SDI12::_breakCallback)(void)     = NULL;  // called at the end of each break
+#endif
+#if defined(SDI12_ADDRESS_FILTER) && defined(SDI12_BREAK_DETECT) && \
+  defined(SDI12_EXTENDED_TIMER)
+uint8_t SDI12::_addressFilter[10];          // addresses kept, a bit each from '0'
+bool    SDI12::_addressFilterOn = false;    // the filter is on
+bool    SDI12::rxFilterFirst    = true;     // next character starts a transmission
+bool    SDI12::rxFilterDrop     = false;    // this transmission is for someone else
+#if defined(SDI12_NOISE_FILTER)
+bool SDI12::rxUndoFilterFirst;  // rxFilterFirst from before the previous change
+bool SDI12::rxUndoFilterDrop;   // rxFilterDrop from before the previous change
+#endif
+#endif
 
-uint16_t SDI12::mul8x8to16(uint8_t x, uint8_t y) {
+uint16_t SDI12_ISR_ATTR SDI12::mul8x8to16(uint8_t x, uint8_t y) {
   return x * y;
 }
 
-uint16_t SDI12::bitTimes(uint8_t dt) {
+uint16_t SDI12_ISR_ATTR SDI12::bitTimes(uint8_t dt) {
+#if defined(SDI12_ADAPTIVE_BAUD)
+  return mul8x8to16(dt + rxWindowWidth, rxBitsPerTick_Q10) >> 10;
+#else
   return mul8x8to16(dt + rxWindowWidth, bitsPerTick_Q10) >> 10;
+#endif
 }
 
 /* ================ Buffer Setup ====================================================*/
 uint8_t          SDI12::_rxBuffer[SDI12_BUFFER_SIZE];  // The Rx buffer
 volatile uint8_t SDI12::_rxBufferTail = 0;             // index of buff tail
 volatile uint8_t SDI12::_rxBufferHead = 0;             // index of buff head
+volatile bool    SDI12::_bufferOverflow = false;         // buffer overflow status
+uint8_t          SDI12::_lineHead       = 0;  // buff head when the line was found
+uint8_t          SDI12::_lineLength     = 0;  // line length to consume, with the LF
+char             SDI12::_lineTerminator = '\n';  // the character that ends a line
+#if defined(SDI12_SLEEP_WAIT) && defined(ESP32)
+TaskHandle_t volatile SDI12::_waitingTask = NULL;  // task in waitAvailable(), if any
+#endif
+#if defined(SDI12_LINE_QUEUE)
+uint8_t          SDI12::_rxLineEnds[SDI12_LINE_QUEUE_SIZE];  // index after each end
+volatile uint8_t SDI12::_rxLineHead      = 0;  // index of the oldest line end
+volatile uint8_t SDI12::_rxLineTail      = 0;  // index after the newest line end
+volatile uint8_t SDI12::_rxLineDrops     = 0;  // line ends that didn't fit
+uint8_t          SDI12::_rxLineDropsSeen = 0;  // ... as of the last time it was empty
+#endif
 
 /* ================ Reading from the SDI-12 Buffer ==================================*/
 
 // reveals the number of characters available in the buffer
 int SDI12::available() {
+#if defined(SDI12_NOISE_FILTER)
+  if (_rxSuspended) resumeAfterEdgeStorm();
+#endif
   if (_bufferOverflow) return -1;
-  return (_rxBufferTail + SDI12_BUFFER_SIZE - _rxBufferHead) % SDI12_BUFFER_SIZE;
+  return (loadIndexAcquire(_rxBufferTail) + SDI12_BUFFER_SIZE - _rxBufferHead) %
+    SDI12_BUFFER_SIZE;
 }
 
 // reveals the next character in the buffer without consuming
 int SDI12::peek() {
-  if (_rxBufferHead == _rxBufferTail) return -1;  // Empty buffer? If yes, -1
-  return _rxBuffer[_rxBufferHead];                // Otherwise, read from "head"
+#if defined(SDI12_NOISE_FILTER)
+  if (_rxSuspended) resumeAfterEdgeStorm();
+#endif
+  uint8_t head = _rxBufferHead;
+  if (head == loadIndexAcquire(_rxBufferTail)) return -1;  // Empty buffer? If yes, -1
+  return _rxBuffer[head];  // Otherwise, read from "head"
 }
 
 // a public function that clears the buffer contents and resets the status of the buffer
 // overflow.
 void SDI12::clearBuffer() {
-  _rxBufferHead = _rxBufferTail = 0;
-  _bufferOverflow               = false;
+  // The tail belongs to the receive ISR; emptying the buffer is catching up to it
+#if defined(SDI12_LINE_QUEUE)
+  // every line end queued so far is for a character being cleared
+  uint8_t drops = loadIndexAcquire(_rxLineDrops);
+  storeIndexRelease(_rxLineHead, loadIndexAcquire(_rxLineTail));
+  storeIndexRelease(_rxBufferHead, loadIndexAcquire(_rxBufferTail));
+  _rxLineDropsSeen = drops;
+#else
+  storeIndexRelease(_rxBufferHead, loadIndexAcquire(_rxBufferTail));
+#endif
+  _bufferOverflow = false;
+  _lineLength     = 0;
 }
 
 // reads in the next character from the buffer (and moves the index ahead)
 int SDI12::read() {
-  _bufferOverflow = false;                        // Reading makes room in the buffer
-  if (_rxBufferHead == _rxBufferTail) return -1;  // Empty buffer? If yes, -1
-  uint8_t nextChar = _rxBuffer[_rxBufferHead];    // Otherwise, grab char at head
-  _rxBufferHead    = (_rxBufferHead + 1) % SDI12_BUFFER_SIZE;  // increment head
-  return nextChar;                                             // return the char
+#if defined(SDI12_NOISE_FILTER)
+  if (_rxSuspended) resumeAfterEdgeStorm();
+#endif
+  _bufferOverflow = false;  // Reading makes room in the buffer
+  uint8_t head    = _rxBufferHead;
+  if (head == loadIndexAcquire(_rxBufferTail)) return -1;  // Empty buffer? If yes, -1
+  uint8_t nextChar = _rxBuffer[head];  // Otherwise, grab char at head
+  // increment head, after the char is read so the ISR can't overwrite it first
+  storeIndexRelease(_rxBufferHead, (head + 1) % SDI12_BUFFER_SIZE);
+  return nextChar;  // return the char
+}
+
+// copies everything available, up to length or a terminator, out of the buffer in one
+// pass
+size_t SDI12::copyFromBuffer(uint8_t* dest, size_t length, int terminator,
+                             bool* terminated) {
+#if defined(SDI12_NOISE_FILTER)
+  if (_rxSuspended) resumeAfterEdgeStorm();
+#endif
+  _bufferOverflow = false;  // Reading makes room in the buffer
+  uint8_t head    = _rxBufferHead;
+  uint8_t tail    = loadIndexAcquire(_rxBufferTail);
+  size_t  count   = (tail + SDI12_BUFFER_SIZE - head) % SDI12_BUFFER_SIZE;
+  if (count > length) count = length;
+  // the part up to the end of the array, then the part wrapped around to the start
+  size_t first = SDI12_BUFFER_SIZE - head;
+  if (first > count) first = count;
+  size_t consumed = count;
+  if (terminator >= 0) {
+    // stop at the terminator; it is consumed, but not copied
+    const uint8_t* found = (const uint8_t*)memchr(_rxBuffer + head, terminator, first);
+    if (found) {
+      count = found - (_rxBuffer + head);
+      first = count;
+    } else {
+      found = (const uint8_t*)memchr(_rxBuffer, terminator, count - first);
+      if (found) count = first + (found - _rxBuffer);
+    }
+    if (found) consumed = count + 1;
+    if (terminated) *terminated = (found != NULL);
+  }
+  memcpy(dest, _rxBuffer + head, first);
+  memcpy(dest + first, _rxBuffer, count - first);
+  storeIndexRelease(_rxBufferHead, (head + consumed) % SDI12_BUFFER_SIZE);
+  return count;
+}
+
+// finds the length of the first line, with its terminator, by searching the buffer
+uint8_t SDI12::scanLineLength(uint8_t head, uint8_t count) {
+  // look in the part up to the end of the array, then in the wrapped part
+  uint8_t first = SDI12_BUFFER_SIZE - head;
+  if (first > count) first = count;
+  const uint8_t* found = (const uint8_t*)memchr(_rxBuffer + head, _lineTerminator,
+                                                first);
+  if (found) return found - (_rxBuffer + head) + 1;
+  found = (const uint8_t*)memchr(_rxBuffer, _lineTerminator, count - first);
+  if (found) return first + (found - _rxBuffer) + 1;
+  return 0;  // no complete line yet
+}
+
+#if defined(SDI12_LINE_QUEUE)
+// finds the length of the first line, with its terminator, from the queue of line ends
+uint8_t SDI12::queuedLineLength(uint8_t head, uint8_t count, uint8_t lineTail,
+                                uint8_t drops) {
+  uint8_t lineHead = _rxLineHead;
+  uint8_t length   = 0;
+  while (lineHead != lineTail) {
+    length = (_rxLineEnds[lineHead] + SDI12_BUFFER_SIZE - head) % SDI12_BUFFER_SIZE;
+    if (length != 0 && length <= count) break;
+    // the buffer has already been read past the end of this line
+    lineHead = (lineHead + 1) % SDI12_LINE_QUEUE_SIZE;
+    length   = 0;
+  }
+  storeIndexRelease(_rxLineHead, lineHead);
+  if (drops != _rxLineDropsSeen) {
+    // Some line ends didn't fit in the queue.  Once the buffer has been emptied all of
+    // them are gone, until then the queue can't be trusted.
+    if (count == 0) {
+      _rxLineDropsSeen = drops;
+    } else {
+      return scanLineLength(head, count);
+    }
+  }
+  return length;
+}
+#endif
+
+// finds the next whole line in the buffer, and points the view at it in place
+bool SDI12::peekLine(SDI12Line& line) {
+#if defined(SDI12_NOISE_FILTER)
+  if (_rxSuspended) resumeAfterEdgeStorm();
+#endif
+  uint8_t head = _rxBufferHead;
+#if defined(SDI12_LINE_QUEUE)
+  // Load the line ends before the tail, so that every end seen is inside the tail
+  uint8_t drops    = loadIndexAcquire(_rxLineDrops);
+  uint8_t lineTail = loadIndexAcquire(_rxLineTail);
+#endif
+  uint8_t tail  = loadIndexAcquire(_rxBufferTail);
+  uint8_t count = (tail + SDI12_BUFFER_SIZE - head) % SDI12_BUFFER_SIZE;
+#if defined(SDI12_LINE_QUEUE)
+  uint8_t length = queuedLineLength(head, count, lineTail, drops);
+#else
+  uint8_t length = scanLineLength(head, count);
+#endif
+  if (length == 0) return false;
+  _lineHead   = head;
+  _lineLength = length;
+  // neither the terminator nor the CR before a LF is part of the line
+  length--;
+  if (_lineTerminator == '\n' && length > 0 &&
+      _rxBuffer[(head + length - 1) % SDI12_BUFFER_SIZE] == '\r') {
+    length--;
+  }
+  uint8_t first     = SDI12_BUFFER_SIZE - head;
+  line.first        = (const char*)_rxBuffer + head;
+  line.firstLength  = length < first ? length : first;
+  line.second       = (const char*)_rxBuffer;
+  line.secondLength = length - line.firstLength;
+  return true;
+}
+
+// counts the complete lines in the buffer
+int SDI12::availableLines() {
+#if defined(SDI12_NOISE_FILTER)
+  if (_rxSuspended) resumeAfterEdgeStorm();
+#endif
+  uint8_t head = _rxBufferHead;
+#if defined(SDI12_LINE_QUEUE)
+  uint8_t drops    = loadIndexAcquire(_rxLineDrops);
+  uint8_t lineTail = loadIndexAcquire(_rxLineTail);
+#endif
+  uint8_t tail  = loadIndexAcquire(_rxBufferTail);
+  uint8_t count = (tail + SDI12_BUFFER_SIZE - head) % SDI12_BUFFER_SIZE;
+#if defined(SDI12_LINE_QUEUE)
+  // drop the ends that have been read past
+  queuedLineLength(head, count, lineTail, drops);
+  if (drops == _rxLineDropsSeen) {
+    return (lineTail + SDI12_LINE_QUEUE_SIZE - _rxLineHead) % SDI12_LINE_QUEUE_SIZE;
+  }
+#endif
+  int lines = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    if (_rxBuffer[(head + i) % SDI12_BUFFER_SIZE] == (uint8_t)_lineTerminator) lines++;
+  }
+  return lines;
+}
+
+// sets the character that ends a line
+void SDI12::setLineTerminator(char terminator) {
+  _lineTerminator = terminator;
+  clearBuffer();
+}
+
+// releases the line found by peekLine()
+void SDI12::consume() {
+  // Only if nothing else has read from the buffer since
+  if (_lineLength == 0 || _rxBufferHead != _lineHead) return;
+  _bufferOverflow = false;  // Reading makes room in the buffer
+  storeIndexRelease(_rxBufferHead, (_lineHead + _lineLength) % SDI12_BUFFER_SIZE);
+  _lineLength = 0;
+}
+
+// these functions HIDE (or override, where they're virtual) the stream equivalents to
+// copy from the buffer in bulk rather than calling read() for each character
+size_t SDI12::readBytes(char* buffer, size_t length) {
+  size_t count = 0;
+  while (count < length) {
+    size_t n = copyFromBuffer((uint8_t*)buffer + count, length - count);
+    // like Stream, the timeout is from the last character
+    if (n > 0) {
+      count += n;
+    } else if (!waitAvailable(1, _timeout)) {
+      break;
+    }
+  }
+  return count;
+}
+
+size_t SDI12::readBytesUntil(char terminator, char* buffer, size_t length) {
+  size_t count      = 0;
+  bool   terminated = false;
+  while (count < length && !terminated) {
+    size_t n = copyFromBuffer((uint8_t*)buffer + count, length - count,
+                              (uint8_t)terminator, &terminated);
+    if (n > 0 || terminated) {
+      count += n;
+    } else if (!waitAvailable(1, _timeout)) {
+      break;
+    }
+  }
+  return count;
+}
+
+String SDI12::readStringUntil(char terminator) {
+  String ret;
+  char   chunk[SDI12_READ_CHUNK_SIZE + 1];
+  bool   terminated = false;
+  while (!terminated) {
+    size_t n = copyFromBuffer((uint8_t*)chunk, SDI12_READ_CHUNK_SIZE, (uint8_t)terminator,
+                              &terminated);
+    if (n > 0 || terminated) {
+      chunk[n] = '\0';
+      ret += chunk;
+    } else if (!waitAvailable(1, _timeout)) {
+      break;
+    }
+  }
+  return ret;
+}
+
+// waits for characters, sleeping until an interrupt between checks
+bool SDI12::waitAvailable(int count, uint32_t timeout) {
+  uint32_t start = millis();
+  while (true) {
+    // Take the tail before checking, so a character arriving after the check stops
+    // the sleep
+    uint8_t tail      = loadIndexAcquire(_rxBufferTail);
+    int     available = this->available();
+    if (available < 0 || available >= count) return true;  // -1 is a full buffer
+    uint32_t waited = millis() - start;
+    if (waited >= timeout) return false;
+    sleepUntilReceive(tail, timeout - waited);
+  }
+}
+
+// sleeps until the next interrupt, unless a character has arrived since the tail was
+// taken
+void SDI12::sleepUntilReceive(uint8_t seenTail, uint32_t maxMillis) {
+#if defined(SDI12_SLEEP_WAIT) && defined(__AVR__)
+  // Idle sleep stops the CPU but not the timers, so the millis() interrupt still wakes
+  // it every millisecond
+  (void)maxMillis;
+  uint8_t oldSREG = SREG;
+  if (!(oldSREG & 0x80)) return;  // with interrupts off nothing could wake it
+  uint8_t oldSMCR = SMCR;
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  cli();
+  if (_rxBufferTail == seenTail) {
+    sleep_enable();
+    // sei() only takes effect after the next instruction, so an interrupt from here
+    // on still wakes the sleep
+    sei();
+    sleep_cpu();
+    sleep_disable();
+  }
+  SMCR = oldSMCR;
+  SREG = oldSREG;
+#elif defined(SDI12_SLEEP_WAIT) && defined(ARDUINO_ARCH_SAMD)
+  // WFI wakes on a pending interrupt even while they are masked, so the check can't
+  // miss one; SysTick wakes it every millisecond
+  (void)maxMillis;
+  if (__get_PRIMASK()) return;  // with interrupts off nothing could wake it
+  __disable_irq();
+  if (_rxBufferTail == seenTail) {
+    __DSB();
+    __WFI();
+  }
+  __enable_irq();
+#elif defined(SDI12_SLEEP_WAIT) && defined(ESP32)
+  // Block this task until charToBuffer() notifies it; a notification given between the
+  // check and the take makes the take return at once
+  if (maxMillis > 100) maxMillis = 100;
+  _waitingTask = xTaskGetCurrentTaskHandle();
+  if (loadIndexAcquire(_rxBufferTail) == seenTail) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(maxMillis) + 1);
+  }
+  _waitingTask = NULL;
+#else
+  (void)seenTail;
+  (void)maxMillis;
+  yield();
+#endif
+}
+
+// these functions HIDE the stream equivalents to wait for characters with
+// waitAvailable()
+int SDI12::timedRead() {
+  return waitAvailable(1, _timeout) ? read() : -1;
+}
+
+int SDI12::timedPeek() {
+  return waitAvailable(1, _timeout) ? peek() : -1;
 }
 
 // these functions HIDE the stream equivalents to return a custom timeout value
@@ -207,6 +589,175 @@ float SDI12::parseFloat(LookaheadMode lookahead, char ignore) {
     return value;
 }
 
+// SDI-12 values are a sign, then at most 7 digits with a decimal point among them.
+// SDI12_SWAR_PARSE can also be defined by the build, as the HostTests tool does for
+// its fake AVR.
+#if !defined(SDI12_SWAR_PARSE) && !defined(__AVR__) && defined(__BYTE_ORDER__) && \
+  __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define SDI12_SWAR_PARSE
+#endif
+
+// 10^n as floats; all of them are exact
+static const float parseDivisors[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f,
+                                      1e5f, 1e6f, 1e7f, 1e8f, 1e9f};
+
+#if defined(SDI12_SWAR_PARSE)
+static const uint64_t swarOnes = 0x0101010101010101ULL;
+
+// sets the high bit of each byte of x that is zero, and no others
+static inline uint64_t swarZeroBytes(uint64_t x) {
+  const uint64_t low7 = 0x7F * swarOnes;
+  return ~(((x & low7) + low7) | x | low7);
+}
+
+// converts 4 digit bytes, less '0', the first the most significant
+static inline uint32_t swarDigits4(uint32_t x) {
+  // both products are taken modulo 2^32, which drops the unwanted carries
+  x = (uint32_t)((x & 0x0F0F0F0FUL) * 2561U) >> 8;         // pairs: 10 * a + b
+  return (uint32_t)((x & 0x00FF00FFUL) * 6553601U) >> 16;  // 100 * ab + cd
+}
+
+// converts 8 digit bytes, less '0', the first the most significant
+static inline uint32_t swarDigits8(uint64_t x) {
+#if UINTPTR_MAX > 0xFFFFFFFFUL
+  x = ((x & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+  x = ((x & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+  return ((x & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32;
+#else
+  // 32-bit multiplies are cheap, 64-bit ones aren't
+  return swarDigits4((uint32_t)x) * 10000UL + swarDigits4((uint32_t)(x >> 32));
+#endif
+}
+
+// Parses the digits and decimal point of a value from 8 characters at once; near the
+// end of the span, the last 8 characters of it are loaded and moved down.  Returns the
+// number of characters in them, or 0 to leave the value to the scalar path.
+static uint8_t swarParseBody(const char* p, const char* begin, const char* end,
+                             bool last, uint32_t* mantissa, uint8_t* decimals) {
+  size_t   avail = end - p;
+  uint64_t x;
+  if (avail >= 8) {
+    memcpy(&x, p, sizeof(x));
+  } else {
+    if (avail == 0 || end - begin < 8) return 0;
+    memcpy(&x, end - 8, sizeof(x));
+    x >>= 8 * (8 - avail);  // the characters past the end are zeros
+  }
+  // A character is a digit if its high nibble is 3 and adding 6 doesn't carry out of
+  // it.  A carry out of a character only changes the ones after it, which aren't used.
+  uint64_t highNibbles = 0xF0 * swarOnes;
+  uint64_t digits      = swarZeroBytes(((x & highNibbles) ^ (0x30 * swarOnes)) |
+                                       (((x + 0x06 * swarOnes) & highNibbles) ^
+                                        (0x30 * swarOnes)));
+  uint64_t points      = swarZeroBytes(x ^ ('.' * swarOnes));
+  // the value ends at the first character that isn't a digit, or at a second point
+  uint64_t stops = (~(digits | points) & (0x80 * swarOnes)) | (points & (points - 1));
+  uint8_t  length = stops ? __builtin_ctzll(stops) / 8 : 8;
+  // at the end of the span, the value may go on after a wrap; with 8 characters, it
+  // may go on in the ninth
+  if (length == avail ? !last
+                      : length == 8 && ((p[8] >= '0' && p[8] <= '9') ||
+                                        (p[8] == '.' && !points))) {
+    return 0;
+  }
+  uint8_t point = points ? __builtin_ctzll(points) / 8 : 8;
+  uint8_t count = length;
+  *decimals     = 0;
+  if (point < length) {
+    // close up the gap left by the point
+    uint64_t before = ((uint64_t)1 << (8 * point)) - 1;
+    x               = (x & before) | ((x >> 8) & ~before);
+    *decimals       = length - point - 1;
+    count--;
+  }
+  if (count == 0) return 0;
+  // Line the digits up at the top, after zeros.  Only the characters after them can
+  // borrow when '0' is taken away, and they're shifted out.
+  *mantissa = swarDigits8((x - '0' * swarOnes) << (8 * (8 - count)));
+  return length;
+}
+#endif
+
+// Parses the values in text, then in more; more is NULL unless a line wraps
+static uint8_t parseValueSpans(const char* p, const char* end, const char* more,
+                               const char* moreEnd, float* values, uint8_t maxValues) {
+  const char* begin = p;
+  uint8_t     count = 0;
+  while (true) {
+    if (p == end && more) {
+      p = begin = more;
+      end       = moreEnd;
+      more      = NULL;
+    }
+    if (p == end || (*p != '+' && *p != '-')) break;
+    bool     negative = *p++ == '-';
+    uint32_t mantissa = 0;
+    uint8_t  decimals = 0;
+    uint8_t  extra    = 0;  // whole digits after the first 9
+#if defined(SDI12_SWAR_PARSE)
+    uint8_t used = swarParseBody(p, begin, end, !more, &mantissa, &decimals);
+    if (used) {
+      p += used;
+    } else
+#endif
+    {
+      uint8_t digits = 0;  // not counting leading zeros
+      bool    any    = false;
+      bool    point  = false;
+      while (true) {
+        if (p == end && more) {
+          p = begin = more;
+          end       = moreEnd;
+          more      = NULL;
+        }
+        if (p == end) break;
+        char c = *p;
+        if (c >= '0' && c <= '9') {
+          if (digits < 9) {
+            mantissa = mantissa * 10 + (c - '0');
+            if (mantissa) digits++;
+            // past 45 decimal places, a float is 0
+            if (point && decimals < 45) decimals++;
+          } else if (!point) {
+            extra++;
+          }
+          any = true;
+        } else if (c == '.' && !point) {
+          point = true;
+        } else {
+          break;
+        }
+        p++;
+      }
+      if (!any) break;
+    }
+    float value = mantissa;
+    for (; decimals > 9; decimals -= 9) value /= parseDivisors[9];
+    if (decimals) value /= parseDivisors[decimals];
+    while (extra--) value *= 10;
+    if (count < maxValues) values[count] = negative ? -value : value;
+    count++;
+  }
+  return count;
+}
+
+uint8_t SDI12::parseValues(const char* text, size_t length, float* values,
+                           uint8_t maxValues) {
+  return parseValueSpans(text, text + length, NULL, NULL, values, maxValues);
+}
+
+uint8_t SDI12::parseValues(const SDI12Line& line, float* values, uint8_t maxValues) {
+  // the values start after the address
+  if (line.firstLength == 0) {
+    if (line.secondLength == 0) return 0;
+    return parseValueSpans(line.second + 1, line.second + line.secondLength, NULL, NULL,
+                           values, maxValues);
+  }
+  return parseValueSpans(line.first + 1, line.first + line.firstLength,
+                         line.secondLength ? line.second : NULL,
+                         line.second + line.secondLength, values, maxValues);
+}
+
 /* ================ Constructor, Destructor, begin(), end(), and timeout ============*/
 // Constructor
 SDI12::SDI12() {
@@ -243,6 +794,9 @@ SDI12::~SDI12() {
   // Set the timer prescalers back to original values
   // NOTE:  This does NOT reset SAMD board pre-scalers!
   sdi12timer.resetSDI12TimerPrescale();
+#if defined(SDI12_INPUT_CAPTURE) && defined(SDI12_ICP_PIN_REG)
+  if (_dataPinInputCapture) sdi12timer.resetSDI12InputCapture();
+#endif
 }
 
 // Begin
@@ -252,6 +806,9 @@ void SDI12::begin() {
   // Set up the prescaler as needed for timers
   // This function is defined in SDI12_boards.h
   sdi12timer.configSDI12TimerPrescale();
+#if defined(SDI12_INPUT_CAPTURE) && defined(SDI12_ICP_PIN_REG)
+  if (_dataPinInputCapture) sdi12timer.configSDI12InputCapture();
+#endif
 }
 
 void SDI12::begin(int8_t dataPin) {
@@ -266,6 +823,9 @@ void SDI12::end() {
   // Set the timer prescalers back to original values
   // NOTE:  This does NOT reset SAMD board pre-scalers!
   sdi12timer.resetSDI12TimerPrescale();
+#if defined(SDI12_INPUT_CAPTURE) && defined(SDI12_ICP_PIN_REG)
+  if (_dataPinInputCapture) sdi12timer.resetSDI12InputCapture();
+#endif
 }
 
 // Set the timeout return
@@ -276,6 +836,30 @@ void SDI12::setTimeoutValue(int16_t value) {
 // Set the data pin for the SDI-12 instance
 void SDI12::setDataPin(int8_t dataPin) {
   _dataPin = dataPin;
+  if (_dataPin < 0) return;
+  // Look up the port registers for the pin once, so the ISR and the transmit loop
+  // don't have to walk the core's pin tables on every bit
+#if defined(__AVR__)
+  uint8_t port    = digitalPinToPort(_dataPin);
+  _dataPinInReg   = portInputRegister(port);
+  _dataPinOutReg  = portOutputRegister(port);
+  _dataPinModeReg = portModeRegister(port);
+  _dataPinMask    = digitalPinToBitMask(_dataPin);
+  _dataPinPCMSK     = digitalPinToPCMSK(_dataPin);
+  _dataPinPCMSKMask = (1 << digitalPinToPCMSKbit(_dataPin));
+  _dataPinPCICRMask = (1 << digitalPinToPCICRbit(_dataPin));
+#if defined(SDI12_INPUT_CAPTURE) && defined(SDI12_ICP_PIN_REG)
+  _dataPinInputCapture = (_dataPinInReg == &SDI12_ICP_PIN_REG &&
+                          _dataPinMask == _BV(SDI12_ICP_PIN_BIT));
+#endif
+#elif defined(ARDUINO_ARCH_SAMD)
+  _dataPinPort = &PORT->Group[g_APinDescription[_dataPin].ulPort];
+  _dataPinMask = (1ul << g_APinDescription[_dataPin].ulPin);
+  // Enable the input buffer (without the pull-up) so the pin can still be read after
+  // only the direction register is changed
+  _dataPinPort->PINCFG[g_APinDescription[_dataPin].ulPin].reg =
+    (uint8_t)(PORT_PINCFG_INEN);
+#endif
 }
 
 // Return the data pin for the SDI-12 instance
@@ -319,28 +903,65 @@ uint8_t SDI12::parity_even_bit(uint8_t v) {
 
 // a helper function to switch pin interrupts on or off
 void SDI12::setPinInterrupts(bool enable) {
-#if defined(ARDUINO_ARCH_SAMD) || defined(ESP32) || defined(ESP8266)
+#if defined(SDI12_INPUT_CAPTURE) && defined(SDI12_ICP_PIN_REG)
+  // With input capture the "pin interrupt" is the capture timer's capture interrupt
+  if (_dataPinInputCapture) {
+    if (enable) {
+      // Capture the next edge away from the current level
+      if (readDataPin() == LOW) {
+        SDI12_ICP_TCCRB |= _BV(SDI12_ICP_ICES);  // rising edge
+      } else {
+        SDI12_ICP_TCCRB &= ~_BV(SDI12_ICP_ICES);  // falling edge
+      }
+      // clear any capture from before the edge was changed
+      SDI12_ICP_TIFR = _BV(SDI12_ICP_ICF);
+      SDI12_ICP_TIMSK |= _BV(SDI12_ICP_ICIE);
+    } else {
+      SDI12_ICP_TIMSK &= ~_BV(SDI12_ICP_ICIE);
+    }
+    return;
+  }
+#endif
+
+#if defined(SDI12_OVERSAMPLE) && defined(TICKS_PER_SAMPLE_Q8)
+  // The oversampling receiver doesn't use pin interrupts, it samples the pin from the
+  // compare match interrupt on the SDI-12 timer
+  if (enable) {
+    OCR2A            = TCNTX + 1;  // first sample on the next tick
+    rxSampleTicks_Q8 = 0;
+    TIFR2            = _BV(OCF2A);  // clear any old compare match
+    TIMSK2 |= _BV(OCIE2A);
+  } else {
+    TIMSK2 &= ~_BV(OCIE2A);
+  }
+#elif defined(ARDUINO_ARCH_SAMD) || defined(ESP32) || defined(ESP8266)
   // Merely need to attach the interrupt function to the pin
   if (enable) attachInterrupt(digitalPinToInterrupt(_dataPin), handleInterrupt, CHANGE);
   // Merely need to detach the interrupt function from the pin
   else
     detachInterrupt(digitalPinToInterrupt(_dataPin));
 
-#elif defined(__AVR__) && not defined(SDI12_EXTERNAL_PCINT)
+#elif defined(__AVR__)
+#if defined(SDI12_EXTERNAL_PCINT)
+  // The program's own ISR and pin change library look after the pin, except for an
+  // SDI12Bus, whose pin change interrupt is still switched here
+  if (!_switchPinChange) return;
+#endif
+  // The mask registers and bits were looked up in setDataPin()
   if (enable) {
     // Enable interrupts on the register with the pin of interest
-    *digitalPinToPCICR(_dataPin) |= (1 << digitalPinToPCICRbit(_dataPin));
+    *digitalPinToPCICR(_dataPin) |= _dataPinPCICRMask;
     // Enable interrupts on the specific pin of interest
     // The interrupt function is actually attached to the interrupt way down in
     // section 7.5
-    *digitalPinToPCMSK(_dataPin) |= (1 << digitalPinToPCMSKbit(_dataPin));
+    *_dataPinPCMSK |= _dataPinPCMSKMask;
   } else {
     // Disable interrupts on the specific pin of interest
-    *digitalPinToPCMSK(_dataPin) &= ~(1 << digitalPinToPCMSKbit(_dataPin));
-    if (!*digitalPinToPCMSK(_dataPin)) {
+    *_dataPinPCMSK &= ~_dataPinPCMSKMask;
+    if (!*_dataPinPCMSK) {
       // If there are no other pins on the register left with enabled interrupts,
       // disable the whole register
-      *digitalPinToPCICR(_dataPin) &= ~(1 << digitalPinToPCICRbit(_dataPin));
+      *digitalPinToPCICR(_dataPin) &= ~_dataPinPCICRMask;
     }
     // We don't detach the function from the interrupt for AVR processors
   }
@@ -353,35 +974,124 @@ void SDI12::setPinInterrupts(bool enable) {
 #endif
 }
 
+// reads the data pin, directly from the port register where we can
+// NOTE:  Only called from this file, so the definition is visible to every caller
+inline uint8_t SDI12_ISR_ATTR SDI12::readDataPin() {
+#if defined(__AVR__)
+  return (*_dataPinInReg & _dataPinMask) ? HIGH : LOW;
+#elif defined(ARDUINO_ARCH_SAMD)
+  return (_dataPinPort->IN.reg & _dataPinMask) ? HIGH : LOW;
+#else
+  return digitalRead(_dataPin);
+#endif
+}
+
+// writes the data pin, directly to the port register where we can
+inline void SDI12::writeDataPin(uint8_t level) {
+#if defined(__AVR__)
+  // The port register is shared with other pins, so the read-modify-write must not be
+  // interrupted by an ISR touching another pin on the same port
+  uint8_t oldSREG = SREG;
+  cli();
+  if (level == LOW) {
+    *_dataPinOutReg &= ~_dataPinMask;
+  } else {
+    *_dataPinOutReg |= _dataPinMask;
+  }
+  SREG = oldSREG;
+#elif defined(ARDUINO_ARCH_SAMD)
+  // The set and clear registers are atomic, no need to block interrupts
+  if (level == LOW) {
+    _dataPinPort->OUTCLR.reg = _dataPinMask;
+  } else {
+    _dataPinPort->OUTSET.reg = _dataPinMask;
+  }
+#else
+  digitalWrite(_dataPin, level);
+#endif
+}
+
+// changes the direction of the data pin, always with the pull-up off and the output low
+inline void SDI12::setDataPinMode(uint8_t mode) {
+#if defined(__AVR__)
+  uint8_t oldSREG = SREG;
+  cli();
+  *_dataPinOutReg &= ~_dataPinMask;  // Pin state = low (turns off pull-up)
+  if (mode == OUTPUT) {
+    *_dataPinModeReg |= _dataPinMask;  // Pin mode = output
+  } else {
+    *_dataPinModeReg &= ~_dataPinMask;  // Pin mode = input
+  }
+  SREG = oldSREG;
+#elif defined(ARDUINO_ARCH_SAMD)
+  _dataPinPort->OUTCLR.reg = _dataPinMask;  // Pin state = low (no pull-up)
+  if (mode == OUTPUT) {
+    _dataPinPort->DIRSET.reg = _dataPinMask;  // Pin mode = output
+  } else {
+    _dataPinPort->DIRCLR.reg = _dataPinMask;  // Pin mode = input
+  }
+#else
+  if (mode == OUTPUT) {
+    pinMode(_dataPin, INPUT);     // Turn off the pull-up resistor
+    pinMode(_dataPin, OUTPUT);    // Pin mode = output
+    digitalWrite(_dataPin, LOW);  // Pin state = low
+  } else {
+    digitalWrite(_dataPin, LOW);  // Pin state = low (turns off pull-up)
+    pinMode(_dataPin, INPUT);     // Pin mode = input, pull-up resistor off
+  }
+#endif
+}
+
 // sets the state of the SDI-12 object.
 void SDI12::setState(SDI12_STATES state) {
+  // Nothing to do if the data pin was never set (ie, destroying an unused object)
+  if (_dataPin < 0) return;
+  // not listening until the pin interrupts are back on in SDI12_LISTENING
+  if (_listeningPin == _dataPin) _listeningPin = -1;
+#if defined(SDI12_NOISE_FILTER)
+  _rxSuspended = false;  // any new state ends an edge storm hold off
+  rxUndoMillis = (uint16_t)millis() - 2;  // and nothing from before it can be undone
+#endif
   switch (state) {
     case SDI12_HOLDING: {
-      pinMode(_dataPin, INPUT);     // Turn off the pull-up resistor
-      pinMode(_dataPin, OUTPUT);    // Pin mode = output
-      digitalWrite(_dataPin, LOW);  // Pin state = low - marking
-      setPinInterrupts(false);      // Interrupts disabled on data pin
+#if defined(SDI12_ADAPTIVE_BAUD)
+      rxAddrEdgesLeft = 0;  // no reply to time until a command is sent
+#endif
+      setDataPinMode(OUTPUT);   // Pin mode = output, pin state = low - marking
+      setPinInterrupts(false);  // Interrupts disabled on data pin
       break;
     }
     case SDI12_TRANSMITTING: {
-      pinMode(_dataPin, INPUT);   // Turn off the pull-up resistor
-      pinMode(_dataPin, OUTPUT);  // Pin mode = output
-      setPinInterrupts(false);    // Interrupts disabled on data pin
+#if defined(SDI12_ADAPTIVE_BAUD)
+      rxAddrEdgesLeft = 0;
+#endif
+      setDataPinMode(OUTPUT);   // Pin mode = output, pull-up resistor off
+      setPinInterrupts(false);  // Interrupts disabled on data pin
       break;
     }
     case SDI12_LISTENING: {
-      digitalWrite(_dataPin, LOW);  // Pin state = low (turns off pull-up)
-      pinMode(_dataPin, INPUT);     // Pin mode = input, pull-up resistor off
-      interrupts();                 // Enable general interrupts
-      setPinInterrupts(true);       // Enable Rx interrupts on data pin
+#if defined(SDI12_EXTENDED_TIMESTAMPS) && defined(SDI12_EXTENDED_TIMER)
+      // This is the end of a command (or response); start timing the reply
+      _listenTimestamp   = sdi12timer.SDI12TimerReadExtended();
+      _responseTimestamp = _listenTimestamp;
+      _awaitingResponse  = true;
+#endif
+#if defined(SDI12_ADAPTIVE_BAUD)
+      // Unless a command was just sent, the reply's address isn't known until it comes
+      rxAwaitingAddress = (rxAddrEdgesLeft == 0);
+      rxCRTicks         = 0;
+#endif
+      setDataPinMode(INPUT);   // Pin mode = input, pull-up resistor off
+      _listeningPin = _dataPin;
+      interrupts();            // Enable general interrupts
+      setPinInterrupts(true);  // Enable Rx interrupts on data pin
       rxState = WAITING_FOR_START_BIT;
       break;
     }
     default:  // SDI12_DISABLED or SDI12_ENABLED
     {
-      digitalWrite(_dataPin, LOW);  // Pin state = low (turns off pull-up)
-      pinMode(_dataPin, INPUT);     // Pin mode = input, pull-up resistor off
-      setPinInterrupts(false);      // Interrupts disabled on data pin
+      setDataPinMode(INPUT);    // Pin mode = input, pull-up resistor off
+      setPinInterrupts(false);  // Interrupts disabled on data pin
       break;
     }
   }
@@ -404,10 +1114,10 @@ void SDI12::wakeSensors(int8_t extraWakeTime) {
   // Universal interrupts can be on while the break and marking happen because
   // timings for break and from the recorder are not critical.
   // Interrupts on the pin are disabled for the entire transmitting state
-  digitalWrite(_dataPin, HIGH);         // break is HIGH
+  writeDataPin(HIGH);                   // break is HIGH
   delayMicroseconds(lineBreak_micros);  // Required break of 12 milliseconds (12,000 µs)
   delay(extraWakeTime);                 // allow the sensors to wake
-  digitalWrite(_dataPin, LOW);          // marking is LOW
+  writeDataPin(LOW);                    // marking is LOW
   delayMicroseconds(marking_micros);  // Required marking of 8.33 milliseconds(8,333 µs)
 }
 
@@ -420,10 +1130,9 @@ void SDI12::writeChar(uint8_t outChar) {
 
   sdi12timer_t t0 = READTIME;  // start time
 
-  digitalWrite(
-    _dataPin,
-    HIGH);  // immediately get going on the start bit
-            // this gives us 833µs to calculate parity and position of last high bit
+  writeDataPin(HIGH);  // immediately get going on the start bit
+                       // this gives us 833µs to calculate parity and position of last
+                       // high bit
   currentTxBitNum++;
 
   uint8_t parityBit = parity_even_bit(outChar);  // Calculate the parity bit
@@ -450,9 +1159,9 @@ void SDI12::writeChar(uint8_t outChar) {
   while (currentTxBitNum++ < lastHighBit) {
     bitValue = outChar & 0x01;  // get next bit in the character to send
     if (bitValue) {
-      digitalWrite(_dataPin, LOW);  // set the pin state to LOW for 1's
+      writeDataPin(LOW);  // set the pin state to LOW for 1's
     } else {
-      digitalWrite(_dataPin, HIGH);  // set the pin state to HIGH for 0's
+      writeDataPin(HIGH);  // set the pin state to HIGH for 0's
     }
     // Hold the line for this bit duration
     while ((uint8_t)(READTIME - t0) < txBitWidth) {}
@@ -462,7 +1171,7 @@ void SDI12::writeChar(uint8_t outChar) {
   }
 
   // Set the line low for the all remaining 1's and the stop bit
-  digitalWrite(_dataPin, LOW);
+  writeDataPin(LOW);
 
   interrupts();  // Re-enable universal interrupts as soon as critical timing is past
 
@@ -481,12 +1190,25 @@ size_t SDI12::write(uint8_t byte) {
   return 1;                   // 1 character sent
 }
 
+// The same for a whole buffer, which is used by print(), in a single transmit state
+size_t SDI12::write(const uint8_t* buffer, size_t size) {
+  setState(SDI12_TRANSMITTING);
+  for (size_t i = 0; i < size; i++) {
+    writeChar(buffer[i]);  // write each character, back to back
+  }
+  setState(SDI12_LISTENING);  // listen for reply
+  return size;
+}
+
 // this function sends out the characters of the String cmd, one by one
 void SDI12::sendCommand(String& cmd, int8_t extraWakeTime) {
   wakeSensors(extraWakeTime);  // wake up sensors
   for (int unsigned i = 0; i < cmd.length(); i++) {
     writeChar(cmd[i]);  // write each character
   }
+#if defined(SDI12_ADAPTIVE_BAUD)
+  useCalibration(cmd[0]);  // decode the reply at the addressed sensor's bit rate
+#endif
   setState(SDI12_LISTENING);  // listen for reply
 }
 
@@ -495,6 +1217,22 @@ void SDI12::sendCommand(const char* cmd, int8_t extraWakeTime) {
   for (int unsigned i = 0; i < strlen(cmd); i++) {
     writeChar(cmd[i]);  // write each character
   }
+#if defined(SDI12_ADAPTIVE_BAUD)
+  useCalibration(cmd[0]);  // decode the reply at the addressed sensor's bit rate
+#endif
+  setState(SDI12_LISTENING);  // listen for reply
+}
+
+void SDI12::sendCommandNoBreak(const char* cmd) {
+  setState(SDI12_TRANSMITTING);
+  writeDataPin(LOW);                  // marking is LOW
+  delayMicroseconds(marking_micros);  // 8.33 ms marking before the command
+  for (int unsigned i = 0; i < strlen(cmd); i++) {
+    writeChar(cmd[i]);  // write each character
+  }
+#if defined(SDI12_ADAPTIVE_BAUD)
+  useCalibration(cmd[0]);  // decode the reply at the addressed sensor's bit rate
+#endif
   setState(SDI12_LISTENING);  // listen for reply
 }
 
@@ -504,6 +1242,10 @@ void SDI12::sendCommand(FlashString cmd, int8_t extraWakeTime) {
     // write each character
     writeChar(static_cast<char>(pgm_read_byte((const char*)cmd + i)));
   }
+#if defined(SDI12_ADAPTIVE_BAUD)
+  // decode the reply at the addressed sensor's bit rate
+  useCalibration(static_cast<char>(pgm_read_byte((const char*)cmd)));
+#endif
   setState(SDI12_LISTENING);  // listen for reply
 }
 
@@ -513,7 +1255,7 @@ void SDI12::sendCommand(FlashString cmd, int8_t extraWakeTime) {
 // recorder).
 void SDI12::sendResponse(String& resp) {
   setState(SDI12_TRANSMITTING);       // Get ready to send data to the recorder
-  digitalWrite(_dataPin, LOW);        // marking is LOW
+  writeDataPin(LOW);                  // marking is LOW
   delayMicroseconds(marking_micros);  // 8.33 ms marking before response
   for (int unsigned i = 0; i < resp.length(); i++) {
     writeChar(resp[i]);  // write each character
@@ -523,7 +1265,7 @@ void SDI12::sendResponse(String& resp) {
 
 void SDI12::sendResponse(const char* resp) {
   setState(SDI12_TRANSMITTING);       // Get ready to send data to the recorder
-  digitalWrite(_dataPin, LOW);        // marking is LOW
+  writeDataPin(LOW);                  // marking is LOW
   delayMicroseconds(marking_micros);  // 8.33 ms marking before response
   for (int unsigned i = 0; i < strlen(resp); i++) {
     writeChar(resp[i]);  // write each character
@@ -531,9 +1273,19 @@ void SDI12::sendResponse(const char* resp) {
   setState(SDI12_LISTENING);  // return to listening state
 }
 
+void SDI12::sendResponse(const char* resp, size_t length) {
+  setState(SDI12_TRANSMITTING);       // Get ready to send data to the recorder
+  writeDataPin(LOW);                  // marking is LOW
+  delayMicroseconds(marking_micros);  // 8.33 ms marking before response
+  for (size_t i = 0; i < length; i++) {
+    writeChar(resp[i]);  // write each character
+  }
+  setState(SDI12_LISTENING);  // return to listening state
+}
+
 void SDI12::sendResponse(FlashString resp) {
   setState(SDI12_TRANSMITTING);       // Get ready to send data to the recorder
-  digitalWrite(_dataPin, LOW);        // marking is LOW
+  writeDataPin(LOW);                  // marking is LOW
   delayMicroseconds(marking_micros);  // 8.33 ms marking before response
   for (int unsigned i = 0; i < strlen_P((PGM_P)resp); i++) {
     // write each character
@@ -542,34 +1294,326 @@ void SDI12::sendResponse(FlashString resp) {
   setState(SDI12_LISTENING);  // return to listening state
 }
 
+/* ================ Formatting Values ===============================================*/
+
+static const uint32_t powersOf10[] = {1UL,     10UL,     100UL,     1000UL,
+                                      10000UL, 100000UL, 1000000UL, 10000000UL};
+
+// Digits are found by repeated subtraction, at most 9 for each of 7 digits, instead of
+// by dividing by 10, which AVR processors can only do in software
+uint8_t SDI12::formatDigits(bool negative, uint32_t n, uint8_t decimals, char* out) {
+  char* p = out;
+  *p++    = negative && n != 0 ? '-' : '+';
+  // at least one digit before the decimal point
+  uint8_t digits = decimals + 1;
+  while (digits < 7 && n >= powersOf10[digits]) digits++;
+  for (int8_t i = digits - 1; i >= 0; i--) {
+    if (i + 1 == decimals) *p++ = '.';
+    uint32_t power = powersOf10[i];
+    char     digit = '0';
+    while (n >= power) {
+      n -= power;
+      digit++;
+    }
+    *p++ = digit;
+  }
+  *p = '\0';
+  return p - out;
+}
+
+uint8_t SDI12::formatValue(float value, uint8_t decimals, char* out) {
+  // The value is mantissa * 2^exponent exactly, so it can be scaled and rounded in
+  // integers, without soft float arithmetic or any rounding error
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  bool     negative = bits >> 31;
+  uint32_t mantissa = bits & 0x007FFFFFUL;
+  int16_t  exponent = (bits >> 23) & 0xFF;
+  if (exponent == 0) {
+    exponent = 1;  // subnormal
+  } else {
+    mantissa |= 0x00800000UL;
+  }
+  exponent -= 150;
+  // 10,000,000 or more, infinity and NaN
+  if ((bits & 0x7FFFFFFFUL) >= 0x4B189680UL) {
+    mantissa = 9999999UL;
+    exponent = 0;
+  }
+
+  // at most 7 digits, counting those of the whole part
+  uint32_t whole = exponent >= 0 ? mantissa << exponent
+      : exponent > -32           ? mantissa >> -exponent
+                                 : 0;
+  uint8_t  wholeDigits = 1;
+  while (wholeDigits < 7 && whole >= powersOf10[wholeDigits]) wholeDigits++;
+  if (decimals > 7 - wholeDigits) decimals = 7 - wholeDigits;
+
+  // scale by 10^decimals, then round half up on the bits shifted out
+  uint64_t scaled = (uint64_t)mantissa * powersOf10[decimals];
+  uint32_t n;
+  if (exponent >= 0) {
+    n = scaled << exponent;
+  } else if (exponent < -45) {
+    n = 0;  // scaled is less than 2^44, so less than half of 2^-exponent
+  } else {
+    n = scaled >> -exponent;
+    if ((scaled >> (-exponent - 1)) & 1) n++;
+  }
+  // rounding up can carry into an eighth digit, e.g. 9.9999996 to 10.000000
+  if (n > 9999999UL) {
+    n = 1000000UL;
+    decimals--;
+  }
+  return formatDigits(negative, n, decimals, out);
+}
+
+uint8_t SDI12::formatFixed(int32_t value, uint8_t decimals, char* out) {
+  bool     negative = value < 0;
+  uint32_t n        = negative ? 0UL - (uint32_t)value : (uint32_t)value;
+  if (decimals > 9) decimals = 9;
+  // Drop decimal places until there are at most 7 digits, rounding once at the end
+  // so that a 5 that was itself rounded up doesn't round up again
+  uint32_t divisor = 1;
+  while (decimals > 0 && (decimals > 6 || n / divisor > 9999999UL)) {
+    divisor *= 10;
+    decimals--;
+  }
+  if (divisor > 1) n = n / divisor + (n % divisor >= divisor / 2 ? 1 : 0);
+  if (n > 9999999UL) {
+    if (decimals > 0) {
+      n = 1000000UL;  // only after a carry, from 9999999
+      decimals--;
+    } else {
+      n = 9999999UL;
+    }
+  }
+  return formatDigits(negative, n, decimals, out);
+}
+
 
 /* ================ Interrupt Service Routine =======================================*/
 
 // Passes off responsibility for the interrupt to the active object.
-// On espressif boards (ESP8266 and ESP32), the ISR must be stored in IRAM
-#if defined(ESP32) || defined(ESP8266)
-void ICACHE_RAM_ATTR SDI12::handleInterrupt() {
+// On espressif boards (ESP8266 and ESP32), the ISR and everything it calls must be
+// stored in IRAM
+void SDI12_ISR_ATTR SDI12::handleInterrupt() {
   if (_activeObject) _activeObject->receiveISR();
 }
-#else
-void SDI12::handleInterrupt() {
-  if (_activeObject) _activeObject->receiveISR();
+
+#if defined(SDI12_INPUT_CAPTURE) && defined(SDI12_ICP_PIN_REG)
+// Passes the hardware-latched time of an edge on the input capture pin to the decoder
+void SDI12::handleInputCapture() {
+  // time of this data transition, latched by the timer - no ISR latency!
+  uint16_t capturedTCNT = SDI12_ICP_ICR;
+  // and how long ago that was, for the extended timestamp
+  uint16_t captureAge = SDI12_ICP_TCNT - capturedTCNT;
+  // the edge we were waiting for tells us the level the line changed to
+  uint8_t pinLevel = (SDI12_ICP_TCCRB & _BV(SDI12_ICP_ICES)) ? HIGH : LOW;
+  // wait for the opposite edge next
+  SDI12_ICP_TCCRB ^= _BV(SDI12_ICP_ICES);
+  // changing the edge can set a false capture flag
+  SDI12_ICP_TIFR = _BV(SDI12_ICP_ICF);
+  receiveTransition((sdi12timer_t)capturedTCNT, pinLevel, captureAge);
+  // If the line already changed back before the edge was flipped, that change could
+  // not be captured.  Decode it with the live timer and wait for the next edge again.
+  if (((SDI12_ICP_PIN_REG & _BV(SDI12_ICP_PIN_BIT)) ? HIGH : LOW) != pinLevel) {
+    sdi12timer_t thisBitTCNT = (sdi12timer_t)SDI12_ICP_TCNT;
+    SDI12_ICP_TCCRB ^= _BV(SDI12_ICP_ICES);
+    SDI12_ICP_TIFR = _BV(SDI12_ICP_ICF);
+    receiveTransition(thisBitTCNT, pinLevel == HIGH ? LOW : HIGH);
+  }
+}
+#endif
+
+#if defined(SDI12_OVERSAMPLE) && defined(TICKS_PER_SAMPLE_Q8)
+// Samples the data pin and schedules the next sample
+void SDI12::handleSampleTimer() {
+  // Schedule the next sample relative to this one's compare time, not to whenever this
+  // ISR got to run, so latency doesn't add up.  The fractional ticks are carried over.
+  uint16_t nextTicks_Q8 = rxSampleTicks_Q8 + TICKS_PER_SAMPLE_Q8;
+  OCR2A += (uint8_t)(nextTicks_Q8 >> 8);
+  rxSampleTicks_Q8 = (uint8_t)nextTicks_Q8;
+  if (_activeObject) receiveSample(_activeObject->readDataPin());
+}
+
+// Builds characters from 4 samples per bit
+void SDI12::receiveSample(uint8_t pinLevel) {
+  if (rxState == WAITING_FOR_START_BIT) {
+    // Inverse logic start bit = HIGH; this sample is within 1/4 bit of its leading edge
+    if (pinLevel == LOW) { return; }
+    startChar();
+    rxSamplePhase = 0;
+    rxSampleVotes = 0;
+    return;
+  }
+
+  // The first sample of each bit is the one nearest the edge, so it doesn't get a vote
+  if (++rxSamplePhase > 3) {
+    rxSamplePhase = 0;
+    return;
+  }
+  if (pinLevel == HIGH) rxSampleVotes++;
+
+  if (rxState == 9) {
+    // The stop bit is decided after only 2 samples, so that we are already waiting
+    // when the start bit of the next character arrives from a sensor that is running a
+    // bit fast.  It must not be HIGH (spacing) for both; if it is this was a framing
+    // error and the character is dropped.
+    if (rxSamplePhase < 2) return;
+    if (rxSampleVotes < 2) charToBuffer(rxValue & 0x7F);  // Throw away the parity bit
+    rxState = WAITING_FOR_START_BIT;
+    return;
+  }
+  if (rxSamplePhase < 3) return;
+
+  // All 3 votes are in
+  bool spacing  = (rxSampleVotes > 1);  // majority HIGH = 0 (inverse logic)
+  rxSampleVotes = 0;
+
+  if (rxState == 0) {
+    // Not really a start bit if it didn't last - just a glitch
+    rxState = spacing ? 1 : WAITING_FOR_START_BIT;
+  } else {
+    // 7 data bits and the parity bit, lsb first
+    if (!spacing) rxValue |= rxMask;  // LOW = 1 (inverse logic)
+    rxMask = rxMask << 1;
+    rxState++;
+  }
 }
 #endif
 
 // Creates a blank slate of bits for an incoming character
-void SDI12::startChar() {
+void SDI12_ISR_ATTR SDI12::startChar() {
   rxState = 0x00;  // 0b00000000, got a start bit
   rxMask  = 0x01;  // 0b00000001, bit mask, lsb first
   rxValue = 0x00;  // 0b00000000, RX character to be, a blank slate
+#if defined(SDI12_EXTENDED_TIMESTAMPS) && defined(SDI12_EXTENDED_TIMER)
+  rxCharTimestamp = sdi12timer.SDI12TimerReadExtended();
+#endif
 }  // startChar
 
 // The actual interrupt service routine
-void SDI12::receiveISR() {
+void SDI12_ISR_ATTR SDI12::receiveISR() {
   // time of this data transition (plus ISR latency)
   sdi12timer_t thisBitTCNT = READTIME;
 
-  uint8_t pinLevel = digitalRead(_dataPin);  // current RX data level
+  uint8_t pinLevel = readDataPin();  // current RX data level
+
+  receiveTransition(thisBitTCNT, pinLevel);
+}
+
+// Decodes a change in the line state into the character being built
+void SDI12_ISR_ATTR SDI12::receiveTransition(sdi12timer_t thisBitTCNT, uint8_t pinLevel,
+                                             uint16_t edgeAge) {
+#if defined(SDI12_EXTENDED_TIMESTAMPS) && defined(SDI12_EXTENDED_TIMER)
+  // an edge latched by the capture unit happened edgeAge ticks before now
+  uint32_t thisEdgeTimestamp = sdi12timer.SDI12TimerReadExtended() - edgeAge;
+#else
+  (void)edgeAge;
+#endif
+#if defined(SDI12_NOISE_FILTER)
+#if defined(ESP32) || defined(ESP8266)
+  // The pin interrupt can't be detached from here, because that code isn't in IRAM, so
+  // the changes are just ignored until the hold off is over
+  if (_rxSuspended) return;
+#endif
+  // Count this change against the most that 1200 baud could make in the window
+  uint16_t nowMillis = (uint16_t)millis();
+  if ((uint16_t)(nowMillis - rxEdgeWindowStart) >= SDI12_EDGE_STORM_WINDOW_MS) {
+    rxEdgeWindowStart = nowMillis;
+    rxEdgeCount       = 0;
+  }
+  if (++rxEdgeCount > SDI12_EDGE_STORM_MAX_EDGES) {
+    // This is noise, not data.  Stop listening for a while so it can't starve the
+    // main program; the character being built is garbage.
+#if !defined(ESP32) && !defined(ESP8266)
+    if (_activeObject) _activeObject->setPinInterrupts(false);
+#endif
+    _rxSuspended       = true;
+    _rxSuspendedMillis = millis();
+    _edgeStormCount++;
+    rxState = WAITING_FOR_START_BIT;
+    return;
+  }
+  // A change this soon after the last decoded one means the pulse between them was
+  // too short to be a bit.  Only look if that change was in the last couple of
+  // milliseconds, so that the 8-bit timer can't have wrapped in between.
+  if ((uint16_t)(nowMillis - rxUndoMillis) < 2 &&
+      (uint8_t)(thisBitTCNT - prevBitTCNT) < rxGlitchTicks) {
+    rxUndoMillis = nowMillis - 2;  // there's nothing left to undo
+    _glitchCount++;
+    if (_rxBufferTail != rxUndoTail &&
+        loadIndexAcquire(_rxBufferHead) == _rxBufferTail) {
+      // That change finished a character and it's already been read, so it can't be
+      // taken back.  Keep it, and don't let the decoder finish it a second time.
+      rxState = WAITING_FOR_START_BIT;
+      return;
+    }
+    // Put everything back the way it was before that change, including taking back
+    // a character it finished
+    rxState     = rxUndoState;
+    rxMask      = rxUndoMask;
+    rxValue     = rxUndoValue;
+    prevBitTCNT = rxUndoTCNT;
+#if defined(SDI12_EXTENDED_TIMESTAMPS) && defined(SDI12_EXTENDED_TIMER)
+    rxEdgeTimestamp = rxUndoEdgeTimestamp;
+#endif
+#if defined(SDI12_LINE_QUEUE)
+    storeIndexRelease(_rxLineTail, rxUndoLineTail);
+#endif
+    storeIndexRelease(_rxBufferTail, rxUndoTail);
+#if defined(SDI12_ADDRESS_FILTER) && defined(SDI12_BREAK_DETECT) && \
+  defined(SDI12_EXTENDED_TIMER)
+    rxFilterFirst = rxUndoFilterFirst;
+    rxFilterDrop  = rxUndoFilterDrop;
+#endif
+    return;
+  }
+  // Save the state in case this change turns out to be the start of a glitch.  A LOW
+  // while waiting for a start bit isn't decoded, so there's nothing to save.
+  if (rxState != WAITING_FOR_START_BIT || pinLevel == HIGH) {
+    rxUndoState  = rxState;
+    rxUndoMask   = rxMask;
+    rxUndoValue  = rxValue;
+    rxUndoTCNT   = prevBitTCNT;
+    rxUndoTail   = _rxBufferTail;
+#if defined(SDI12_LINE_QUEUE)
+    rxUndoLineTail = _rxLineTail;
+#endif
+    rxUndoMillis = nowMillis;
+#if defined(SDI12_EXTENDED_TIMESTAMPS) && defined(SDI12_EXTENDED_TIMER)
+    rxUndoEdgeTimestamp = rxEdgeTimestamp;
+#endif
+#if defined(SDI12_ADDRESS_FILTER) && defined(SDI12_BREAK_DETECT) && \
+  defined(SDI12_EXTENDED_TIMER)
+    rxUndoFilterFirst = rxFilterFirst;
+    rxUndoFilterDrop  = rxFilterDrop;
+#endif
+  }
+#endif
+
+#if defined(SDI12_BREAK_DETECT) && defined(SDI12_EXTENDED_TIMER)
+  // The line has been spacing for longer than any character could keep it: that was a
+  // break, not data.  Throw away the character it started and note where the
+  // transaction after it begins.
+  if (pinLevel == LOW &&
+      thisEdgeTimestamp - rxEdgeTimestamp >= (uint32_t)SDI12_BREAK_BITS * TICKS_PER_BIT) {
+    rxState         = WAITING_FOR_START_BIT;
+    prevBitTCNT     = thisBitTCNT;
+    rxEdgeTimestamp = thisEdgeTimestamp;
+    _breakTimestamp = thisEdgeTimestamp;
+    _rxBreakTail    = _rxBufferTail;
+    storeIndexRelease(_breakCount, _breakCount + 1);
+#if defined(SDI12_ADDRESS_FILTER) && defined(SDI12_BREAK_DETECT) && \
+  defined(SDI12_EXTENDED_TIMER)
+    rxFilterFirst = true;
+    rxFilterDrop  = false;
+#endif
+    if (_breakCallback) _breakCallback();
+    return;
+  }
+#endif
 
   // Check if we're ready for a start bit, and if this could possibly be it.
   if (rxState == WAITING_FOR_START_BIT) {
@@ -587,6 +1631,14 @@ void SDI12::receiveISR() {
 
     // Check how many bit times have passed since the last change
     uint16_t rxBits = bitTimes((uint8_t)(thisBitTCNT - prevBitTCNT));
+#if defined(SDI12_EXTENDED_TIMESTAMPS) && defined(SDI12_EXTENDED_TIMER)
+    // The 8-bit timer (plus the fudge factor in bitTimes()) can't tell a gap longer
+    // than it takes to roll over from a short one, but the extended timer can.  A gap
+    // that long ends any character.
+    if (thisEdgeTimestamp - rxEdgeTimestamp > (uint8_t)(0xFF - rxWindowWidth)) {
+      rxBits = 0xFF;
+    }
+#endif
     // Calculate how many *data+parity* bits should be left in the current character
     //      - Each character has a total of 10 bits, 1 start bit, 7 data bits, 1 parity
     // bit, and 1 stop bit
@@ -662,6 +1714,13 @@ void SDI12::receiveISR() {
     if (rxState > 7) {
       rxValue &= 0x7F;        // Throw away the parity bit (and with 0b01111111)
       charToBuffer(rxValue);  // Put the finished character into the buffer
+#if defined(SDI12_ADAPTIVE_BAUD)
+      // Time the character from its start bit to the last change in it; that is this
+      // change unless this is the start of the next character
+      calibrateBitRate(rxValue, (uint8_t)(((pinLevel == LOW) || !nextCharStarted)
+                                            ? thisBitTCNT - rxCharStartTCNT
+                                            : prevBitTCNT - rxCharStartTCNT));
+#endif
 
 
       // if this is LOW, or we haven't exceeded the number of bits in a
@@ -678,17 +1737,360 @@ void SDI12::receiveISR() {
     }
   }
   prevBitTCNT = thisBitTCNT;  // finally remember time stamp of this change!
+#if defined(SDI12_ADAPTIVE_BAUD)
+  if (rxState == 0) rxCharStartTCNT = thisBitTCNT;  // this was a start bit
+  if (rxAddrEdgesLeft) timeAddressEdge(thisBitTCNT);
+#endif
+#if defined(SDI12_EXTENDED_TIMESTAMPS) && defined(SDI12_EXTENDED_TIMER)
+  rxEdgeTimestamp = thisEdgeTimestamp;
+#endif
+}
+
+// The functions below that read or change more of what the ISR uses than it could see
+// in one go turn the interrupts off around it with these, and then put them back the
+// way they were rather than turning them on, so that they can be called with
+// interrupts off or from an ISR.
+#if defined(__AVR__)
+typedef uint8_t sdi12irq_t;
+static inline sdi12irq_t interruptsOff() {
+  uint8_t oldSREG = SREG;
+  cli();
+  return oldSREG;
+}
+static inline void restoreInterrupts(sdi12irq_t oldSREG) {
+  SREG = oldSREG;
+}
+#elif defined(ARDUINO_ARCH_SAMD)
+typedef uint32_t sdi12irq_t;
+static inline sdi12irq_t interruptsOff() {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  return primask;
+}
+static inline void restoreInterrupts(sdi12irq_t primask) {
+  __set_PRIMASK(primask);
+}
+#elif defined(ESP8266)
+typedef uint32_t sdi12irq_t;
+static inline sdi12irq_t interruptsOff() {
+  return xt_rsil(15);  // gives the old processor state
+}
+static inline void restoreInterrupts(sdi12irq_t oldPS) {
+  xt_wsr_ps(oldPS);
+}
+#else
+// ESP32: this masks the interrupts of this core, the one the pin ISR was attached on
+typedef UBaseType_t sdi12irq_t;
+static inline sdi12irq_t interruptsOff() {
+  return portSET_INTERRUPT_MASK_FROM_ISR();
+}
+static inline void restoreInterrupts(sdi12irq_t oldMask) {
+  portCLEAR_INTERRUPT_MASK_FROM_ISR(oldMask);
+}
+#endif
+
+#if defined(SDI12_EXTENDED_TIMESTAMPS) && defined(SDI12_EXTENDED_TIMER)
+uint32_t SDI12::getTimestamp() {
+  return sdi12timer.SDI12TimerReadExtended();
 }
 
+// The timestamps are 32 bits, so the ISR must not change them half way through the
+// read.  Like SDI12TimerReadExtended(), this puts the interrupt state back the way it
+// was rather than turning interrupts on, so it can be called with them off or from an
+// ISR.
+static inline uint32_t readTimestamp(const uint32_t& timestamp) {
+#if defined(__AVR__)
+  uint8_t oldSREG = SREG;
+  cli();
+  uint32_t value = timestamp;
+  SREG           = oldSREG;
+#elif defined(ARDUINO_ARCH_SAMD)
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  uint32_t value = timestamp;
+  __set_PRIMASK(primask);
+#else
+  // A 32-bit load is a single instruction on the espressif cores
+  uint32_t value = __atomic_load_n(&timestamp, __ATOMIC_RELAXED);
+#endif
+  return value;
+}
+
+uint32_t SDI12::getListenTimestamp() {
+  return readTimestamp(_listenTimestamp);
+}
+
+uint32_t SDI12::getResponseTimestamp() {
+  return readTimestamp(_responseTimestamp);
+}
+
+uint32_t SDI12::getLastEdgeTimestamp() {
+  return readTimestamp(rxEdgeTimestamp);
+}
+
+uint32_t SDI12::ticksToMicros(uint32_t ticks) {
+  return ticks * MICROS_PER_TICK;
+}
+#endif
+
+#if defined(SDI12_BREAK_DETECT) && defined(SDI12_EXTENDED_TIMER)
+// moves the head up to where the transaction after the last break starts
+bool SDI12::takeBreak() {
+  uint8_t count = loadIndexAcquire(_breakCount);
+  if (count == _breakCountSeen) return false;
+  // The break tail and count are written by the ISR; read until they match
+  uint8_t breakTail;
+  do {
+    count     = loadIndexAcquire(_breakCount);
+    breakTail = loadIndexAcquire(_rxBreakTail);
+  } while (count != loadIndexAcquire(_breakCount));
+  _breakCountSeen = count;
+
+  // Only move forward; what has been read since the break stays read
+  uint8_t head    = _rxBufferHead;
+  uint8_t tail    = loadIndexAcquire(_rxBufferTail);
+  uint8_t waiting = (tail + SDI12_BUFFER_SIZE - head) % SDI12_BUFFER_SIZE;
+  uint8_t stale   = (breakTail + SDI12_BUFFER_SIZE - head) % SDI12_BUFFER_SIZE;
+  if (stale <= waiting) storeIndexRelease(_rxBufferHead, breakTail);
+  _bufferOverflow = false;
+  _lineLength     = 0;
+  return true;
+}
+
+uint32_t SDI12::getBreakTimestamp() {
+  return readTimestamp(_breakTimestamp);
+}
+
+// The callback is called from the receive ISR, so it must never see the pointer half
+// written, and interrupts must stay the way they were if this is called from it
+void SDI12::setBreakCallback(void (*callback)(void)) {
+#if defined(__AVR__)
+  uint8_t oldSREG = SREG;
+  cli();
+  _breakCallback = callback;
+  SREG           = oldSREG;
+#else
+  // A pointer is stored in a single instruction on the 32-bit cores
+  __atomic_store_n(&_breakCallback, callback, __ATOMIC_RELAXED);
+#endif
+}
+#endif
+
+#if defined(SDI12_ADDRESS_FILTER) && defined(SDI12_BREAK_DETECT) && \
+  defined(SDI12_EXTENDED_TIMER)
+// Sets the addresses whose commands and responses the receive ISR keeps
+void SDI12::setAddressFilter(const char* addresses) {
+  uint8_t filter[sizeof(_addressFilter)] = {0};
+  filter[('?' - '0') >> 3] |= 1 << (('?' - '0') & 7);  // the address query is for all
+  for (const char* a = addresses; a && *a; a++) {
+    uint8_t i = *a - '0';
+    if (i < sizeof(filter) * 8) filter[i >> 3] |= 1 << (i & 7);
+  }
+  sdi12irq_t oldState = interruptsOff();
+  memcpy(_addressFilter, filter, sizeof(filter));
+  // Turning the filter on part way through something, drop it rather than guess
+  if (addresses && !_addressFilterOn) {
+    rxFilterFirst = false;
+    rxFilterDrop  = true;
+  }
+  _addressFilterOn = addresses != NULL;
+  restoreInterrupts(oldState);
+}
+#endif
+
+#if defined(SDI12_NOISE_FILTER)
+// Sets the shortest pulse that will be taken as a bit
+void SDI12::setGlitchFilter(uint8_t percentOfBit) {
+  rxGlitchTicks = (uint8_t)(((uint16_t)TICKS_PER_BIT * percentOfBit) / 100);
+}
+
+// The counts are 16 bits, so the ISR must not change them half way through the read
+uint16_t SDI12::getGlitchCount() {
+  sdi12irq_t oldState = interruptsOff();
+  uint16_t   count    = _glitchCount;
+  restoreInterrupts(oldState);
+  return count;
+}
+
+uint16_t SDI12::getEdgeStormCount() {
+  sdi12irq_t oldState = interruptsOff();
+  uint16_t   count    = _edgeStormCount;
+  restoreInterrupts(oldState);
+  return count;
+}
+
+void SDI12::clearNoiseCounts() {
+  sdi12irq_t oldState = interruptsOff();
+  _glitchCount        = 0;
+  _edgeStormCount     = 0;
+  restoreInterrupts(oldState);
+}
+
+// Listens again once the edge storm hold off is over
+void SDI12::resumeAfterEdgeStorm() {
+  if (millis() - _rxSuspendedMillis < SDI12_EDGE_STORM_HOLDOFF_MS) return;
+  _rxSuspended = false;
+  if (_activeObject) {
+    rxState     = WAITING_FOR_START_BIT;
+    rxEdgeCount = 0;
+    _activeObject->setPinInterrupts(true);
+  }
+}
+#endif
+
+#if defined(SDI12_ADAPTIVE_BAUD)
+// Measures the bit rate of a response from the CR and LF at its end
+void SDI12_ISR_ATTR SDI12::calibrateBitRate(uint8_t c, uint8_t ticks) {
+  // The first character of a response is the address of the sensor sending it
+  if (rxAwaitingAddress) {
+    rxResponseAddress = c;
+    rxAwaitingAddress = false;
+  }
+  if (c == '\r') {
+    // A CR is 8 bits from the start bit to its last change, the start of the parity
+    // bit.  Keep it for the LF that should follow.
+    rxCRTicks = ticks;
+    return;
+  }
+  if (c == '\n' && rxCRTicks) {
+    // A LF is 9 bits from the start bit to the start of the stop bit, so the CR and
+    // LF together are 17 bits
+    uint16_t totalTicks = rxCRTicks + ticks;
+    storeBitRate(((uint16_t)(17 << 10) + totalTicks / 2) / totalTicks);
+  }
+  rxCRTicks = 0;
+}
+
+// Measures the bit rate from the address at the start of a reply
+void SDI12_ISR_ATTR SDI12::timeAddressEdge(sdi12timer_t thisBitTCNT) {
+  if (--rxAddrEdgesLeft) return;
+  // This is the last change in the address character, rxAddrBits after its start bit.
+  // Nothing depends on the address having been decoded right, so this works even for a
+  // sensor too far off for the nominal bit rate.
+  uint8_t ticks = (uint8_t)(thisBitTCNT - rxCharStartTCNT);
+  if (ticks) storeBitRate(((uint16_t)(rxAddrBits << 10) + ticks / 2) / ticks);
+}
+
+// Remembers a measured bit rate for the sensor sending the current response
+void SDI12_ISR_ATTR SDI12::storeBitRate(uint16_t measured_Q10) {
+  // Anything more than 1/8 off isn't a sensor running fast or slow, it's a misread
+  if (measured_Q10 < bitsPerTick_Q10 - bitsPerTick_Q10 / 8 ||
+      measured_Q10 > bitsPerTick_Q10 + bitsPerTick_Q10 / 8) {
+    return;
+  }
+  // Find this sensor's slot, or take the oldest one
+  uint8_t slot = 0;
+  while (slot < SDI12_CALIBRATION_SLOTS && rxCalAddress[slot] != rxResponseAddress) {
+    slot++;
+  }
+  if (slot == SDI12_CALIBRATION_SLOTS) {
+    slot                       = rxCalNext;
+    rxCalNext                  = (rxCalNext + 1) % SDI12_CALIBRATION_SLOTS;
+    rxCalAddress[slot]         = rxResponseAddress;
+    rxCalBitsPerTick_Q10[slot] = (uint8_t)measured_Q10;
+  } else {
+    // Average with what we had to smooth out the ISR latency
+    rxCalBitsPerTick_Q10[slot] =
+      (uint8_t)((rxCalBitsPerTick_Q10[slot] + measured_Q10 + 1) / 2);
+  }
+  rxBitsPerTick_Q10 = rxCalBitsPerTick_Q10[slot];
+}
+
+// Loads the bit rate measured for a sensor, or the nominal one if there isn't one, and
+// works out where the last change in its address will be
+void SDI12::useCalibration(char address) {
+  rxBitsPerTick_Q10 = bitsPerTick_Q10;
+  for (uint8_t slot = 0; slot < SDI12_CALIBRATION_SLOTS; slot++) {
+    if (rxCalAddress[slot] == address) rxBitsPerTick_Q10 = rxCalBitsPerTick_Q10[slot];
+  }
+  rxResponseAddress = address;
+  // The reply starts with the address.  Walk its frame - the HIGH start bit, 7 data
+  // bits and even parity bit (inverse logic), and the LOW stop bit - counting changes.
+  uint8_t frame     = (address & 0x7F) | (parity_even_bit(address & 0x7F) << 7);
+  uint8_t lastLevel = HIGH;
+  rxAddrEdgesLeft   = 1;  // the start bit
+  for (uint8_t bit = 1; bit < 10; bit++) {
+    uint8_t level = (bit < 9 && !(frame & (1 << (bit - 1)))) ? HIGH : LOW;
+    if (level != lastLevel) {
+      rxAddrEdgesLeft++;
+      rxAddrBits = bit;
+      lastLevel  = level;
+    }
+  }
+}
+
+uint8_t SDI12::getBitsPerTick_Q10(char address) {
+  uint8_t    bitsPerTick = bitsPerTick_Q10;
+  sdi12irq_t oldState    = interruptsOff();
+  for (uint8_t slot = 0; slot < SDI12_CALIBRATION_SLOTS; slot++) {
+    if (rxCalAddress[slot] == address) bitsPerTick = rxCalBitsPerTick_Q10[slot];
+  }
+  restoreInterrupts(oldState);
+  return bitsPerTick;
+}
+
+void SDI12::clearCalibration() {
+  sdi12irq_t oldState = interruptsOff();
+  for (uint8_t slot = 0; slot < SDI12_CALIBRATION_SLOTS; slot++) {
+    rxCalAddress[slot] = 0;
+  }
+  rxCalNext         = 0;
+  rxBitsPerTick_Q10 = bitsPerTick_Q10;
+  restoreInterrupts(oldState);
+}
+#endif
+
 // Put a new character in the buffer
-void SDI12::charToBuffer(uint8_t c) {
+void SDI12_ISR_ATTR SDI12::charToBuffer(uint8_t c) {
+#if defined(SDI12_EXTENDED_TIMESTAMPS) && defined(SDI12_EXTENDED_TIMER)
+  if (_awaitingResponse) {
+    _responseTimestamp = rxCharTimestamp;
+    _awaitingResponse  = false;
+  }
+#endif
+#if defined(SDI12_ADDRESS_FILTER) && defined(SDI12_BREAK_DETECT) && \
+  defined(SDI12_EXTENDED_TIMER)
+  if (_addressFilterOn) {
+    // The first character after a break, '!' or LF is the address of what follows
+    if (rxFilterFirst) {
+      uint8_t i    = c - '0';
+      rxFilterDrop = i >= sizeof(_addressFilter) * 8 ||
+        !(_addressFilter[i >> 3] & (1 << (i & 7)));
+    }
+    rxFilterFirst = c == '!' || c == '\n';
+    if (rxFilterDrop) return;
+  }
+#endif
   // Check for a buffer overflow. If not, proceed.
-  if ((_rxBufferTail + 1) % SDI12_BUFFER_SIZE == _rxBufferHead) {
+  uint8_t tail = _rxBufferTail;
+  uint8_t next = (tail + 1) % SDI12_BUFFER_SIZE;
+  if (next == loadIndexAcquire(_rxBufferHead)) {
     _bufferOverflow = true;
   } else {
-    // Save the character, advance buffer tail.
-    _rxBuffer[_rxBufferTail] = c;
-    _rxBufferTail            = (_rxBufferTail + 1) % SDI12_BUFFER_SIZE;
+    // Save the character, then advance buffer tail to publish it
+    _rxBuffer[tail] = c;
+    storeIndexRelease(_rxBufferTail, next);
+#if defined(SDI12_SLEEP_WAIT) && defined(ESP32)
+    // Wake a task waiting in waitAvailable()
+    if (_waitingTask) {
+      BaseType_t woken = pdFALSE;
+      vTaskNotifyGiveFromISR(_waitingTask, &woken);
+      if (woken) portYIELD_FROM_ISR();
+    }
+#endif
+#if defined(SDI12_LINE_QUEUE)
+    // Note where the line ends, after the character it ends with is in the buffer
+    if (c == (uint8_t)_lineTerminator) {
+      uint8_t lineTail = _rxLineTail;
+      uint8_t nextLine = (lineTail + 1) % SDI12_LINE_QUEUE_SIZE;
+      if (nextLine == loadIndexAcquire(_rxLineHead)) {
+        storeIndexRelease(_rxLineDrops, _rxLineDrops + 1);
+      } else {
+        _rxLineEnds[lineTail] = next;
+        storeIndexRelease(_rxLineTail, nextLine);
+      }
+    }
+#endif
   }
 }
 
@@ -728,4 +2130,30 @@ ISR(PCINT3_vect) {
 
 #endif  // SDI12_EXTERNAL_PCINT
 
+#if defined(SDI12_OVERSAMPLE) && defined(TICKS_PER_SAMPLE_Q8)
+ISR(TIMER2_COMPA_vect) {
+  SDI12::handleSampleTimer();
+}
+#endif
+
+#if defined(SDI12_INPUT_CAPTURE) && defined(SDI12_ICP_PIN_REG)
+ISR(SDI12_ICP_vect) {
+  SDI12::handleInputCapture();
+}
+#endif
+
+#if defined(SDI12_EXTENDED_TIMESTAMPS) && defined(SDI12_EXTENDED_TIMER)
+ISR(TIMER2_OVF_vect) {
+  SDI12Timer::SDI12TimerOverflow();
+}
+#endif
+
 #endif  // __AVR__
+
+#if defined(ARDUINO_ARCH_SAMD) && defined(SDI12_EXTENDED_TIMESTAMPS) && \
+  defined(SDI12_EXTENDED_TIMER)
+// Counts the overflows of the SDI-12 timer for the extended timer
+void TC3_Handler(void) {
+  SDI12Timer::SDI12TimerOverflow();
+}
+#endif
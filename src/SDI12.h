@@ -161,6 +161,71 @@ typedef const __FlashStringHelper* FlashString;
 #define SDI12_BUFFER_SIZE 81
 #endif
 
+#ifndef SDI12_READ_CHUNK_SIZE
+/**
+ * @brief The number of characters readStringUntil() copies out of the buffer at a time.
+ * The chunk is on the stack.
+ */
+#define SDI12_READ_CHUNK_SIZE 16
+#endif
+
+#ifndef SDI12_LINE_QUEUE_SIZE
+/**
+ * @brief The number of line ends the receive ISR can queue (`SDI12_LINE_QUEUE`).  One
+ * less than this many complete lines can be waiting in the buffer before the queue has
+ * to fall back to searching the buffer.  Each takes 1 byte.
+ */
+#define SDI12_LINE_QUEUE_SIZE 8
+#endif
+
+#ifndef SDI12_CALIBRATION_SLOTS
+/**
+ * @brief The number of sensors whose bit rate is remembered by the adaptive bit rate
+ * calibration (`SDI12_ADAPTIVE_BAUD`).  Each takes 2 bytes.
+ */
+#define SDI12_CALIBRATION_SLOTS 4
+#endif
+
+#ifndef SDI12_EDGE_STORM_WINDOW_MS
+/**
+ * @brief The length of the window, in milliseconds, over which data line changes are
+ * counted for the edge storm limit of the noise filter (`SDI12_NOISE_FILTER`).
+ */
+#define SDI12_EDGE_STORM_WINDOW_MS 10
+#endif
+
+#ifndef SDI12_EDGE_STORM_MAX_EDGES
+/**
+ * @brief The most data line changes allowed in one #SDI12_EDGE_STORM_WINDOW_MS window
+ * before the noise filter decides the line is noise and stops listening.
+ *
+ * At 1200 baud there can be no more than one change per bit, so 12 in 10ms.  The
+ * default allows about twice that, so that a few glitches in a response don't stop
+ * reception; an EMI burst makes hundreds.
+ */
+#define SDI12_EDGE_STORM_MAX_EDGES 25
+#endif
+
+#ifndef SDI12_EDGE_STORM_HOLDOFF_MS
+/**
+ * @brief How long, in milliseconds, the data pin interrupts stay off after an edge
+ * storm before listening again.
+ */
+#define SDI12_EDGE_STORM_HOLDOFF_MS 50
+#endif
+
+#ifndef SDI12_BREAK_BITS
+/**
+ * @brief The shortest time, in bit times, the data line must be spacing (HIGH) to be
+ * taken as a break by `SDI12_BREAK_DETECT`.
+ *
+ * No character can keep the line spacing for more than 9 bits (7.5 ms), and a break is
+ * at least 12 ms; the standard says a sensor must not take less than 6.5 ms as a
+ * break.  The default, 11 bits, is 9.2 ms.
+ */
+#define SDI12_BREAK_BITS 11
+#endif
+
 #if defined(ESP32) || defined(ESP8266)
 /**
  * @brief This enumeration provides the lookahead options for parseInt(), parseFloat().
@@ -198,6 +263,48 @@ enum LookaheadMode {
 #define READTIME TCNTX
 #endif  // defined(ESP32) || defined(ESP8266)
 
+/**
+ * @brief A view of one line in the SDI-12 Rx buffer, without copying it out.
+ *
+ * The Rx buffer is circular, so a line can be split in two where the buffer wraps.  The
+ * characters of the line are `first[0]` to `first[firstLength - 1]` followed by
+ * `second[0]` to `second[secondLength - 1]`; secondLength is 0 unless the line wraps.
+ * Neither part is null terminated.
+ *
+ * The view points into the Rx buffer.  It is valid until SDI12::consume() (or
+ * anything else that reads from the buffer) is called.
+ *
+ * @see SDI12::peekLine()
+ */
+struct SDI12Line {
+  /** @brief The first part of the line */
+  const char* first;
+  /** @brief The number of characters in the first part of the line */
+  uint8_t firstLength;
+  /** @brief The part of the line wrapped around to the start of the buffer, if any */
+  const char* second;
+  /** @brief The number of characters in the wrapped part of the line */
+  uint8_t secondLength;
+
+  /**
+   * @brief Get the number of characters in the line
+   *
+   * @return **uint8_t** The length of the line, not counting the <CR><LF>
+   */
+  uint8_t length() const {
+    return firstLength + secondLength;
+  }
+  /**
+   * @brief Get a character of the line
+   *
+   * @param i The position of the character, from 0 to length() - 1
+   * @return **char** The character
+   */
+  char operator[](uint8_t i) const {
+    return i < firstLength ? first[i] : second[i - firstLength];
+  }
+};
+
 /**
  * @brief The main class for SDI 12 instances
  */
@@ -214,6 +321,16 @@ class SDI12 : public Stream {
    * @brief static pointer to active SDI12 instance
    */
   static SDI12* _activeObject;
+  /**
+   * @brief The data pin of the instance in the SDI12_LISTENING state, or -1 if none is.
+   *
+   * SDI12Bus::handleInterrupt() checks this against its own pin instead of going
+   * through _activeObject, so it never decodes the bus's own transmissions, nor a
+   * change on its pin while another instance has the receiver.  A state change only
+   * clears it for the instance's own pin, so ending or destroying an instance on
+   * another pin doesn't stop this one.
+   */
+  static volatile int8_t _listeningPin;
   /**
    * @brief The SDI12Timer instance to use for checking bit reception times.
    */
@@ -273,7 +390,222 @@ class SDI12 : public Stream {
    * @brief the value of the character being built
    */
   static uint8_t rxValue;
+#if defined(SDI12_OVERSAMPLE) && defined(TICKS_PER_SAMPLE_Q8)
+  /**
+   * @brief The position of the latest sample within the current bit (0-3) for the
+   * oversampling receiver
+   */
+  static uint8_t rxSamplePhase;
+  /**
+   * @brief The number of samples of the current bit that were HIGH (spacing)
+   */
+  static uint8_t rxSampleVotes;
+  /**
+   * @brief The fractional part of the time of the next sample, in ticks shifted by 2^8
+   */
+  static uint8_t rxSampleTicks_Q8;
+#endif
+#if defined(SDI12_ADAPTIVE_BAUD)
+  /**
+   * @brief The number of bits per tick, shifted by 2^10, used by bitTimes(); the
+   * measured value for the sensor being listened to
+   */
+  static uint8_t rxBitsPerTick_Q10;
+  /**
+   * @brief The timer value at the start bit of the character being built
+   */
+  static uint8_t rxCharStartTCNT;
+  /**
+   * @brief The ticks from the start bit to the last change of a CR, if the last
+   * character received was a CR; otherwise 0
+   */
+  static uint8_t rxCRTicks;
+  /**
+   * @brief The number of changes on the data line until the last change in the
+   * address that should start the reply to a command; 0 if not timing one
+   */
+  static uint8_t rxAddrEdgesLeft;
+  /**
+   * @brief The number of bits from the start bit to the last change in that address
+   */
+  static uint8_t rxAddrBits;
+  /**
+   * @brief True until the first character of a response, its address, is received
+   */
+  static bool rxAwaitingAddress;
+  /**
+   * @brief The address of the sensor sending the current response
+   */
+  static char rxResponseAddress;
+  /**
+   * @brief The addresses of the sensors with a measured bit rate
+   */
+  static char rxCalAddress[SDI12_CALIBRATION_SLOTS];
+  /**
+   * @brief The measured bits per tick, shifted by 2^10, of those sensors
+   */
+  static uint8_t rxCalBitsPerTick_Q10[SDI12_CALIBRATION_SLOTS];
+  /**
+   * @brief The calibration slot to give to the next new sensor
+   */
+  static uint8_t rxCalNext;
+#endif
+#if defined(SDI12_NOISE_FILTER)
+  /**
+   * @brief The shortest time between changes, in timer ticks, that can be a real bit;
+   * anything shorter is a glitch
+   */
+  static uint8_t rxGlitchTicks;
+  /**
+   * @brief The #rxState from before the previous change was decoded, to undo a glitch
+   */
+  static uint8_t rxUndoState;
+  /**
+   * @brief The #rxMask from before the previous change was decoded
+   */
+  static uint8_t rxUndoMask;
+  /**
+   * @brief The #rxValue from before the previous change was decoded
+   */
+  static uint8_t rxUndoValue;
+  /**
+   * @brief The #prevBitTCNT from before the previous change was decoded
+   */
+  static uint16_t rxUndoTCNT;
+  /**
+   * @brief The buffer tail from before the previous change was decoded
+   */
+  static uint8_t rxUndoTail;
+#if defined(SDI12_LINE_QUEUE)
+  /**
+   * @brief The line end queue tail from before the previous change was decoded
+   */
+  static uint8_t rxUndoLineTail;
+#endif
+  /**
+   * @brief The low 16 bits of millis() at the previous change; there is nothing to undo
+   * if that was more than a couple of milliseconds ago
+   */
+  static uint16_t rxUndoMillis;
+  /**
+   * @brief The low 16 bits of millis() at the start of the current edge counting window
+   */
+  static uint16_t rxEdgeWindowStart;
+  /**
+   * @brief The number of changes on the data line in the current window
+   */
+  static uint8_t rxEdgeCount;
+  /**
+   * @brief True while the pin interrupts are off because of an edge storm
+   */
+  static volatile bool _rxSuspended;
+  /**
+   * @brief The millis() when the pin interrupts were turned off for an edge storm
+   */
+  static uint32_t _rxSuspendedMillis;
+  /**
+   * @brief The number of glitches thrown away since the counts were last cleared
+   */
+  static volatile uint16_t _glitchCount;
+  /**
+   * @brief The number of edge storms since the counts were last cleared
+   */
+  static volatile uint16_t _edgeStormCount;
+#endif
+#if defined(SDI12_EXTENDED_TIMESTAMPS) && defined(SDI12_EXTENDED_TIMER)
+  /**
+   * @brief The extended timer value at the previous RX transition
+   */
+  static uint32_t rxEdgeTimestamp;
+  /**
+   * @brief The extended timer value at the start bit of the character being built
+   */
+  static uint32_t rxCharTimestamp;
+#if defined(SDI12_NOISE_FILTER)
+  /**
+   * @brief The #rxEdgeTimestamp from before the previous change was decoded
+   */
+  static uint32_t rxUndoEdgeTimestamp;
+#endif
+  /**
+   * @brief The extended timer value when the line last switched to listening
+   */
+  static uint32_t _listenTimestamp;
+  /**
+   * @brief The extended timer value at the start bit of the first character received
+   * since the line last switched to listening
+   */
+  static uint32_t _responseTimestamp;
+  /**
+   * @brief True until a character is received after switching to listening
+   */
+  static volatile bool _awaitingResponse;
+#endif
+#if defined(SDI12_BREAK_DETECT) && defined(SDI12_EXTENDED_TIMER)
+  /**
+   * @brief The number of breaks seen; written only by the receive ISR
+   */
+  static volatile uint8_t _breakCount;
+  /**
+   * @brief The number of breaks already handled by takeBreak()
+   */
+  static uint8_t _breakCountSeen;
+  /**
+   * @brief The buffer tail at the end of the last break, where the characters sent
+   * after it start; written only by the receive ISR
+   */
+  static volatile uint8_t _rxBreakTail;
+  /**
+   * @brief The extended timer value at the end of the last break
+   */
+  static uint32_t _breakTimestamp;
+  /**
+   * @brief Called from the receive ISR at the end of each break
+   */
+  static void (*_breakCallback)(void);
+#endif
+#if defined(SDI12_ADDRESS_FILTER) && defined(SDI12_BREAK_DETECT) && \
+  defined(SDI12_EXTENDED_TIMER)
+  /**
+   * @brief The addresses setAddressFilter() keeps, one bit for each character from '0'
+   * to 'z'
+   */
+  static uint8_t _addressFilter[10];
+  /**
+   * @brief True if setAddressFilter() has turned the filter on
+   */
+  static bool _addressFilterOn;
+  /**
+   * @brief True if the next character received starts a command or response
+   */
+  static bool rxFilterFirst;
+  /**
+   * @brief True if the command or response being received is for another address
+   */
+  static bool rxFilterDrop;
+#if defined(SDI12_NOISE_FILTER)
+  /**
+   * @brief rxFilterFirst from before the previous change, for undoing a glitch
+   */
+  static bool rxUndoFilterFirst;
+  /**
+   * @brief rxFilterDrop from before the previous change
+   */
+  static bool rxUndoFilterDrop;
+#endif
+#endif
 
+  /**
+   * @brief Write a sign and a number of at most 7 digits, with a decimal point before
+   * the last decimals of them; used by formatValue() and formatFixed()
+   *
+   * @param negative True for a '-' sign, unless the number is 0
+   * @param n The number, at most 9999999
+   * @param decimals The number of decimal places, 0-6
+   * @param out Where to write it, null terminated
+   * @return **uint8_t** The number of characters written, not counting the null
+   */
+  static uint8_t formatDigits(bool negative, uint32_t n, uint8_t decimals, char* out);
   /**
    * @brief static method for getting a 16-bit value from the multiplication of 2 8-bit
    * values
@@ -348,8 +680,137 @@ class SDI12 : public Stream {
   static volatile uint8_t _rxBufferHead;
   /**
    * @brief The buffer overflow status
+   *
+   * Like the buffer itself, this is shared by all SDI-12 instances.
+   */
+  static volatile bool _bufferOverflow;
+
+  /**
+   * @brief Read the buffer index written by the other side of the buffer, with acquire
+   * ordering.
+   *
+   * The Rx buffer has a single producer, the receive ISR, which only writes the tail,
+   * and a single consumer, the main program, which only writes the head.  On a dual-core
+   * ESP32, or an ARM core with a write buffer, `volatile` alone doesn't stop the new
+   * index from being seen before the characters it covers.  After an acquire load of
+   * the other side's index every character it covers can be read safely.
+   *
+   * @param index _rxBufferTail in the consumer, _rxBufferHead in the producer
+   * @return **uint8_t** The index
+   */
+  static inline uint8_t SDI12_ISR_ATTR loadIndexAcquire(volatile uint8_t& index) {
+    return __atomic_load_n(&index, __ATOMIC_ACQUIRE);
+  }
+  /**
+   * @brief Publish a new value of this side's buffer index, with release ordering.
+   *
+   * Everything written to (or read from) the buffer before this is finished before the
+   * other side can see the new index.
+   *
+   * @param index _rxBufferTail in the producer, _rxBufferHead in the consumer
+   * @param value The new value of the index
+   */
+  static inline void SDI12_ISR_ATTR storeIndexRelease(volatile uint8_t& index,
+                                                     uint8_t           value) {
+    __atomic_store_n(&index, value, __ATOMIC_RELEASE);
+  }
+  /**
+   * @brief Copy characters out of the Rx buffer, consuming them.
+   *
+   * Everything available, up to length characters or the first terminator, is copied
+   * with at most two memcpy() calls, one on each side of the wrap point, and the head
+   * is moved once.  The terminator is consumed but not copied.
+   *
+   * @param dest The destination
+   * @param length The most characters to copy
+   * @param terminator The character to stop at, or -1 for none
+   * @param terminated Set to whether the terminator was found; may be NULL
+   * @return **size_t** The number of characters copied
    */
-  bool _bufferOverflow = false;
+  static size_t copyFromBuffer(uint8_t* dest, size_t length, int terminator = -1,
+                               bool* terminated = NULL);
+  /**
+   * @brief The buffer head when peekLine() last found a line
+   */
+  static uint8_t _lineHead;
+  /**
+   * @brief The number of characters, including the <CR><LF>, that consume() releases;
+   * 0 if there is no line to release
+   */
+  static uint8_t _lineLength;
+  /**
+   * @brief The character that ends a line; LF for responses, '!' for commands
+   */
+  static char _lineTerminator;
+#if defined(SDI12_LINE_QUEUE)
+  /**
+   * @brief The buffer index just after each line end the receive ISR has put in the
+   * buffer, oldest first.
+   *
+   * This is a second single-producer/single-consumer ring, next to the Rx buffer.  The
+   * receive ISR adds an entry whenever it stores the line terminator, so the reader
+   * can find the end of the next line without searching for it.  Entries the reader
+   * has already read past are dropped by the reader.
+   */
+  static uint8_t _rxLineEnds[SDI12_LINE_QUEUE_SIZE];
+  /**
+   * @brief Index of the oldest line end; only written by the reader
+   */
+  static volatile uint8_t _rxLineHead;
+  /**
+   * @brief Index after the newest line end; only written by the receive ISR
+   */
+  static volatile uint8_t _rxLineTail;
+  /**
+   * @brief The number of line ends that didn't fit in the queue; only written by the
+   * receive ISR
+   */
+  static volatile uint8_t _rxLineDrops;
+  /**
+   * @brief The value of _rxLineDrops the last time the buffer was empty.  While they
+   * differ, lines are found by searching the buffer.
+   */
+  static uint8_t _rxLineDropsSeen;
+  /**
+   * @brief Find the length of the first line in the buffer from the line end queue,
+   * dropping the line ends that have already been read past.
+   *
+   * @param head The buffer head
+   * @param count The number of characters in the buffer
+   * @param lineTail The line end queue tail, loaded before the buffer tail
+   * @param drops _rxLineDrops, loaded before the line end queue tail
+   * @return **uint8_t** The length of the line, including its terminator; 0 if there
+   * is no complete line
+   */
+  static uint8_t queuedLineLength(uint8_t head, uint8_t count, uint8_t lineTail,
+                                  uint8_t drops);
+#endif
+  /**
+   * @brief Find the length of the first line in the buffer by searching for the
+   * terminator.
+   *
+   * @param head The buffer head
+   * @param count The number of characters in the buffer
+   * @return **uint8_t** The length of the line, including its terminator; 0 if there
+   * is no complete line
+   */
+  static uint8_t scanLineLength(uint8_t head, uint8_t count);
+  /**
+   * @brief Sleep until the next interrupt, unless a character has arrived since the
+   * buffer tail was taken.
+   *
+   * Without `SDI12_SLEEP_WAIT` this only calls yield().
+   *
+   * @param seenTail The buffer tail taken before the buffer was last checked
+   * @param maxMillis The most time to sleep, in milliseconds
+   */
+  static void sleepUntilReceive(uint8_t seenTail, uint32_t maxMillis);
+#if defined(SDI12_SLEEP_WAIT) && defined(ESP32)
+  /**
+   * @brief The task waiting in waitAvailable(), for the receive ISR to notify
+   */
+  static TaskHandle_t volatile _waitingTask;
+#endif
   /**@}*/
 
 
@@ -432,8 +893,8 @@ class SDI12 : public Stream {
   /**
    * @brief Clear the Rx buffer by setting the head and tail pointers to the same value.
    *
-   * clearBuffer() is a public function that clears the buffers contents by setting the
-   * index for both head and tail back to zero.
+   * clearBuffer() is a public function that clears the buffers contents by moving the
+   * head up to the tail.  Only the receive ISR ever writes the tail.
    */
   void clearBuffer();
   /**
@@ -453,6 +914,127 @@ class SDI12 : public Stream {
    */
   void flush() override {}
 
+  /**
+   * @brief Read characters into a buffer, waiting up to the stream timeout for each.
+   *
+   * Whatever is already in the Rx buffer is copied in one go, with at most two
+   * memcpy() calls, and the timeout is only checked while the buffer is empty.
+   *
+   * @param buffer The buffer to read into
+   * @param length The number of characters to read
+   * @return **size_t** The number of characters read; less than length on timeout
+   *
+   * @note This function _hides_ the Stream class function, which calls read() for
+   * every character.  On cores where it is virtual it overrides it.
+   */
+  size_t readBytes(char* buffer, size_t length);
+  /** @copydoc SDI12::readBytes(char*, size_t) */
+  size_t readBytes(uint8_t* buffer, size_t length) {
+    return readBytes((char*)buffer, length);
+  }
+  /**
+   * @brief Read characters into a buffer until the terminator, waiting up to the
+   * stream timeout for each.
+   *
+   * The terminator is consumed but is not put in the buffer.  Whatever is already in
+   * the Rx buffer is copied in one go.
+   *
+   * @param terminator The character to stop at
+   * @param buffer The buffer to read into
+   * @param length The most characters to read
+   * @return **size_t** The number of characters read, not counting the terminator
+   *
+   * @note This function _hides_ the Stream class function, which calls read() for
+   * every character.  On cores where it is virtual it overrides it.
+   */
+  size_t readBytesUntil(char terminator, char* buffer, size_t length);
+  /** @copydoc SDI12::readBytesUntil(char, char*, size_t) */
+  size_t readBytesUntil(char terminator, uint8_t* buffer, size_t length) {
+    return readBytesUntil(terminator, (char*)buffer, length);
+  }
+  /**
+   * @brief Read characters into a String until the terminator, waiting up to the
+   * stream timeout for each.
+   *
+   * The terminator is consumed but is not put in the String.  The characters are
+   * added to the String in chunks of up to `SDI12_READ_CHUNK_SIZE`.
+   *
+   * @param terminator The character to stop at
+   * @return **String** The characters read
+   *
+   * @note This function _hides_ the Stream class function, which calls read() for
+   * every character.  On cores where it is virtual it overrides it.
+   */
+  String readStringUntil(char terminator);
+
+  /**
+   * @brief Look at the next complete line in the Rx buffer without copying it.
+   *
+   * Every SDI-12 response ends with <CR><LF>.  If there is a whole line in the buffer,
+   * the view is set to the characters before the <CR><LF> and they stay in the buffer
+   * until consume() is called.  (If the line terminator has been changed with
+   * setLineTerminator(), the line is everything before that character instead.)
+   * Identification, measurement and data responses can be parsed straight out of the
+   * buffer, without a String or any copy.
+   *
+   * @code{.cpp}
+   *     SDI12Line line;
+   *     if (mySDI12.peekLine(line)) {
+   *       char address = line[0];
+   *       // ... parse the rest of the line ...
+   *       mySDI12.consume();
+   *     }
+   * @endcode
+   *
+   * @param line The view to set
+   * @return **bool** True if there was a complete line; if not the view isn't changed
+   */
+  bool peekLine(SDI12Line& line);
+  /**
+   * @brief Release the line seen by the last peekLine(), including its <CR><LF>.
+   *
+   * Does nothing if there was no line, or if the buffer has been read some other way
+   * since.
+   */
+  void consume();
+  /**
+   * @brief Return the number of complete lines in the Rx buffer.
+   *
+   * When the library is built with `SDI12_LINE_QUEUE`, the receive ISR records where
+   * each line ends as it goes, so this and peekLine() don't have to search the buffer.
+   *
+   * @return **int** The number of lines waiting
+   */
+  int availableLines();
+  /**
+   * @brief Set the character that ends a line for peekLine() and availableLines().
+   *
+   * The default is LF, which ends every response from a sensor.  When acting as a
+   * sensor, set it to '!', which ends every command.  This clears the buffer.
+   *
+   * @param terminator The character that ends a line
+   */
+  void setLineTerminator(char terminator);
+  /**
+   * @brief Wait until at least count characters are in the Rx buffer, or the timeout.
+   *
+   * The library's own blocking reads (timedRead(), timedPeek(), parseInt(),
+   * parseFloat(), readBytes(), etc) wait with this, and it can replace loops like
+   * `while (mySDI12.available() < 3 && millis() - start < 1500) {}`.
+   *
+   * When the library is built with `SDI12_SLEEP_WAIT`, the processor sleeps between
+   * checks instead of spinning: idle sleep on AVR, WFI on SAMD - either way the
+   * millis() interrupt wakes it at least once a millisecond - and a FreeRTOS task
+   * notification from the receive ISR on ESP32, which lets other tasks run.
+   * Otherwise it calls yield() between checks.
+   *
+   * @param count The number of characters to wait for
+   * @param timeout The most time to wait, in milliseconds
+   * @return **bool** True if the characters arrived (or the buffer overflowed), false
+   * on timeout
+   */
+  bool waitAvailable(int count, uint32_t timeout);
+
   /**
    * @brief Return the first valid (long) integer value from the current position.
    *
@@ -494,6 +1076,52 @@ class SDI12 : public Stream {
    * @see @ref SDI12::LookaheadMode
    */
   float parseFloat(LookaheadMode lookahead = SKIP_ALL, char ignore = NO_IGNORE_CHAR);
+  /**
+   * @brief Parse the values in the response to a data (aD0!) or continuous
+   * measurement (aR0!) command, straight out of a buffer.
+   *
+   * Values start with their sign, so the text is read as long as it has a '+' or
+   * '-', e.g. "+1.234567-12.5+3", and stops at anything else, such as a CRC.
+   *
+   * On 32-bit (and 64-bit) little-endian processors, such as the ESP32, SAMD and
+   * host builds, each value is checked and converted 8 characters at a time in a
+   * 64-bit word, with the digits combined 4 at a time (8 on 64-bit hosts), instead of
+   * one character at a time; near the end of the text, the last 8 characters are
+   * loaded.  Text shorter than 8 characters, values of more than 8 characters, and all
+   * values on AVR boards, are parsed one character at a time.
+   *
+   * @param text The first value's sign
+   * @param length The number of characters of text
+   * @param values Where to write the values
+   * @param maxValues The most values to write
+   * @return **uint8_t** The number of values in the text; only the first maxValues of
+   * them are written
+   */
+  static uint8_t parseValues(const char* text, size_t length, float* values,
+                             uint8_t maxValues);
+  /**
+   * @brief Parse the values in a response line seen with peekLine().
+   *
+   * The same as parseValues(const char*, size_t, float*, uint8_t), after the address
+   * at the start of the line.  Where the line wraps around the end of the Rx buffer,
+   * the value across the wrap is parsed one character at a time.
+   *
+   * @code{.cpp}
+   *     SDI12Line line;
+   *     float     values[20];
+   *     if (mySDI12.peekLine(line)) {
+   *       uint8_t count = SDI12::parseValues(line, values, 20);
+   *       mySDI12.consume();
+   *     }
+   * @endcode
+   *
+   * @param line The line
+   * @param values Where to write the values
+   * @param maxValues The most values to write
+   * @return **uint8_t** The number of values in the line; only the first maxValues of
+   * them are written
+   */
+  static uint8_t parseValues(const SDI12Line& line, float* values, uint8_t maxValues);
 
  protected:
   /**
@@ -506,6 +1134,22 @@ class SDI12 : public Stream {
    * @return @m_span{m-type} int @m_endspan The next numeric digit in the stream
    */
   int peekNextDigit(LookaheadMode lookahead, bool detectDecimal);
+  /**
+   * @brief Read a character, waiting up to the stream timeout with waitAvailable()
+   *
+   * @return @m_span{m-type} int @m_endspan The character, or -1 on timeout
+   *
+   * @note This function _hides_ the Stream class function, which spins on read().
+   */
+  int timedRead();
+  /**
+   * @brief Peek at a character, waiting up to the stream timeout with waitAvailable()
+   *
+   * @return @m_span{m-type} int @m_endspan The character, or -1 on timeout
+   *
+   * @note This function _hides_ the Stream class function, which spins on peek().
+   */
+  int timedPeek();
   /**@}*/
 
 
@@ -521,6 +1165,58 @@ class SDI12 : public Stream {
    * @brief reference to the data pin
    */
   int8_t _dataPin = -1;
+#if defined(__AVR__)
+  /**
+   * @brief The input register (PINx) of the port the data pin is on
+   */
+  volatile uint8_t* _dataPinInReg = nullptr;
+  /**
+   * @brief The output register (PORTx) of the port the data pin is on
+   */
+  volatile uint8_t* _dataPinOutReg = nullptr;
+  /**
+   * @brief The data direction register (DDRx) of the port the data pin is on
+   */
+  volatile uint8_t* _dataPinModeReg = nullptr;
+  /**
+   * @brief The bit mask of the data pin within its port registers
+   */
+  uint8_t _dataPinMask = 0;
+  /**
+   * @brief The pin change mask register (PCMSKx) for the data pin
+   */
+  volatile uint8_t* _dataPinPCMSK = nullptr;
+  /**
+   * @brief The bit mask of the data pin within its pin change mask register
+   */
+  uint8_t _dataPinPCMSKMask = 0;
+  /**
+   * @brief The bit mask of the data pin's pin change group within PCICR
+   */
+  uint8_t _dataPinPCICRMask = 0;
+#if defined(SDI12_EXTERNAL_PCINT)
+  /**
+   * @brief True for an SDI12Bus, whose pin change interrupt is switched on and off
+   * with the state even though the program defines the ISR.
+   */
+  bool _switchPinChange = false;
+#endif
+  /**
+   * @brief True if the data pin is the input capture pin (ICP1, or ICP4 on a Mega) and
+   * the library was built with `SDI12_INPUT_CAPTURE`, in which case edges are
+   * time-stamped by the timer hardware instead of by the pin change ISR.
+   */
+  bool _dataPinInputCapture = false;
+#elif defined(ARDUINO_ARCH_SAMD)
+  /**
+   * @brief The port group the data pin is on
+   */
+  PortGroup* _dataPinPort = nullptr;
+  /**
+   * @brief The bit mask of the data pin within its port group registers
+   */
+  uint32_t _dataPinMask = 0;
+#endif
 
  public:
   /**
@@ -619,6 +1315,10 @@ class SDI12 : public Stream {
    * @brief Set the data pin for the current SDI-12 instance
    *
    * @param dataPin  The data pin's digital pin number
+   *
+   * On AVR and SAMD boards this also looks up and caches the port registers and bit
+   * mask for the pin so the interrupt and transmit routines can access the pin directly
+   * rather than going through the Arduino core's pin tables on every bit.
    */
   void setDataPin(int8_t dataPin);
   /**@}*/
@@ -783,6 +1483,35 @@ class SDI12 : public Stream {
    * A private helper function to turn pin interupts on or off
    */
   void setPinInterrupts(bool enable);
+  /**
+   * @brief Read the current level of the data pin
+   *
+   * @return @m_span{m-type} uint8_t @m_endspan HIGH or LOW
+   *
+   * On AVR and SAMD boards this reads the cached input register directly; on other
+   * boards it falls back to digitalRead().
+   */
+  uint8_t readDataPin();
+  /**
+   * @brief Set the output level of the data pin
+   *
+   * @param level HIGH or LOW
+   *
+   * On AVR and SAMD boards this writes the cached output register directly; on other
+   * boards it falls back to digitalWrite().
+   */
+  void writeDataPin(uint8_t level);
+  /**
+   * @brief Set the direction of the data pin, always with the pull-up off
+   *
+   * @param mode INPUT or OUTPUT
+   *
+   * An OUTPUT pin is always started LOW (marking) and an INPUT pin never has the
+   * internal pull-up enabled.  This matches the pinMode(INPUT), pinMode(OUTPUT),
+   * digitalWrite(LOW) sequence previously used to change line states, but on AVR and
+   * SAMD boards it is done with two register writes.
+   */
+  void setDataPinMode(uint8_t mode);
   /**
    * @brief Set the the state of the SDI12 object[s]
    *
@@ -891,6 +1620,21 @@ class SDI12 : public Stream {
    * SDI12::sendCommand() or SDI12::sendResponse() functions.
    */
   virtual size_t write(uint8_t byte);
+  /**
+   * @brief Write out a buffer of bytes on the SDI-12 line
+   *
+   * @param buffer The characters to write
+   * @param size The number of characters to write
+   * @return @m_span{m-type} size_t @m_endspan The number of characters written
+   *
+   * Sets the state to transmitting once, writes all of the characters back to back,
+   * and then sets the state back to listening.  Print::print() and the other Print
+   * functions use this for anything longer than one character, so they no longer
+   * change the line state around every character.  Like write(uint8_t), this does not
+   * wake the sensors first; use SDI12::sendCommand() or SDI12::sendResponse() for that.
+   */
+  size_t write(const uint8_t* buffer, size_t size) override;
+  using Print::write;  // keep the other forms of write()
 
   /**
    * @brief Send a command out on the data line, acting as a datalogger (master)
@@ -910,6 +1654,17 @@ class SDI12 : public Stream {
   void sendCommand(const char* cmd, int8_t extraWakeTime = SDI12_WAKE_DELAY);
   /// @copydoc SDI12::sendCommand(String&, int8_t)
   void sendCommand(FlashString cmd, int8_t extraWakeTime = SDI12_WAKE_DELAY);
+  /**
+   * @brief Send a command to sensors that are still awake, without a break
+   *
+   * @param cmd the command to send
+   *
+   * Sensors stay awake for 100 ms of marking after the end of a response, so the
+   * standard only requires a break before a command once the line has been marking
+   * for more than 87 ms.  Up to then, this sends the command after just the 8.33 ms of
+   * marking, which saves the 12 ms break and the marking after it.
+   */
+  void sendCommandNoBreak(const char* cmd);
 
   /**
    * @brief Send a response out on the data line (for slave use)
@@ -925,6 +1680,47 @@ class SDI12 : public Stream {
   void sendResponse(const char* resp);
   /// @copydoc SDI12::sendResponse(String& resp)
   void sendResponse(FlashString resp);
+  /**
+   * @brief Send a response of known length out on the data line (for slave use)
+   *
+   * @param resp the response to send
+   * @param length the number of characters in the response
+   *
+   * The same as sendResponse(const char*), for a response already in a buffer, e.g.
+   * one built by SDI12Sensor.
+   */
+  void sendResponse(const char* resp, size_t length);
+
+  /**
+   * @brief Format a value the way SDI-12 sends it: a sign, at most 7 digits, and a
+   * decimal point if there are decimal places.
+   *
+   * @param value The value
+   * @param decimals The most decimal places, 0-6; values too big for that many get
+   * fewer, so that there are at most 7 digits
+   * @param out Where to write it, null terminated; at least 10 characters
+   * @return @m_span{m-type} uint8_t @m_endspan The number of characters written, not
+   * counting the null
+   *
+   * Nothing is allocated and there is no division or float arithmetic.  The value is
+   * scaled and rounded exactly, from the bits of the float, with ties rounded away from
+   * zero.  Values of 10,000,000 or more, and NaN, are given as +9999999 or -9999999.
+   */
+  static uint8_t formatValue(float value, uint8_t decimals, char* out);
+  /**
+   * @brief Format a fixed-point value the way SDI-12 sends it.
+   *
+   * @param value The value, in units of 10^-decimals, e.g. 12345 with 2 decimals is
+   * 123.45
+   * @param decimals The number of decimal places in value, 0-9; if that makes more
+   * than 7 digits, the value is rounded to fewer
+   * @param out Where to write it, null terminated; at least 10 characters
+   * @return @m_span{m-type} uint8_t @m_endspan The number of characters written, not
+   * counting the null
+   *
+   * This is exact, so sensors that measure in integer units don't need floats at all.
+   */
+  static uint8_t formatFixed(int32_t value, uint8_t decimals, char* out);
   ///@}
 
 
@@ -942,7 +1738,7 @@ class SDI12 : public Stream {
   /**
    * @brief Creates a blank slate for a new incoming character
    */
-  void startChar();
+  static void startChar();
   /**
    * @brief The interrupt service routine (ISR) - the function responding to changes in
    * rx line state.
@@ -956,27 +1752,424 @@ class SDI12 : public Stream {
    * in an ISR that lasts for 8.33ms for each character. [10 bits @ 1200 bits/s] For a
    * person, that 8.33ms is trivial, but for even a "slow" 8MHz processor, that's over
    * 60,000 ticks sitting idle per character.
+   *
+   * The ISR itself only grabs the time and the level of the data pin; the decoding is
+   * done in SDI12::receiveTransition().
    */
   void receiveISR();
+  /**
+   * @brief Decode a single change in the rx line state into the character being built.
+   *
+   * @param thisBitTCNT The timer value at the time of the change
+   * @param pinLevel The level of the data pin after the change, HIGH or LOW
+   * @param edgeAge How many timer ticks ago the change was, for a time latched by the
+   * input capture unit; with `SDI12_EXTENDED_TIMESTAMPS` the edge's extended timestamp
+   * is set back by this much
+   *
+   * All of the decoder state and the buffer are shared by all SDI-12 instances, so this
+   * is static and can be called directly from an ISR that already knows which pin
+   * changed, such as SDI12Bus::handleInterrupt().
+   */
+  static void receiveTransition(sdi12timer_t thisBitTCNT, uint8_t pinLevel,
+                                uint16_t edgeAge = 0);
+#if defined(SDI12_OVERSAMPLE) && defined(TICKS_PER_SAMPLE_Q8)
+  /**
+   * @brief Add one sample of the rx line to the character being built by the
+   * oversampling receiver.
+   *
+   * @param pinLevel The level of the data pin, HIGH or LOW
+   */
+  static void receiveSample(uint8_t pinLevel);
+#endif
   /**
    * @brief Put a finished character into the SDI12 buffer
    *
    * @param c **uint8_t (char)** the character to add to the buffer
    */
-  void charToBuffer(uint8_t c);
+  static void charToBuffer(uint8_t c);
 
  public:
   /**
    * @brief Intermediary used by the ISR - passes off responsibility for the interrupt
    * to the active object.
    *
-   * On espressif boards (ESP8266 and ESP32), the ISR must be stored in IRAM
+   * On espressif boards (ESP8266 and ESP32), the ISR and everything it calls must be
+   * stored in IRAM; see SDI12_ISR_ATTR.
    */
   static void handleInterrupt();
 
+#if defined(SDI12_OVERSAMPLE) && defined(TICKS_PER_SAMPLE_Q8)
+  /**
+   * @brief The handler for the sampling timer interrupt of the oversampling receiver.
+   *
+   * When the library is built with `SDI12_OVERSAMPLE`, the data pin is not watched for
+   * changes at all.  Instead a compare match on the SDI-12 timer interrupts at 4x the
+   * baud rate, the whole time the line is listening, and each interrupt samples the
+   * pin once.  This works on any pin, whether or not it has a pin change interrupt, and
+   * the processor load is fixed no matter how noisy the line is.  Each bit is decided
+   * by a majority vote of the 3 samples after the one nearest its leading edge, and
+   * characters without a valid stop bit are dropped.
+   */
+  static void handleSampleTimer();
+#endif
+
+#if defined(SDI12_ADAPTIVE_BAUD)
+  /**
+   * @brief Get the bit rate measured for a sensor.
+   *
+   * @param address The sensor address
+   * @return @m_span{m-type} uint8_t @m_endspan The number of bits per timer tick,
+   * shifted by 2^10, measured for that sensor; #BITS_PER_TICK_Q10 if it hasn't been
+   * measured.
+   *
+   * When the library is built with `SDI12_ADAPTIVE_BAUD`, the receiver measures the
+   * real bit rate of each sensor from the parts of its responses with a known bit
+   * pattern: the address that starts the reply to a command (timed by counting line
+   * changes, so it works even before the address can be decoded) and the CR and LF at
+   * the end of every response.  The rate is remembered for
+   * up to #SDI12_CALIBRATION_SLOTS sensor addresses, and the reply to each command is
+   * decoded at the rate measured for the sensor it is addressed to.  Cheap sensor
+   * oscillators that are a few percent off then no longer eat into the timing window.
+   * Measurements more than 1/8 off the nominal rate are ignored.
+   */
+  static uint8_t getBitsPerTick_Q10(char address);
+  /**
+   * @brief Forget all of the measured sensor bit rates.
+   */
+  static void clearCalibration();
+
+ private:
+  /**
+   * @brief Use the timing of a received character to measure the bit rate.
+   *
+   * @param c The character received
+   * @param ticks The timer ticks from its start bit to the last change in it
+   */
+  static void calibrateBitRate(uint8_t c, uint8_t ticks);
+  /**
+   * @brief Count a change on the data line towards the last change in the address that
+   * should start the reply, and measure the bit rate from it when it comes.
+   *
+   * @param thisBitTCNT The timer value at the time of the change
+   */
+  static void timeAddressEdge(sdi12timer_t thisBitTCNT);
+  /**
+   * @brief Remember a measured bit rate for the sensor sending the current response,
+   * and decode the rest of the response at that rate.
+   *
+   * @param measured_Q10 The measured number of bits per tick, shifted by 2^10
+   */
+  static void storeBitRate(uint16_t measured_Q10);
+  /**
+   * @brief Decode at the bit rate measured for a sensor, and get ready to time the
+   * address at the start of its reply.
+   *
+   * @param address The address of the sensor
+   */
+  static void useCalibration(char address);
+
+ public:
+#endif
+
+#if defined(SDI12_EXTENDED_TIMESTAMPS) && defined(SDI12_EXTENDED_TIMER)
+  /**
+   * @brief Get the current value of the extended SDI-12 timer.
+   *
+   * @return @m_span{m-type} uint32_t @m_endspan The current time in timer ticks.
+   *
+   * When the library is built with `SDI12_EXTENDED_TIMESTAMPS`, the timer used for the
+   * bit timing is extended to 32 bits by counting its overflows (or, on espressif
+   * boards, by using the 64-bit microsecond timer).  These timestamps don't roll over
+   * every 256 ticks like the timer itself, so they can measure the gaps between
+   * characters and the time a sensor takes to reply.  Subtract two of them to get the
+   * time between, and use ticksToMicros() to convert it.
+   *
+   * This and the other timestamp functions leave the interrupt state as they found it,
+   * so they are safe to call from an ISR.
+   */
+  static uint32_t getTimestamp();
+  /**
+   * @brief Get the time the line last switched to listening.
+   *
+   * @return @m_span{m-type} uint32_t @m_endspan The extended timer value when the line
+   * last switched to listening, which is right after the end of each command or
+   * response sent.
+   */
+  static uint32_t getListenTimestamp();
+  /**
+   * @brief Get the time the reply started.
+   *
+   * @return @m_span{m-type} uint32_t @m_endspan The extended timer value at the start
+   * bit of the first character received since the line last switched to listening.
+   * This is the same as getListenTimestamp() until a character is received.
+   *
+   * The sensor's response latency is
+   * `ticksToMicros(getResponseTimestamp() - getListenTimestamp())`.
+   */
+  static uint32_t getResponseTimestamp();
+  /**
+   * @brief Get the time of the most recent change on the data line.
+   *
+   * @return @m_span{m-type} uint32_t @m_endspan The extended timer value at the last
+   * change decoded.  Compare with getTimestamp() to see how long the line has been
+   * quiet.
+   */
+  static uint32_t getLastEdgeTimestamp();
+  /**
+   * @brief Convert a number of extended timer ticks to microseconds.
+   *
+   * @param ticks The number of ticks, usually the difference between two timestamps
+   * @return @m_span{m-type} uint32_t @m_endspan The time in microseconds
+   */
+  static uint32_t ticksToMicros(uint32_t ticks);
+#endif
+
+#if defined(SDI12_BREAK_DETECT) && defined(SDI12_EXTENDED_TIMER)
+  /**
+   * @brief Check for a break, and drop everything received before it.
+   *
+   * @return @m_span{m-type} bool @m_endspan True once for each break (or run of breaks)
+   * since the last call.
+   *
+   * When the library is built with `SDI12_BREAK_DETECT` (which needs
+   * `SDI12_EXTENDED_TIMESTAMPS`), the receive ISR takes a spacing (HIGH) longer than
+   * #SDI12_BREAK_BITS as a break: it throws away the character being decoded, instead
+   * of putting the break into the buffer as garbage, and notes where the transaction
+   * after it starts.  A recorder sends a break before each new transaction, so anything
+   * received before it, like an unanswered or half received command, is stale;
+   * takeBreak() drops it.  Characters that have been read already are not affected.
+   */
+  bool takeBreak();
+  /**
+   * @brief Get the time the last break ended.
+   *
+   * @return @m_span{m-type} uint32_t @m_endspan The extended timer value at the end of
+   * the last break.  The command starts after 8.33 ms of marking.
+   *
+   * Like the other timestamp functions, this is safe to call from an ISR, including
+   * the break callback.
+   */
+  static uint32_t getBreakTimestamp();
+  /**
+   * @brief Set a function to call at the end of each break.
+   *
+   * @param callback The function; NULL for none.
+   *
+   * The function is called from the receive ISR, so it must be short, and on espressif
+   * boards it must be in IRAM (`IRAM_ATTR`).  A sensor that sleeps between transactions
+   * can use it to start waking up as soon as the bus does, with the pin interrupt
+   * itself as the wake source.
+   */
+  static void setBreakCallback(void (*callback)(void));
+#endif
+
+#if defined(SDI12_ADDRESS_FILTER) && defined(SDI12_BREAK_DETECT) && \
+  defined(SDI12_EXTENDED_TIMER)
+  /**
+   * @brief Only keep the commands and responses for some addresses.
+   *
+   * @param addresses The addresses to keep, e.g. "5" or "0123"; NULL to turn the
+   * filter off and keep everything.
+   *
+   * A sensor hears every command on the bus, and every other sensor's response.  With
+   * the filter on, the receive ISR checks the first character after each break, '!'
+   * and LF, which is the address of the command or response that follows, and doesn't
+   * put anything into the buffer until the next one unless the address is in the
+   * filter or is '?'.  The recorder may leave out the break between commands, so the
+   * '!' and LF count as well.  This needs `SDI12_ADDRESS_FILTER` and
+   * `SDI12_BREAK_DETECT`, since otherwise each break is read as a garbage character
+   * in front of the address.
+   */
+  static void setAddressFilter(const char* addresses);
+#endif
+
+#if defined(SDI12_NOISE_FILTER)
+  /**
+   * @brief Set the shortest pulse on the data line that will be taken as a bit.
+   *
+   * @param percentOfBit The shortest pulse, in percent of a bit width.  0 turns the
+   * glitch filter off.  The default is 25.
+   *
+   * When the library is built with `SDI12_NOISE_FILTER`, a change that comes sooner
+   * than this after the previous change means the pulse between them was a glitch.
+   * Both changes are thrown away and the character being built is put back to where it
+   * was before the first one.  Real changes are a whole bit apart, so keep this well
+   * under 100.
+   */
+  static void setGlitchFilter(uint8_t percentOfBit);
+  /**
+   * @brief Get the number of glitches the noise filter has thrown away.
+   *
+   * @return @m_span{m-type} uint16_t @m_endspan The number of glitches since the
+   * counts were last cleared.
+   */
+  static uint16_t getGlitchCount();
+  /**
+   * @brief Get the number of edge storms the noise filter has stopped.
+   *
+   * @return @m_span{m-type} uint16_t @m_endspan The number of edge storms since the
+   * counts were last cleared.
+   *
+   * When there are more than #SDI12_EDGE_STORM_MAX_EDGES changes on the data line in
+   * #SDI12_EDGE_STORM_WINDOW_MS, faster than 1200 baud could possibly make them, the
+   * data pin interrupts are turned off so the noise can't starve the main program.
+   * They are turned back on by the first available(), peek() or read() after
+   * #SDI12_EDGE_STORM_HOLDOFF_MS, or by any change of the line state.
+   */
+  static uint16_t getEdgeStormCount();
+  /**
+   * @brief Reset the glitch and edge storm counts to zero.
+   */
+  static void clearNoiseCounts();
+
+ private:
+  /**
+   * @brief Turn the data pin interrupts back on once an edge storm hold off is over.
+   */
+  static void resumeAfterEdgeStorm();
+
+ public:
+#endif
+
+#if defined(SDI12_INPUT_CAPTURE) && defined(SDI12_ICP_PIN_REG)
+  /**
+   * @brief The handler for the input capture interrupt.
+   *
+   * When the library is built with `SDI12_INPUT_CAPTURE` and the data pin is the input
+   * capture pin (ICP1, digital pin 8 on an Uno; ICP4, digital pin 49, on a Mega), the
+   * timer hardware latches the time of each edge on the pin.  The decoder is then given
+   * the latched time rather than the time the ISR got around to reading the timer, so
+   * latency from other interrupts (Timer0 millis, UART, etc) no longer eats into the bit
+   * timing window.  After each edge the capture edge is flipped to catch the next
+   * change.  With `SDI12_EXTENDED_TIMESTAMPS` the edge's extended timestamp is also
+   * taken back to the latched time.
+   */
+  static void handleInputCapture();
+#endif
+
   /** on AVR boards, uncomment to use your own PCINT ISRs */
   // #define SDI12_EXTERNAL_PCINT
+  /**
+   * on ATmega168/328P, 1280/2560 and 644/1284 boards, uncomment to time-stamp edges
+   * with a timer's input capture unit when the data pin is its capture pin (ICP1, or
+   * ICP4 on a Mega)
+   */
+  // #define SDI12_INPUT_CAPTURE
+  /**
+   * on ATmega168/328P, 1280/2560 and 644/1284 boards, uncomment to receive by sampling
+   * the data pin from a timer interrupt instead of with pin change interrupts
+   */
+  // #define SDI12_OVERSAMPLE
+  /**
+   * uncomment to throw away glitches shorter than a fraction of a bit and to stop
+   * listening for a while when the line changes faster than 1200 baud allows
+   */
+  // #define SDI12_NOISE_FILTER
+  /**
+   * on ATmega168/328P, 1280/2560, 644/1284, SAMD21 and espressif boards, uncomment to
+   * keep 32-bit timestamps of the data line
+   */
+  // #define SDI12_EXTENDED_TIMESTAMPS
+  /**
+   * uncomment to measure the bit rate of each sensor from its responses and decode
+   * its replies at that rate
+   */
+  // #define SDI12_ADAPTIVE_BAUD
+  /**
+   * on espressif boards, uncomment to time the data line with the CPU cycle counter
+   * instead of micros(); the CPU frequency must not be changed while it is in use
+   */
+  // #define SDI12_ESP_CYCLE_COUNTER
+  /**
+   * uncomment to have the receive ISR keep a queue of where each line in the buffer
+   * ends, for peekLine() and availableLines()
+   */
+  // #define SDI12_LINE_QUEUE
+  /**
+   * on AVR, SAMD and ESP32 boards, uncomment to sleep the processor instead of spinning
+   * while waiting for characters
+   */
+  // #define SDI12_SLEEP_WAIT
+  /**
+   * with `SDI12_EXTENDED_TIMESTAMPS`, uncomment to recognize the break before each
+   * transaction in the receive ISR, see takeBreak()
+   */
+  // #define SDI12_BREAK_DETECT
+  /**
+   * with `SDI12_BREAK_DETECT`, uncomment to drop the commands and responses for other
+   * addresses in the receive ISR, see setAddressFilter()
+   */
+  // #define SDI12_ADDRESS_FILTER
   /**@}*/
+
+  template <int8_t dataPin>
+  friend class SDI12Bus;
+};
+
+
+/**
+ * @brief An SDI-12 instance for a data pin that is known at compile time.
+ *
+ * @tparam dataPin The data pin's digital pin number
+ *
+ * SDI12Bus behaves exactly like an SDI12 instance created with the same pin; all of the
+ * communication functions are inherited.  The difference is in the interrupt handler.
+ * On boards where the Arduino core's pin map is fixed (see SDI12_FIXED_PIN_MAP in
+ * SDI12_boards.h), SDI12Bus::handleInterrupt() reads the data pin from a port register
+ * and bit resolved by the compiler - a single bit test instruction - and passes the
+ * change straight to the decoder without going through the active object pointer.  On
+ * other boards it is the same as SDI12::handleInterrupt().
+ *
+ * To get the benefit on AVR boards, define `SDI12_EXTERNAL_PCINT` and call the static
+ * handler from the pin change ISR for the data pin.  SDI12Bus still turns the data
+ * pin's bits in PCMSKx and PCICR on when it starts listening and off while it is
+ * holding or transmitting, as SDI12 does without `SDI12_EXTERNAL_PCINT`; only the ISR
+ * itself comes from the program:
+ *
+ * @code{.cpp}
+ *     SDI12Bus<7> mySDI12;
+ *
+ *     ISR(PCINT2_vect) {
+ *       SDI12Bus<7>::handleInterrupt();
+ *     }
+ * @endcode
+ *
+ * Don't enable the pin change interrupt for the data pin some other way, e.g. with a
+ * pin change library, or leave other pins in the same group enabled with changes the
+ * handler would be called for; the handler ignores changes unless the bus is
+ * listening, but each call still costs the ISR's time.
+ *
+ * Other SDI12 or SDI12Bus instances on other pins can be used alongside it, one at a
+ * time as always; the fixed-pin handler only decodes while this bus is the instance
+ * that is listening.  The TimingBenchmark tool times both receive handlers on a board.
+ */
+template <int8_t dataPin>
+class SDI12Bus : public SDI12 {
+ public:
+  /**
+   * @brief Construct a new SDI12Bus instance on the templated data pin.
+   */
+  SDI12Bus() : SDI12(dataPin) {
+#if defined(__AVR__) && defined(SDI12_EXTERNAL_PCINT)
+    _switchPinChange = true;
+#endif
+  }
+
+  /**
+   * @brief The interrupt handler for changes on the templated data pin.
+   *
+   * Changes while the bus isn't listening, e.g. its own transmissions or while another
+   * instance is listening, are ignored.
+   */
+  static void SDI12_ISR_ATTR handleInterrupt() {
+#if defined(SDI12_FIXED_PIN_MAP)
+    if (_listeningPin != dataPin) return;
+    sdi12timer_t thisBitTCNT = READTIME;  // time of this data transition
+    receiveTransition(thisBitTCNT, SDI12FixedPin<dataPin>::read());
+#else
+    SDI12::handleInterrupt();
+#endif
+  }
 };
 
 #endif  // SRC_SDI12_H_
@@ -0,0 +1,166 @@
+/**
+ * @file SDI12Arbiter.cpp
+ * @copyright (c) 2013-2020 Stroud Water Research Center (SWRC)
+ *                          and the EnviroDIY Development Team
+ *            This library is published under the BSD-3 license.
+ *
+ * @brief This file implements the SDI12Arbiter class, which shares one SDI-12 bus
+ * between several threads or FreeRTOS tasks.
+ */
+
+/* ======================== Arduino SDI-12 =================================
+An Arduino library for SDI-12 communication with a wide variety of environmental
+sensors. This library provides a general software solution, without requiring
+   ======================== Arduino SDI-12 =================================*/
+
+#include "SDI12Arbiter.h"
+
+#if defined(SDI12_ARBITER_AVAILABLE)
+
+#include <chrono>  // std::chrono::milliseconds
+
+SDI12Arbiter::SDI12Arbiter(SDI12& bus) : _bus(bus) {}
+
+// queues a transaction, behind everything at least as urgent
+bool SDI12Arbiter::submit(SDI12Transaction& transaction) {
+  if (transaction.command == nullptr) return false;
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_stopping || _queued >= SDI12_ARBITER_QUEUE_SIZE) return false;
+  if (transaction.status == SDI12_TRANSACTION_PENDING) return false;
+  uint8_t i = _queued;
+  while (i > 0 && _queue[i - 1]->priority > transaction.priority) {
+    _queue[i] = _queue[i - 1];
+    i--;
+  }
+  _queue[i]          = &transaction;
+  transaction.status = SDI12_TRANSACTION_PENDING;
+  _queued++;
+  _submitted.notify_one();
+  return true;
+}
+
+bool SDI12Arbiter::wait(SDI12Transaction& transaction) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _completed.wait(lock,
+                  [&] { return transaction.status != SDI12_TRANSACTION_PENDING; });
+  return transaction.status == SDI12_TRANSACTION_DONE;
+}
+
+bool SDI12Arbiter::transact(SDI12Transaction& transaction) {
+  if (!submit(transaction)) return false;
+  return wait(transaction);
+}
+
+// takes the most urgent transaction off the queue and runs it
+bool SDI12Arbiter::processNext(uint32_t waitMillis) {
+  SDI12Transaction* transaction;
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_submitted.wait_for(lock, std::chrono::milliseconds(waitMillis),
+                             [&] { return _queued > 0 || _stopping; }) ||
+        _queued == 0 || _stopping) {
+      return false;
+    }
+    transaction = _queue[0];
+    _queued--;
+    for (uint8_t i = 0; i < _queued; i++) { _queue[i] = _queue[i + 1]; }
+  }
+
+  // The bus is only touched from here, so it doesn't need the lock
+  bool awake = _haveActivity && (now() - _lastActivity < SDI12_ARBITER_AWAKE_MS);
+  sendCommand(transaction->command, !awake, transaction->extraWakeTime);
+  bool ok = readResponse(*transaction);
+  // Even without a response the sensors are awake from the command, but not for long
+  // enough to count on
+  _haveActivity = ok;
+  _lastActivity = now();
+
+  // Once the status is set a thread in wait() may let the transaction go, so the
+  // callback runs first
+  if (transaction->callback) transaction->callback(*transaction, transaction->context);
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    transaction->status = ok ? SDI12_TRANSACTION_DONE : SDI12_TRANSACTION_TIMEOUT;
+  }
+  _completed.notify_all();
+  return true;
+}
+
+void SDI12Arbiter::run() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopping = false;
+  }
+  while (true) {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (_stopping) break;
+    }
+    processNext(1000);
+  }
+
+  // Nothing will run what is still waiting; let whoever is waiting for it go
+  SDI12Transaction* cancelled[SDI12_ARBITER_QUEUE_SIZE];
+  uint8_t           count;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    count   = _queued;
+    _queued = 0;
+    for (uint8_t i = 0; i < count; i++) { cancelled[i] = _queue[i]; }
+  }
+  for (uint8_t i = 0; i < count; i++) {
+    cancelled[i]->response[0] = '\0';
+    if (cancelled[i]->callback) {
+      cancelled[i]->callback(*cancelled[i], cancelled[i]->context);
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    cancelled[i]->status = SDI12_TRANSACTION_CANCELLED;
+  }
+  _completed.notify_all();
+}
+
+void SDI12Arbiter::stop() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _stopping = true;
+  _submitted.notify_all();
+}
+
+uint8_t SDI12Arbiter::pending() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _queued;
+}
+
+void SDI12Arbiter::sendCommand(const char* command, bool wake, int8_t extraWakeTime) {
+  _bus.clearBuffer();  // anything left over isn't the response to this
+  if (wake) {
+    _bus.sendCommand(command, extraWakeTime);
+  } else {
+    _bus.sendCommandNoBreak(command);
+  }
+}
+
+bool SDI12Arbiter::readResponse(SDI12Transaction& transaction) {
+  uint32_t  start = now();
+  SDI12Line line;
+  while (!_bus.peekLine(line)) {
+    uint32_t waited = now() - start;
+    if (waited >= transaction.timeout) {
+      transaction.response[0] = '\0';
+      return false;
+    }
+    int available = _bus.available();
+    _bus.waitAvailable(available < 0 ? 1 : available + 1, transaction.timeout - waited);
+  }
+  uint8_t length = line.length();
+  memcpy(transaction.response, line.first, line.firstLength);
+  memcpy(transaction.response + line.firstLength, line.second, line.secondLength);
+  transaction.response[length] = '\0';
+  _bus.consume();
+  return true;
+}
+
+uint32_t SDI12Arbiter::now() {
+  return millis();
+}
+
+#endif  // SDI12_ARBITER_AVAILABLE
@@ -0,0 +1,244 @@
+/**
+ * @file SDI12Arbiter.h
+ * @copyright (c) 2013-2020 Stroud Water Research Center (SWRC)
+ *                          and the EnviroDIY Development Team
+ *            This library is published under the BSD-3 license.
+ *
+ * @brief This file contains the SDI12Arbiter class, which shares one SDI-12 bus
+ * between several threads or FreeRTOS tasks.
+ *
+ * The arbiter is only built where the C++ threading library is available: on ESP32
+ * boards, and on a host (non-Arduino) build of the library.
+ */
+
+/* ======================== Arduino SDI-12 =================================
+An Arduino library for SDI-12 communication with a wide variety of environmental
+sensors. This library provides a general software solution, without requiring
+   ======================== Arduino SDI-12 =================================*/
+
+#ifndef SRC_SDI12_ARBITER_H_
+#define SRC_SDI12_ARBITER_H_
+
+#include "SDI12.h"
+
+#if defined(ESP32) || !defined(ARDUINO)
+/**
+ * @brief Defined when the SDI12Arbiter class is available
+ */
+#define SDI12_ARBITER_AVAILABLE
+
+#include <mutex>               // std::mutex
+#include <condition_variable>  // std::condition_variable
+
+#ifndef SDI12_ARBITER_QUEUE_SIZE
+/**
+ * @brief The number of transactions that can be waiting for the bus at once.
+ */
+#define SDI12_ARBITER_QUEUE_SIZE 8
+#endif
+
+#ifndef SDI12_ARBITER_AWAKE_MS
+/**
+ * @brief How long after the end of the last response the sensors are still awake, in
+ * milliseconds.
+ *
+ * A break is required once the line has been marking for more than 87 ms; this leaves
+ * room for the 8.33 ms marking before the command.
+ */
+#define SDI12_ARBITER_AWAKE_MS 75
+#endif
+
+/**
+ * @brief The transaction priorities; a lower number is more urgent.
+ */
+typedef enum SDI12Priority : uint8_t {
+  /** Go ahead of everything else waiting */
+  SDI12_PRIORITY_URGENT = 0,
+  /** The default */
+  SDI12_PRIORITY_NORMAL = 1,
+  /** Routine polling; only goes once nothing else is waiting */
+  SDI12_PRIORITY_ROUTINE = 2
+} SDI12Priority;
+
+/**
+ * @brief The status of a transaction.
+ */
+typedef enum SDI12TransactionStatus : uint8_t {
+  /** Not submitted, or not started */
+  SDI12_TRANSACTION_IDLE = 0,
+  /** Waiting in the queue or on the wire */
+  SDI12_TRANSACTION_PENDING,
+  /** The response is in SDI12Transaction::response */
+  SDI12_TRANSACTION_DONE,
+  /** No complete response came before the timeout */
+  SDI12_TRANSACTION_TIMEOUT,
+  /** Still waiting when the arbiter was stopped, so never sent */
+  SDI12_TRANSACTION_CANCELLED
+} SDI12TransactionStatus;
+
+/**
+ * @brief One command and its response.
+ *
+ * The transaction is owned by the caller and must stay alive, unchanged, until it is
+ * completed.
+ */
+struct SDI12Transaction {
+  /** @brief The command to send, e.g. "3M!"; must stay alive until completed */
+  const char* command = nullptr;
+  /** @brief The priority of the transaction */
+  SDI12Priority priority = SDI12_PRIORITY_NORMAL;
+  /** @brief How long to wait for the response line, in milliseconds */
+  uint16_t timeout = 250;
+  /** @brief Extra time to wait after the break, if one is sent */
+  int8_t extraWakeTime = SDI12_WAKE_DELAY;
+  /**
+   * @brief Called by the thread running the bus when the transaction completes, just
+   * before its status is set; may be nullptr
+   */
+  void (*callback)(SDI12Transaction& transaction, void* context) = nullptr;
+  /** @brief Passed to the callback */
+  void* context = nullptr;
+  /** @brief The response line, without the <CR><LF>, null terminated */
+  char response[SDI12_BUFFER_SIZE] = {0};
+  /** @brief The status of the transaction */
+  volatile SDI12TransactionStatus status = SDI12_TRANSACTION_IDLE;
+};
+
+/**
+ * @brief Shares one SDI-12 bus between several threads or FreeRTOS tasks.
+ *
+ * Any thread can submit() a transaction, a command and the response to it, or run one
+ * with transact() and wait for it.  One thread runs the bus with run() (or calls
+ * processNext() itself) and puts the transactions on the wire one at a time, most
+ * urgent first and in the order they were submitted within a priority.  While the
+ * sensors are still awake from the last response, the next command is sent without a
+ * new break.
+ *
+ * @code{.cpp}
+ *     SDI12        mySDI12(DATA_PIN);
+ *     SDI12Arbiter arbiter(mySDI12);
+ *
+ *     void busTask(void*) { arbiter.run(); }
+ *     // in setup(): xTaskCreate(busTask, "sdi12", 4096, NULL, 5, NULL);
+ *
+ *     // in any other task:
+ *     SDI12Transaction t;
+ *     t.command  = "0D0!";
+ *     t.priority = SDI12_PRIORITY_URGENT;
+ *     if (arbiter.transact(t)) Serial.println(t.response);
+ * @endcode
+ */
+class SDI12Arbiter {
+ public:
+  /**
+   * @brief Construct a new SDI12Arbiter for a bus
+   *
+   * @param bus The SDI-12 bus; it must already be started with begin().  Nothing else
+   * may use it while the arbiter is running.
+   */
+  explicit SDI12Arbiter(SDI12& bus);
+  /**
+   * @brief Destroy the SDI12Arbiter
+   */
+  virtual ~SDI12Arbiter() {}
+
+  /**
+   * @brief Queue a transaction for the bus and return at once.
+   *
+   * @param transaction The transaction; its callback, if any, is called when it
+   * completes
+   * @return **bool** True if it was queued, false if the queue is full, there is no
+   * command, it is already pending, or the arbiter has been stopped
+   */
+  bool submit(SDI12Transaction& transaction);
+  /**
+   * @brief Queue a transaction for the bus and wait for it to complete.
+   *
+   * Must not be called from the thread running the bus.
+   *
+   * @param transaction The transaction
+   * @return **bool** True if the response arrived
+   */
+  bool transact(SDI12Transaction& transaction);
+  /**
+   * @brief Wait for a submitted transaction to complete.
+   *
+   * @param transaction The transaction
+   * @return **bool** True if the response arrived
+   */
+  bool wait(SDI12Transaction& transaction);
+
+  /**
+   * @brief Put the most urgent waiting transaction on the wire.
+   *
+   * @param waitMillis How long to wait for a transaction to be submitted, if none are
+   * waiting
+   * @return **bool** True if a transaction was run
+   */
+  bool processNext(uint32_t waitMillis);
+  /**
+   * @brief Run transactions as they are submitted until stop() is called.
+   */
+  void run();
+  /**
+   * @brief Make run() return once the transaction on the wire, if any, is done.
+   *
+   * The transactions still waiting are completed as #SDI12_TRANSACTION_CANCELLED, so
+   * no thread is left waiting for them, and nothing more can be submitted until run()
+   * is called again.
+   */
+  void stop();
+  /**
+   * @brief Get the number of transactions waiting for the bus
+   *
+   * @return **uint8_t** The number of transactions waiting
+   */
+  uint8_t pending();
+
+ protected:
+  /**
+   * @brief Send a command out on the bus
+   *
+   * @param command The command
+   * @param wake True to send a break first
+   * @param extraWakeTime Extra time to wait after the break
+   */
+  virtual void sendCommand(const char* command, bool wake, int8_t extraWakeTime);
+  /**
+   * @brief Wait for the response line and copy it into the transaction
+   *
+   * @param transaction The transaction
+   * @return **bool** True if the response arrived
+   */
+  virtual bool readResponse(SDI12Transaction& transaction);
+  /**
+   * @brief Get the time, in milliseconds
+   *
+   * @return **uint32_t** The time
+   */
+  virtual uint32_t now();
+
+ private:
+  /** @brief The bus */
+  SDI12& _bus;
+  /** @brief The waiting transactions, most urgent first */
+  SDI12Transaction* _queue[SDI12_ARBITER_QUEUE_SIZE];
+  /** @brief The number of waiting transactions */
+  uint8_t _queued = 0;
+  /** @brief When the last response ended, if the sensors could still be awake */
+  uint32_t _lastActivity = 0;
+  /** @brief Whether any transaction has been run yet */
+  bool _haveActivity = false;
+  /** @brief Set by stop() */
+  bool _stopping = false;
+  /** @brief Guards the queue and the transaction status */
+  std::mutex _mutex;
+  /** @brief Signalled when a transaction is submitted */
+  std::condition_variable _submitted;
+  /** @brief Signalled when a transaction completes */
+  std::condition_variable _completed;
+};
+
+#endif  // defined(ESP32) || !defined(ARDUINO)
+
+#endif  // SRC_SDI12_ARBITER_H_
@@ -0,0 +1,204 @@
+/**
+ * @file SDI12Async.cpp
+ * @copyright (c) 2013-2020 Stroud Water Research Center (SWRC)
+ *                          and the EnviroDIY Development Team
+ *            This library is published under the BSD-3 license.
+ *
+ * @brief This file implements the SDI12Async class, which runs many sensor
+ * transactions interleaved on one bus from a single thread.
+ */
+
+/* ======================== Arduino SDI-12 =================================
+An Arduino library for SDI-12 communication with a wide variety of environmental
+sensors. This library provides a general software solution, without requiring
+   ======================== Arduino SDI-12 =================================*/
+
+#include "SDI12Async.h"
+
+#if defined(SDI12_ASYNC_AVAILABLE)
+
+SDI12Async::SDI12Async(SDI12& bus) : _bus(bus) {}
+
+SDI12Async::~SDI12Async() {
+  for (uint8_t i = 0; i < _taskCount; i++) { _tasks[i].destroy(); }
+}
+
+// queues the command behind any others waiting for the bus
+void SDI12Async::CommandAwaiter::await_suspend(std::coroutine_handle<> h) noexcept {
+  _handle = h;
+  if (_owner._commandTail) {
+    _owner._commandTail->_next = this;
+  } else {
+    _owner._commandHead = this;
+  }
+  _owner._commandTail = this;
+}
+
+// puts the task in the sleeper list, soonest first
+void SDI12Async::SleepAwaiter::await_suspend(std::coroutine_handle<> h) noexcept {
+  _handle             = h;
+  _wake               = _owner.now() + _millis;
+  SleepAwaiter** link = &_owner._sleepers;
+  while (*link && (int32_t)((*link)->_wake - _wake) <= 0) { link = &(*link)->_next; }
+  _next = *link;
+  *link = this;
+}
+
+SDI12Task<SDI12Measurement> SDI12Async::measure(char address, uint8_t index) {
+  SDI12Measurement m;
+  m.address = address;
+
+  char start[5] = {address, 'C', '!', '\0', '\0'};
+  if (index > 0) {
+    start[2] = '0' + index;
+    start[3] = '!';
+  }
+  // atttn or atttnn
+  SDI12Response r = co_await command(start);
+  if (!r.ok || r.length < 5 || r.text[0] != address) co_return m;
+  uint16_t wait = 0;
+  for (uint8_t i = 1; i <= 3; i++) { wait = wait * 10 + (r.text[i] - '0'); }
+  uint8_t expected = 0;
+  for (uint8_t i = 4; i < r.length; i++) { expected = expected * 10 + (r.text[i] - '0'); }
+
+  co_await sleep(wait * 1000UL);
+
+  char data[5] = {address, 'D', '0', '!', '\0'};
+  while (m.count < expected && data[2] <= '9') {
+    r = co_await command(data);
+    // an empty response means the sensor has nothing more
+    if (!r.ok || r.length <= 1) break;
+    parseValues(r.text + 1, m);
+    data[2]++;
+  }
+  m.ok = m.count >= expected;
+  co_return m;
+}
+
+// values are separated by their signs, e.g. "+1.23-4.5+67"
+void SDI12Async::parseValues(const char* text, SDI12Measurement& m) {
+  uint8_t stored = m.count < SDI12_ASYNC_MAX_VALUES ? m.count : SDI12_ASYNC_MAX_VALUES;
+  m.count += SDI12::parseValues(text, strlen(text), m.values + stored,
+                                SDI12_ASYNC_MAX_VALUES - stored);
+}
+
+bool SDI12Async::spawn(SDI12Task<> task) {
+  if (_taskCount >= SDI12_ASYNC_MAX_TASKS) return false;
+  _tasks[_taskCount++] = task._handle;
+  task._handle         = nullptr;
+  _tasks[_taskCount - 1].resume();
+  reapTasks();
+  return true;
+}
+
+void SDI12Async::reapTasks() {
+  uint8_t kept = 0;
+  for (uint8_t i = 0; i < _taskCount; i++) {
+    if (_tasks[i].done()) {
+      _tasks[i].destroy();
+    } else {
+      _tasks[kept++] = _tasks[i];
+    }
+  }
+  _taskCount = kept;
+}
+
+bool SDI12Async::poll() {
+  // the command on the wire gets its response, or times out
+  if (_active) {
+    CommandAwaiter* a  = _active;
+    bool            ok = false;
+    while (readLine(a->_response)) {
+      if (a->_response.text[0] == a->_command[0]) {
+        ok = true;
+        break;
+      }
+    }
+    if (ok || now() - a->_sent >= a->_timeout) {
+      if (!ok) {
+        a->_response.length  = 0;
+        a->_response.text[0] = '\0';
+      }
+      a->_response.ok = ok;
+      _active         = nullptr;
+      _haveActivity   = ok;
+      _lastActivity   = now();
+      a->_handle.resume();
+      reapTasks();
+      return true;
+    }
+  }
+
+  // the bus is free, so the next command goes out
+  if (!_active && _commandHead) {
+    CommandAwaiter* a = _commandHead;
+    _commandHead      = a->_next;
+    if (!_commandHead) _commandTail = nullptr;
+    bool awake = _haveActivity && (now() - _lastActivity < SDI12_ASYNC_AWAKE_MS);
+    sendCommand(a->_command, !awake);
+    a->_sent = now();
+    _active  = a;
+    return true;
+  }
+
+  // wake the first sleeper that is due
+  if (_sleepers && (int32_t)(now() - _sleepers->_wake) >= 0) {
+    SleepAwaiter* s = _sleepers;
+    _sleepers       = s->_next;
+    s->_handle.resume();
+    reapTasks();
+    return true;
+  }
+  return false;
+}
+
+void SDI12Async::run() {
+  while (_taskCount > 0) {
+    if (poll()) continue;
+    // nothing is due; wait for the response on the wire or the next sleeper
+    uint32_t t       = now();
+    uint32_t waitFor = 1000;
+    if (_active) {
+      uint32_t left = _active->_timeout - (t - _active->_sent);
+      if (left < waitFor) waitFor = left;
+    }
+    if (_sleepers) {
+      int32_t left = (int32_t)(_sleepers->_wake - t);
+      if (left < 0) left = 0;
+      if ((uint32_t)left < waitFor) waitFor = left;
+    }
+    idle(waitFor);
+  }
+}
+
+void SDI12Async::sendCommand(const char* command, bool wake) {
+  _bus.clearBuffer();  // anything left over isn't the response to this
+  if (wake) {
+    _bus.sendCommand(command);
+  } else {
+    _bus.sendCommandNoBreak(command);
+  }
+}
+
+bool SDI12Async::readLine(SDI12Response& response) {
+  SDI12Line line;
+  if (!_bus.peekLine(line)) return false;
+  uint8_t length = line.length();
+  memcpy(response.text, line.first, line.firstLength);
+  memcpy(response.text + line.firstLength, line.second, line.secondLength);
+  response.text[length] = '\0';
+  response.length       = length;
+  _bus.consume();
+  return true;
+}
+
+uint32_t SDI12Async::now() {
+  return millis();
+}
+
+void SDI12Async::idle(uint32_t maxMillis) {
+  int available = _bus.available();
+  _bus.waitAvailable(available < 0 ? 1 : available + 1, maxMillis);
+}
+
+#endif  // SDI12_ASYNC_AVAILABLE
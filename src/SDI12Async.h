@@ -0,0 +1,421 @@
+/**
+ * @file SDI12Async.h
+ * @copyright (c) 2013-2020 Stroud Water Research Center (SWRC)
+ *                          and the EnviroDIY Development Team
+ *            This library is published under the BSD-3 license.
+ *
+ * @brief This file contains the SDI12Async class and the SDI12Task coroutine type,
+ * which run many sensor transactions interleaved on one bus from a single thread.
+ *
+ * They need C++20 coroutines, so they are only built on ESP32 boards and on a host
+ * (non-Arduino) build of the library, and only when the compiler supports coroutines
+ * (e.g. gcc 10 or later with -std=gnu++20).
+ */
+
+/* ======================== Arduino SDI-12 =================================
+An Arduino library for SDI-12 communication with a wide variety of environmental
+sensors. This library provides a general software solution, without requiring
+   ======================== Arduino SDI-12 =================================*/
+
+#ifndef SRC_SDI12_ASYNC_H_
+#define SRC_SDI12_ASYNC_H_
+
+#include "SDI12.h"
+
+#if (defined(ESP32) || !defined(ARDUINO)) && defined(__cpp_impl_coroutine)
+/**
+ * @brief Defined when the SDI12Async class is available
+ */
+#define SDI12_ASYNC_AVAILABLE
+
+#include <coroutine>  // std::coroutine_handle
+#include <exception>  // std::terminate
+#include <utility>    // std::move
+
+#ifndef SDI12_ASYNC_MAX_TASKS
+/**
+ * @brief The number of tasks that can be spawned on an SDI12Async at once.
+ */
+#define SDI12_ASYNC_MAX_TASKS 32
+#endif
+
+#ifndef SDI12_ASYNC_MAX_VALUES
+/**
+ * @brief The number of values kept from one measurement.
+ */
+#define SDI12_ASYNC_MAX_VALUES 20
+#endif
+
+#ifndef SDI12_ASYNC_AWAKE_MS
+/**
+ * @brief How long after the end of the last response the sensors are still awake, in
+ * milliseconds.
+ *
+ * A command sent within this time goes out without a break.
+ */
+#define SDI12_ASYNC_AWAKE_MS 75
+#endif
+
+class SDI12Async;
+
+/**
+ * @brief A response line, as returned by `co_await SDI12Async::command()`
+ */
+struct SDI12Response {
+  /** @brief True if the response arrived before the timeout */
+  bool ok = false;
+  /** @brief The number of characters in the response */
+  uint8_t length = 0;
+  /** @brief The response, without the <CR><LF>, null terminated */
+  char text[SDI12_BUFFER_SIZE] = {0};
+};
+
+/**
+ * @brief The result of a measurement, as returned by `co_await SDI12Async::measure()`
+ */
+struct SDI12Measurement {
+  /** @brief True if every value the sensor promised was read */
+  bool ok = false;
+  /** @brief The address of the sensor */
+  char address = 0;
+  /** @brief The number of values read */
+  uint8_t count = 0;
+  /** @brief The values */
+  float values[SDI12_ASYNC_MAX_VALUES] = {0};
+};
+
+/**
+ * @brief The parts of an SDI12Task promise that don't depend on the return type.
+ */
+struct SDI12TaskPromiseBase {
+  /** @brief The coroutine awaiting this task, or null if the task was spawned */
+  std::coroutine_handle<> continuation;
+
+  /** @brief Resumes the awaiting coroutine, if any, when the task finishes */
+  struct FinalAwaiter {
+    bool await_ready() noexcept {
+      return false;
+    }
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept {
+      std::coroutine_handle<> next = h.promise().continuation;
+      return next ? next : std::noop_coroutine();
+    }
+    void await_resume() noexcept {}
+  };
+
+  /** @brief Tasks don't start until they are awaited or spawned */
+  std::suspend_always initial_suspend() noexcept {
+    return {};
+  }
+  /** @brief Tasks stay suspended when they finish, so the owner can get the result */
+  FinalAwaiter final_suspend() noexcept {
+    return {};
+  }
+  /** @brief There is nowhere to report an exception to */
+  void unhandled_exception() noexcept {
+    std::terminate();
+  }
+};
+
+/**
+ * @brief A coroutine that runs on an SDI12Async.
+ *
+ * A function returning an SDI12Task can `co_await` the commands, sleeps and
+ * measurements of an SDI12Async, and other SDI12Tasks.  It doesn't start until it is
+ * awaited or handed to SDI12Async::spawn().
+ *
+ * @tparam T The type of the value the coroutine `co_return`s
+ */
+template <typename T = void>
+class SDI12Task {
+ public:
+  /** @brief The coroutine promise */
+  struct promise_type : SDI12TaskPromiseBase {
+    /** @brief The value returned by the coroutine */
+    T value{};
+    SDI12Task get_return_object() {
+      return SDI12Task(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    void return_value(T v) {
+      value = std::move(v);
+    }
+  };
+
+  SDI12Task(SDI12Task&& other) noexcept : _handle(other._handle) {
+    other._handle = nullptr;
+  }
+  SDI12Task(const SDI12Task&) = delete;
+  SDI12Task& operator=(const SDI12Task&) = delete;
+  ~SDI12Task() {
+    if (_handle) _handle.destroy();
+  }
+
+  /** @brief Start the task and suspend the awaiting coroutine until it finishes */
+  bool await_ready() noexcept {
+    return false;
+  }
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+    _handle.promise().continuation = awaiting;
+    return _handle;
+  }
+  T await_resume() {
+    return std::move(_handle.promise().value);
+  }
+
+ private:
+  explicit SDI12Task(std::coroutine_handle<promise_type> h) : _handle(h) {}
+  std::coroutine_handle<promise_type> _handle;
+};
+
+/**
+ * @brief A coroutine that runs on an SDI12Async and returns nothing.
+ *
+ * Only these can be handed to SDI12Async::spawn().
+ */
+template <>
+class SDI12Task<void> {
+ public:
+  /** @brief The coroutine promise */
+  struct promise_type : SDI12TaskPromiseBase {
+    SDI12Task get_return_object() {
+      return SDI12Task(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    void return_void() {}
+  };
+
+  SDI12Task(SDI12Task&& other) noexcept : _handle(other._handle) {
+    other._handle = nullptr;
+  }
+  SDI12Task(const SDI12Task&) = delete;
+  SDI12Task& operator=(const SDI12Task&) = delete;
+  ~SDI12Task() {
+    if (_handle) _handle.destroy();
+  }
+
+  /** @brief Start the task and suspend the awaiting coroutine until it finishes */
+  bool await_ready() noexcept {
+    return false;
+  }
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+    _handle.promise().continuation = awaiting;
+    return _handle;
+  }
+  void await_resume() noexcept {}
+
+ private:
+  friend class SDI12Async;
+  explicit SDI12Task(std::coroutine_handle<promise_type> h) : _handle(h) {}
+  std::coroutine_handle<promise_type> _handle;
+};
+
+/**
+ * @brief Runs coroutines that share one SDI-12 bus, interleaved, from a single thread.
+ *
+ * Each sensor workflow is written as a coroutine that awaits its commands and waits in
+ * turn, with no state machine and no blocking `delay()`:
+ *
+ * @code{.cpp}
+ *     SDI12      mySDI12(DATA_PIN);
+ *     SDI12Async bus(mySDI12);
+ *
+ *     SDI12Task<> logSensor(char address) {
+ *       SDI12Measurement m = co_await bus.measure(address);
+ *       if (m.ok) { ... }
+ *     }
+ *
+ *     // in loop():
+ *     for (char a = '0'; a <= '9'; a++) bus.spawn(logSensor(a));
+ *     bus.run();  // returns once every sensor has been read
+ * @endcode
+ *
+ * Commands go out on the bus one at a time, in the order they are awaited, and while
+ * one task sleeps through a measurement the others use the bus.  Commands sent while
+ * the sensors are still awake from the last response skip the break.
+ *
+ * measure() uses concurrent (aC!) measurements; a non-concurrent (aM!) measurement
+ * holds the whole bus until it is done, so there is nothing to interleave.
+ */
+class SDI12Async {
+ public:
+  /**
+   * @brief Construct a new SDI12Async for a bus
+   *
+   * @param bus The SDI-12 bus; it must already be started with begin().  Nothing else
+   * may use it while tasks are running.
+   */
+  explicit SDI12Async(SDI12& bus);
+  /**
+   * @brief Destroy the SDI12Async, and any tasks still running on it
+   */
+  virtual ~SDI12Async();
+
+  /** @brief Awaits a command and the response to it; see command() */
+  class CommandAwaiter {
+   public:
+    bool await_ready() noexcept {
+      return false;
+    }
+    void await_suspend(std::coroutine_handle<> h) noexcept;
+    SDI12Response await_resume() noexcept {
+      return _response;
+    }
+
+   private:
+    friend class SDI12Async;
+    CommandAwaiter(SDI12Async& owner, const char* command, uint16_t timeout)
+        : _owner(owner), _command(command), _timeout(timeout) {}
+    SDI12Async&             _owner;
+    const char*             _command;
+    uint16_t                _timeout;
+    uint32_t                _sent = 0;
+    std::coroutine_handle<> _handle;
+    CommandAwaiter*         _next = nullptr;
+    SDI12Response           _response;
+  };
+
+  /** @brief Awaits a length of time; see sleep() */
+  class SleepAwaiter {
+   public:
+    bool await_ready() noexcept {
+      return _millis == 0;
+    }
+    void await_suspend(std::coroutine_handle<> h) noexcept;
+    void await_resume() noexcept {}
+
+   private:
+    friend class SDI12Async;
+    SleepAwaiter(SDI12Async& owner, uint32_t millis) : _owner(owner), _millis(millis) {}
+    SDI12Async&             _owner;
+    uint32_t                _millis;
+    uint32_t                _wake = 0;
+    std::coroutine_handle<> _handle;
+    SleepAwaiter*           _next = nullptr;
+  };
+
+  /**
+   * @brief Send a command once the bus is free and wait for the response.
+   *
+   * `co_await bus.command("3I!")` gives an SDI12Response.  Lines from other addresses
+   * than the command's are ignored.
+   *
+   * @param command The command; it must stay alive until the response is in
+   * @param timeout How long to wait for the response, in milliseconds
+   * @return **CommandAwaiter** The awaitable
+   */
+  CommandAwaiter command(const char* command, uint16_t timeout = 250) {
+    return CommandAwaiter(*this, command, timeout);
+  }
+  /**
+   * @brief Let the other tasks run for a while.
+   *
+   * @param millis How long to sleep, in milliseconds
+   * @return **SleepAwaiter** The awaitable
+   */
+  SleepAwaiter sleep(uint32_t millis) {
+    return SleepAwaiter(*this, millis);
+  }
+  /**
+   * @brief Start a concurrent measurement, sleep until it is ready, and collect the
+   * values with data commands.
+   *
+   * @param address The address of the sensor
+   * @param index The additional measurement number, 1-9, or 0 for aC!
+   * @return **SDI12Task<SDI12Measurement>** The measurement, once awaited
+   */
+  SDI12Task<SDI12Measurement> measure(char address, uint8_t index = 0);
+
+  /**
+   * @brief Start a task running on the bus.
+   *
+   * The task is destroyed when it finishes.
+   *
+   * @param task The task
+   * @return **bool** True if it was started, false if #SDI12_ASYNC_MAX_TASKS are
+   * already running
+   */
+  bool spawn(SDI12Task<> task);
+  /**
+   * @brief Get the number of spawned tasks that haven't finished
+   *
+   * @return **uint8_t** The number of tasks
+   */
+  uint8_t tasks() {
+    return _taskCount;
+  }
+  /**
+   * @brief Do whatever is due: send the next command, hand a response to its task, or
+   * wake a sleeping task.  Never blocks.
+   *
+   * @return **bool** True if anything was done
+   */
+  bool poll();
+  /**
+   * @brief Run the spawned tasks until they have all finished, idling between events.
+   */
+  void run();
+
+ protected:
+  /**
+   * @brief Send a command out on the bus
+   *
+   * @param command The command
+   * @param wake True to send a break first
+   */
+  virtual void sendCommand(const char* command, bool wake);
+  /**
+   * @brief Take the next complete line off the bus, without waiting
+   *
+   * @param response Where to put the line
+   * @return **bool** True if there was a line
+   */
+  virtual bool readLine(SDI12Response& response);
+  /**
+   * @brief Get the time, in milliseconds
+   *
+   * @return **uint32_t** The time
+   */
+  virtual uint32_t now();
+  /**
+   * @brief Wait until a character arrives or some time has passed
+   *
+   * @param maxMillis The longest to wait, in milliseconds
+   */
+  virtual void idle(uint32_t maxMillis);
+
+ private:
+  /** @brief The bus */
+  SDI12& _bus;
+  /** @brief The command on the wire, waiting for its response */
+  CommandAwaiter* _active = nullptr;
+  /** @brief The first command waiting for the bus */
+  CommandAwaiter* _commandHead = nullptr;
+  /** @brief The last command waiting for the bus */
+  CommandAwaiter* _commandTail = nullptr;
+  /** @brief The sleeping tasks, soonest first */
+  SleepAwaiter* _sleepers = nullptr;
+  /** @brief The spawned tasks */
+  std::coroutine_handle<SDI12Task<>::promise_type> _tasks[SDI12_ASYNC_MAX_TASKS];
+  /** @brief The number of spawned tasks */
+  uint8_t _taskCount = 0;
+  /** @brief When the last response ended */
+  uint32_t _lastActivity = 0;
+  /** @brief Whether the sensors could still be awake from the last response */
+  bool _haveActivity = false;
+
+  /**
+   * @brief Destroy any spawned tasks that have finished
+   */
+  void reapTasks();
+  /**
+   * @brief Parse the values out of a data command response
+   *
+   * @param text The response, after the address
+   * @param m The measurement to add the values to
+   */
+  static void parseValues(const char* text, SDI12Measurement& m);
+};
+
+#endif  // SDI12_ASYNC_AVAILABLE conditions
+
+#endif  // SRC_SDI12_ASYNC_H_
@@ -0,0 +1,95 @@
+/**
+ * @file SDI12DataPages.cpp
+ * @copyright (c) 2013-2020 Stroud Water Research Center (SWRC)
+ *                          and the EnviroDIY Development Team
+ *            This library is published under the BSD-3 license.
+ *
+ * @brief This file implements the SDI12DataPages class, which holds a sensor's
+ * measurement results formatted as the responses to the data commands.
+ */
+
+/* ======================== Arduino SDI-12 =================================
+An Arduino library for SDI-12 communication with a wide variety of environmental
+sensors. This library provides a general software solution, without requiring
+   ======================== Arduino SDI-12 =================================*/
+
+#include "SDI12DataPages.h"
+
+void SDI12DataPages::clear() {
+  _pageCount  = 0;
+  _valueCount = 0;
+  _crcAddress = '\0';
+}
+
+bool SDI12DataPages::set(const float* values, uint8_t count, uint8_t pageSize,
+                         char crcAddress) {
+  clear();
+  _crcAddress       = crcAddress;
+  uint8_t  crcSize  = crcAddress ? 3 : 0;
+  uint16_t end      = 0;  // the end of the page being filled
+  uint8_t  pageUsed = 0;  // characters of values on it
+  char     value[10];
+  // In order, each value goes on the current page if it fits, or starts the next;
+  // nothing left on a page could fit a later value, so no page count is smaller
+  for (uint8_t i = 0; i < count; i++) {
+    uint8_t length = SDI12::formatValue(values[i], _decimals, value);
+    if (pageUsed > 0 && pageUsed + length > pageSize) {
+      if (crcSize) crc(crcAddress, _text + _start[_pageCount], pageUsed, _text + end);
+      end += crcSize;
+      _start[++_pageCount] = end;
+      pageUsed             = 0;
+    }
+    // there is always room left for the CRC of the page being filled
+    if (_pageCount >= 10 || end + length + crcSize > SDI12_DATA_PAGES_SIZE) break;
+    memcpy(_text + end, value, length);
+    end += length;
+    pageUsed += length;
+    _valueCount++;
+  }
+  if (pageUsed > 0) {
+    if (crcSize) crc(crcAddress, _text + _start[_pageCount], pageUsed, _text + end);
+    end += crcSize;
+    _start[++_pageCount] = end;
+  }
+  return _valueCount == count;
+}
+
+const char* SDI12DataPages::page(uint8_t n, uint8_t* length) {
+  if (n >= _pageCount) {
+    *length = 0;
+    return _text;
+  }
+  *length = _start[n + 1] - _start[n];
+  return _text + _start[n];
+}
+
+int SDI12DataPages::reply(const char* command, char* reply, uint8_t size) {
+  if (command[0] != 'D' || command[1] < '0' || command[1] > '9' || command[2] != '\0') {
+    return SDI12_NO_REPLY;
+  }
+  uint8_t n = command[1] - '0';
+  if (n >= _pageCount) {
+    // a page with no values still has its CRC
+    if (!_crcAddress || size < 3) return 0;
+    crc(_crcAddress, reply, 0, reply);
+    return 3;
+  }
+  uint8_t     length;
+  const char* text = page(n, &length);
+  if (length > size) length = size;
+  memcpy(reply, text, length);
+  return length;
+}
+
+void SDI12DataPages::crc(char address, const char* text, uint8_t length, char* out) {
+  uint16_t crc = 0;
+  for (int16_t i = -1; i < length; i++) {
+    crc ^= (uint8_t)(i < 0 ? address : text[i]);
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    }
+  }
+  out[0] = 0x40 | (crc >> 12);
+  out[1] = 0x40 | ((crc >> 6) & 0x3F);
+  out[2] = 0x40 | (crc & 0x3F);
+}
@@ -0,0 +1,157 @@
+/**
+ * @file SDI12DataPages.h
+ * @copyright (c) 2013-2020 Stroud Water Research Center (SWRC)
+ *                          and the EnviroDIY Development Team
+ *            This library is published under the BSD-3 license.
+ *
+ * @brief This file contains the SDI12DataPages class, which holds a sensor's
+ * measurement results formatted as the responses to the data commands.
+ */
+
+/* ======================== Arduino SDI-12 =================================
+An Arduino library for SDI-12 communication with a wide variety of environmental
+sensors. This library provides a general software solution, without requiring
+   ======================== Arduino SDI-12 =================================*/
+
+#ifndef SRC_SDI12_DATA_PAGES_H_
+#define SRC_SDI12_DATA_PAGES_H_
+
+#include "SDI12Sensor.h"
+
+#ifndef SDI12_DATA_PAGES_SIZE
+/**
+ * @brief The number of characters of values, and CRCs, one SDI12DataPages holds.
+ *
+ * A value takes at most 9 characters, so the default is enough for 20 values.
+ */
+#define SDI12_DATA_PAGES_SIZE 200
+#endif
+
+/**
+ * @brief The most characters of values in the response to a data command after a
+ * measurement (aM!) or verification (aV!)
+ */
+#define SDI12_PAGE_SIZE_M 35
+/**
+ * @brief The most characters of values in the response to a data command after a
+ * concurrent (aC!) or continuous (aR!) measurement
+ */
+#define SDI12_PAGE_SIZE_C 75
+
+/**
+ * @brief A sensor's measurement results, formatted once as the responses to aD0! to
+ * aD9!.
+ *
+ * When a measurement is done, set() formats each value as a sign and at most 7
+ * digits with SDI12::formatValue(), e.g. +1.234567 or -123.4567, and packs them in
+ * order into as few pages as the page size allows, with the CRC at the end of each page
+ * if asked for.  After that, answering a data command is a copy out of the page table.
+ *
+ * @code{.cpp}
+ *     SDI12DataPages pages;
+ *     int sendData(SDI12Sensor&, const char* command, char* reply, uint8_t size) {
+ *       return pages.reply(command, reply, size);
+ *     }
+ *     // when the measurement is done
+ *     pages.set(values, 9, SDI12_PAGE_SIZE_M);
+ * @endcode
+ *
+ * The pages are kept in the object, so declare it globally rather than on the stack.
+ */
+class SDI12DataPages {
+ public:
+  /**
+   * @brief Empty the pages; every data command gets a response with no values.
+   *
+   * Call this when a new measurement starts, so the old results can't be read.
+   */
+  void clear();
+  /**
+   * @brief Format the results of a measurement into pages.
+   *
+   * @param values The values
+   * @param count The number of values
+   * @param pageSize The most characters of values on a page, #SDI12_PAGE_SIZE_M or
+   * #SDI12_PAGE_SIZE_C
+   * @param crcAddress The sensor's address, to add a CRC to each page (for aMC!, aCC!
+   * and the like), or '\0' for none.  The CRC covers the address, so set() must be
+   * called again if the address changes.
+   * @return **bool** True if all of the values fit in 10 pages and in
+   * #SDI12_DATA_PAGES_SIZE; if not, the pages have the values that fit
+   */
+  bool set(const float* values, uint8_t count, uint8_t pageSize,
+           char crcAddress = '\0');
+  /**
+   * @brief Set the number of decimal places each value is formatted with.
+   *
+   * Values too big for that many are given fewer, to stay within 7 digits.
+   *
+   * @param decimals The number of decimal places, 0-6; the default is 6
+   */
+  void setDecimals(uint8_t decimals) {
+    _decimals = decimals > 6 ? 6 : decimals;
+  }
+
+  /**
+   * @brief Answer a data command from the pages.
+   *
+   * Written to be called from an SDI12Sensor command handler.
+   *
+   * @param command The command, without the address or the '!', e.g. "D0"
+   * @param reply Where to write the reply
+   * @param size The most characters that can be written to reply
+   * @return **int** The length of the reply, 0 (or just the CRC) for a page with no
+   * values, or #SDI12_NO_REPLY if the command isn't aD0! to aD9!
+   */
+  int reply(const char* command, char* reply, uint8_t size);
+  /**
+   * @brief Get one page.
+   *
+   * @param n The page number, 0-9
+   * @param length Set to the length of the page, including any CRC
+   * @return **const char*** The page, not null terminated
+   */
+  const char* page(uint8_t n, uint8_t* length);
+  /**
+   * @brief Get the number of pages with values
+   *
+   * @return **uint8_t** The number of pages
+   */
+  uint8_t pageCount() {
+    return _pageCount;
+  }
+  /**
+   * @brief Get the number of values in the pages
+   *
+   * @return **uint8_t** The number of values
+   */
+  uint8_t valueCount() {
+    return _valueCount;
+  }
+
+  /**
+   * @brief Compute the SDI-12 CRC of a response.
+   *
+   * @param address The address the response starts with
+   * @param text The rest of the response, without the <CR><LF>
+   * @param length The length of text
+   * @param out Where to write the 3 character encoded CRC
+   */
+  static void crc(char address, const char* text, uint8_t length, char* out);
+
+ private:
+  /** @brief The pages, one after the other */
+  char _text[SDI12_DATA_PAGES_SIZE];
+  /** @brief Where each page starts in _text, and where the last one ends */
+  uint16_t _start[11] = {0};
+  /** @brief The number of pages with values */
+  uint8_t _pageCount = 0;
+  /** @brief The number of values in the pages */
+  uint8_t _valueCount = 0;
+  /** @brief The decimal places for each value */
+  uint8_t _decimals = 6;
+  /** @brief The address the CRCs are computed with, or '\0' for no CRCs */
+  char _crcAddress = '\0';
+};
+
+#endif  // SRC_SDI12_DATA_PAGES_H_
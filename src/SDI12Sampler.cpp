@@ -0,0 +1,144 @@
+/**
+ * @file SDI12Sampler.cpp
+ * @copyright (c) 2013-2020 Stroud Water Research Center (SWRC)
+ *                          and the EnviroDIY Development Team
+ *            This library is published under the BSD-3 license.
+ *
+ * @brief This file implements the SDI12Sampler class, which reads continuous
+ * measurements (aR0! to aR9!) as fast as the bus allows, and the SDI12SampleRing it
+ * puts them in.
+ */
+
+/* ======================== Arduino SDI-12 =================================
+An Arduino library for SDI-12 communication with a wide variety of environmental
+sensors. This library provides a general software solution, without requiring
+   ======================== Arduino SDI-12 =================================*/
+
+#include "SDI12Sampler.h"
+
+/* ================ Sample Ring =====================================================*/
+
+SDI12Sample* SDI12SampleRing::reserve() {
+  uint8_t head = __atomic_load_n(&_head, __ATOMIC_ACQUIRE);
+  if ((_tail + 1) % SDI12_SAMPLE_RING_SIZE == head) return NULL;
+  return &_samples[_tail];
+}
+
+void SDI12SampleRing::commit() {
+  // the sample is written before the consumer can see the new tail
+  __atomic_store_n(&_tail, (_tail + 1) % SDI12_SAMPLE_RING_SIZE, __ATOMIC_RELEASE);
+}
+
+bool SDI12SampleRing::pop(SDI12Sample& sample) {
+  uint8_t tail = __atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+  if (_head == tail) return false;
+  sample = _samples[_head];
+  // the sample is copied before the producer can reuse its place
+  __atomic_store_n(&_head, (_head + 1) % SDI12_SAMPLE_RING_SIZE, __ATOMIC_RELEASE);
+  return true;
+}
+
+uint8_t SDI12SampleRing::available() {
+  uint8_t tail = __atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+  uint8_t head = __atomic_load_n(&_head, __ATOMIC_ACQUIRE);
+  return (tail + SDI12_SAMPLE_RING_SIZE - head) % SDI12_SAMPLE_RING_SIZE;
+}
+
+/* ================ Sampler =========================================================*/
+
+SDI12Sampler::SDI12Sampler(SDI12& bus, SDI12SampleRing& ring)
+    : _bus(bus), _ring(ring) {}
+
+bool SDI12Sampler::start(const char* addresses, uint8_t index) {
+  if (!addresses || !*addresses || index > 9) return false;
+  _addresses  = addresses;
+  _next       = 0;
+  _command[1] = 'R';
+  _command[2] = '0' + index;
+  _command[3] = '!';
+  _stopping   = false;
+  return true;
+}
+
+void SDI12Sampler::stop() {
+  if (_waiting) {
+    _stopping = true;
+  } else {
+    _addresses = NULL;
+  }
+}
+
+bool SDI12Sampler::poll() {
+  if (!_addresses) return false;
+  if (_waiting) {
+    SDI12Line line;
+    bool      answered = false;
+    while (peekLine(line)) {
+      // only the response from the sensor asked counts
+      if (line.length() > 0 && line[0] == _command[0]) {
+        SDI12Sample* sample = _ring.reserve();
+        if (sample) {
+          sample->timestamp = _sent;
+          sample->address   = _command[0];
+          sample->count     = SDI12::parseValues(line, sample->values,
+                                                 SDI12_SAMPLE_MAX_VALUES);
+          _ring.commit();
+        } else {
+          _ring.drop();
+        }
+        answered = true;
+      }
+      consume();
+      if (answered) break;
+    }
+    if (!answered) {
+      // the response, if it comes, ends after now
+      _lastActivity = now();
+      if (_lastActivity - _sent < SDI12_SAMPLER_TIMEOUT_MS * 1000UL) return false;
+      _timeouts++;
+    }
+    // the line is only known to have been busy until the last check, so the sensors
+    // are taken to have been marking since then, even if poll() was called late
+    _waiting      = false;
+    _haveActivity = answered;
+    if (_stopping) {
+      _addresses = NULL;
+      return true;
+    }
+  }
+  // the next command goes out straight away
+  sendNext();
+  return true;
+}
+
+void SDI12Sampler::sendNext() {
+  _command[0] = _addresses[_next];
+  if (_addresses[++_next] == '\0') _next = 0;
+  bool awake = _haveActivity &&
+      now() - _lastActivity < SDI12_SAMPLER_AWAKE_MS * 1000UL;
+  sendCommand(_command, !awake);
+  _sent         = now();
+  _lastActivity = _sent;
+  _waiting      = true;
+}
+
+void SDI12Sampler::sendCommand(const char* command, bool wake) {
+  _bus.clearBuffer();  // anything left over isn't the response to this
+  if (wake) {
+    _bus.sendCommand(command);
+  } else {
+    _bus.sendCommandNoBreak(command);
+  }
+}
+
+bool SDI12Sampler::peekLine(SDI12Line& line) {
+  return _bus.peekLine(line);
+}
+
+void SDI12Sampler::consume() {
+  _bus.consume();
+}
+
+uint32_t SDI12Sampler::now() {
+  return micros();
+}
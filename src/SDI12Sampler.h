@@ -0,0 +1,296 @@
+/**
+ * @file SDI12Sampler.h
+ * @copyright (c) 2013-2020 Stroud Water Research Center (SWRC)
+ *                          and the EnviroDIY Development Team
+ *            This library is published under the BSD-3 license.
+ *
+ * @brief This file contains the SDI12Sampler class, which reads continuous
+ * measurements (aR0! to aR9!) as fast as the bus allows, and the SDI12SampleRing it
+ * puts them in.
+ */
+
+/* ======================== Arduino SDI-12 =================================
+An Arduino library for SDI-12 communication with a wide variety of environmental
+sensors. This library provides a general software solution, without requiring
+   ======================== Arduino SDI-12 =================================*/
+
+#ifndef SRC_SDI12_SAMPLER_H_
+#define SRC_SDI12_SAMPLER_H_
+
+#include "SDI12.h"
+
+#ifndef SDI12_SAMPLE_MAX_VALUES
+/**
+ * @brief The number of values kept from one continuous measurement response.
+ */
+#define SDI12_SAMPLE_MAX_VALUES 8
+#endif
+
+#ifndef SDI12_SAMPLE_RING_SIZE
+/**
+ * @brief The number of samples an SDI12SampleRing holds; at most 255.
+ *
+ * At 1200 baud a sensor can't be read more than about 10 times a second, so the
+ * default holds at least a second and a half of samples.
+ */
+#define SDI12_SAMPLE_RING_SIZE 16
+#endif
+
+#ifndef SDI12_SAMPLER_AWAKE_MS
+/**
+ * @brief How long after the end of the last response the sensors are still awake, in
+ * milliseconds.
+ *
+ * A break is required once the line has been marking for more than 87 ms; this leaves
+ * room for the 8.33 ms marking before the command.
+ */
+#define SDI12_SAMPLER_AWAKE_MS 75
+#endif
+
+#ifndef SDI12_SAMPLER_TIMEOUT_MS
+/**
+ * @brief How long to wait for the whole response to a continuous measurement command,
+ * in milliseconds.
+ *
+ * The sensor must start to answer within 15 ms, and the longest response, 81
+ * characters, takes 675 ms.
+ */
+#define SDI12_SAMPLER_TIMEOUT_MS 700
+#endif
+
+/**
+ * @brief The values from one continuous measurement response
+ */
+struct SDI12Sample {
+  /**
+   * @brief micros() when the command for it had been sent, not when the response came.
+   *
+   * The response has the sensor's latest values at the time it got the command, so
+   * that is the nearest the sampler knows to when they were measured.  The response
+   * ends the 8.33 ms of marking and its characters later, and is only seen at the next
+   * poll() after that.
+   */
+  uint32_t timestamp;
+  /** @brief The address of the sensor */
+  char address;
+  /** @brief The number of values in the response; only the first
+   * #SDI12_SAMPLE_MAX_VALUES are kept */
+  uint8_t count;
+  /** @brief The values */
+  float values[SDI12_SAMPLE_MAX_VALUES];
+};
+
+/**
+ * @brief A fixed-size ring of samples, for one producer and one consumer.
+ *
+ * Like the Rx buffer, the producer only writes the tail and the consumer only writes
+ * the head, with acquire/release ordering on both, so the sampler can run in a
+ * different FreeRTOS task, or on the other core of an ESP32, from the code that takes
+ * the samples out, without a lock.  When the ring is full, new samples are dropped and
+ * counted; the oldest are never overwritten.
+ */
+class SDI12SampleRing {
+ public:
+  /**
+   * @brief Get the place for the next sample, to fill in and then commit().
+   *
+   * For the producer only.
+   *
+   * @return **SDI12Sample*** The place, or NULL if the ring is full
+   */
+  SDI12Sample* reserve();
+  /**
+   * @brief Make the sample filled in after reserve() available to the consumer.
+   *
+   * For the producer only.
+   */
+  void commit();
+  /**
+   * @brief Count a sample dropped because the ring was full.
+   *
+   * For the producer only.
+   */
+  void drop() {
+    _dropped++;
+  }
+
+  /**
+   * @brief Take the oldest sample out of the ring.
+   *
+   * For the consumer only.
+   *
+   * @param sample Where to copy the sample
+   * @return **bool** True if there was a sample
+   */
+  bool pop(SDI12Sample& sample);
+  /**
+   * @brief Get the number of samples waiting.
+   *
+   * @return **uint8_t** The number of samples
+   */
+  uint8_t available();
+  /**
+   * @brief Get the number of samples dropped because the ring was full.
+   *
+   * @return **uint16_t** The number of samples dropped, wrapping at 65535
+   */
+  uint16_t dropped() {
+    return _dropped;
+  }
+
+ private:
+  /** @brief The samples */
+  SDI12Sample _samples[SDI12_SAMPLE_RING_SIZE];
+  /** @brief The index of the oldest sample, written by the consumer */
+  volatile uint8_t _head = 0;
+  /** @brief The index after the newest sample, written by the producer */
+  volatile uint8_t _tail = 0;
+  /** @brief The samples dropped */
+  volatile uint16_t _dropped = 0;
+};
+
+/**
+ * @brief Reads continuous measurements from one or more sensors, back to back, into an
+ * SDI12SampleRing.
+ *
+ * Continuous measurements (aR0! to aR9!) are answered at once with the sensor's latest
+ * values, so a flow or level sensor can be read as fast as the bus allows.  poll()
+ * never waits for the bus:
+ * - when the response line is complete, its values are parsed with
+ * SDI12::parseValues() straight out of the Rx buffer into the next place in the ring,
+ * and the next command goes out at once
+ * - while the sensors are still awake from the last response, that command has no
+ * break; only the 8.33 ms of marking the standard requires comes before it
+ * - after a timeout, or if poll() wasn't called again in time, the command is sent with
+ * a break
+ *
+ * The sensors are read in turn, one command each.  There is no String, no fixed delay
+ * and no per-character read.
+ *
+ * @code{.cpp}
+ *     SDI12           mySDI12(DATA_PIN);
+ *     SDI12SampleRing samples;
+ *     SDI12Sampler    sampler(mySDI12, samples);
+ *
+ *     // in setup(): mySDI12.begin(); sampler.start("0");
+ *     // in loop():
+ *     sampler.poll();
+ *     SDI12Sample s;
+ *     while (samples.pop(s)) { ... }
+ * @endcode
+ *
+ * Sending a command takes about 40 ms, during which poll() doesn't return.  On an
+ * ESP32, poll() can run in a task of its own and the samples be taken out in another.
+ */
+class SDI12Sampler {
+ public:
+  /**
+   * @brief Construct a new SDI12Sampler
+   *
+   * @param bus The SDI-12 bus; it must already be started with begin().  Nothing else
+   * may use it while the sampler is running.
+   * @param ring The ring to put the samples in
+   */
+  SDI12Sampler(SDI12& bus, SDI12SampleRing& ring);
+  /**
+   * @brief Destroy the SDI12Sampler
+   */
+  virtual ~SDI12Sampler() {}
+
+  /**
+   * @brief Start reading continuous measurements
+   *
+   * @param addresses The addresses of the sensors to read in turn, e.g. "0" or "0123";
+   * the string must stay alive while the sampler runs
+   * @param index The continuous measurement, 0-9 for aR0! to aR9!
+   * @return **bool** True if started, false if there are no addresses or index is too
+   * big
+   */
+  bool start(const char* addresses, uint8_t index = 0);
+  /**
+   * @brief Stop reading, once any response on the way has come or timed out
+   */
+  void stop();
+  /**
+   * @brief Check whether the sampler is reading
+   *
+   * @return **bool** True between start() and stop()
+   */
+  bool isRunning() {
+    return _addresses != NULL;
+  }
+  /**
+   * @brief Take in the response, if it's complete, and send the next command when due.
+   *
+   * Call this as often as possible; each sample takes at least the time of the command
+   * and the response on the wire, so any delay between calls slows down sampling.
+   *
+   * @return **bool** True if anything was done
+   */
+  bool poll();
+  /**
+   * @brief Get the number of commands that got no response before the timeout
+   *
+   * @return **uint16_t** The number of timeouts
+   */
+  uint16_t getTimeouts() {
+    return _timeouts;
+  }
+
+ protected:
+  /**
+   * @brief Send a command out on the bus
+   *
+   * @param command The command
+   * @param wake True to send a break first
+   */
+  virtual void sendCommand(const char* command, bool wake);
+  /**
+   * @brief Look at the next complete line from the bus, without waiting
+   *
+   * @param line The view to set
+   * @return **bool** True if there was a line
+   */
+  virtual bool peekLine(SDI12Line& line);
+  /**
+   * @brief Release the line seen by peekLine()
+   */
+  virtual void consume();
+  /**
+   * @brief Get the time, in microseconds
+   *
+   * @return **uint32_t** The time
+   */
+  virtual uint32_t now();
+
+ private:
+  /** @brief The bus */
+  SDI12& _bus;
+  /** @brief The ring */
+  SDI12SampleRing& _ring;
+  /** @brief The addresses of the sensors, or NULL when stopped */
+  const char* _addresses = NULL;
+  /** @brief The next sensor to read, as a place in _addresses */
+  uint8_t _next = 0;
+  /** @brief The command on the wire, e.g. "0R0!" */
+  char _command[5] = {0};
+  /** @brief Whether a command is waiting for its response */
+  bool _waiting = false;
+  /** @brief Stop once the command on the wire is done */
+  bool _stopping = false;
+  /** @brief When the command on the wire had been sent */
+  uint32_t _sent = 0;
+  /** @brief The last time the line was known to be busy */
+  uint32_t _lastActivity = 0;
+  /** @brief Whether the sensors could still be awake from the last response */
+  bool _haveActivity = false;
+  /** @brief The commands that got no response */
+  uint16_t _timeouts = 0;
+
+  /**
+   * @brief Send the command to the next sensor
+   */
+  void sendNext();
+};
+
+#endif  // SRC_SDI12_SAMPLER_H_
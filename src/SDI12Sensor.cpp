@@ -0,0 +1,219 @@
+/**
+ * @file SDI12Sensor.cpp
+ * @copyright (c) 2013-2020 Stroud Water Research Center (SWRC)
+ *                          and the EnviroDIY Development Team
+ *            This library is published under the BSD-3 license.
+ *
+ * @brief This file implements the SDI12Sensor class, which makes the board act as an
+ * SDI-12 sensor (slave).
+ */
+
+/* ======================== Arduino SDI-12 =================================
+An Arduino library for SDI-12 communication with a wide variety of environmental
+sensors. This library provides a general software solution, without requiring
+   ======================== Arduino SDI-12 =================================*/
+
+#include "SDI12Sensor.h"
+#include "SDI12DataPages.h"
+#include "SDI12SensorNode.h"
+
+char SDI12Sensor::_command[SDI12_SENSOR_COMMAND_SIZE + 1];
+char SDI12Sensor::_reply[SDI12_SENSOR_REPLY_SIZE];
+
+SDI12Sensor::SDI12Sensor(SDI12& bus, char address, const SDI12Command* commands,
+                         uint8_t commandCount)
+    : _bus(bus),
+      _address(address),
+      _commands(commands),
+      _commandCount(commandCount) {}
+
+void SDI12Sensor::begin() {
+  _bus.begin();
+  _bus.setLineTerminator('!');  // commands end with '!'
+  _bus.forceListen();
+  updateAddressFilter();
+}
+
+void SDI12Sensor::updateAddressFilter() {
+  if (_node) {
+    _node->reindex();
+    return;
+  }
+#if defined(SDI12_ADDRESS_FILTER) && defined(SDI12_BREAK_DETECT) && \
+  defined(SDI12_EXTENDED_TIMER)
+  char addresses[2] = {_address, '\0'};
+  SDI12::setAddressFilter(addresses);
+#endif
+}
+
+bool SDI12Sensor::setAddress(char address) {
+  if (!isValidAddress(address)) return false;
+  // on a node, each virtual sensor needs its own address
+  if (_node) {
+    SDI12Sensor* other = _node->find(address);
+    if (other && other != this) return false;
+  }
+  _address = address;
+  updateAddressFilter();
+  return true;
+}
+
+void SDI12Sensor::setDataPages(SDI12DataPages* pages) {
+  _pages = pages;
+}
+
+bool SDI12Sensor::isValidAddress(char address) {
+  return (address >= '0' && address <= '9') || (address >= 'a' && address <= 'z') ||
+    (address >= 'A' && address <= 'Z');
+}
+
+bool SDI12Sensor::poll() {
+  const char* command;
+  while ((command = nextCommand(_bus)) != NULL) {
+    if (command[0] != _address && command[0] != '?') continue;
+    if (answer(command)) return true;
+  }
+  return false;
+}
+
+const char* SDI12Sensor::nextCommand(SDI12& bus) {
+  // a full buffer can't hold a whole command
+  if (bus.available() < 0) bus.clearBuffer();
+#if defined(SDI12_BREAK_DETECT) && defined(SDI12_EXTENDED_TIMER)
+  // anything received before the last break is stale
+  bus.takeBreak();
+#endif
+
+  SDI12Line line;
+  while (bus.peekLine(line)) {
+    // keep the end of an overlong command, which has the address and command letter
+    uint8_t length = line.length();
+    uint8_t skip   = length > SDI12_SENSOR_COMMAND_SIZE
+        ? length - SDI12_SENSOR_COMMAND_SIZE
+        : 0;
+    uint8_t n      = 0;
+    for (uint8_t i = skip; i < length; i++) { _command[n++] = line[i]; }
+    _command[n] = '\0';
+    bus.consume();
+
+    // Another sensor's response, which ends with LF, may come just before the command
+    const char* command = _command;
+    const char* end     = _command + n;
+    for (const char* c = command; c < end; c++) {
+      if (*c == '\n') command = c + 1;
+    }
+    // Unless the receive ISR recognizes breaks, the break before the command is read
+    // as a character or two of garbage, often a null, so the command starts at the
+    // first address character
+    while (command < end && *command != '?' && !isValidAddress(*command)) command++;
+    if (command == end) continue;
+    if (command[0] == '?' && command + 1 != end) continue;  // only ?! may use '?'
+    return command;
+  }
+  return NULL;
+}
+
+bool SDI12Sensor::answer(const char* command) {
+  // any command to the sensor aborts the measurement it is taking, but ?! is for all
+  if (command[0] == _address) _measuring = NOT_MEASURING;
+
+  const char* body  = command + 1;
+  int         reply = SDI12_NO_REPLY;
+  if (*body == '\0') {
+    reply = 0;  // acknowledge active, or address query
+  } else {
+    bool handled = false;
+    for (uint8_t i = 0; i < _commandCount; i++) {
+      const char* prefix = _commands[i].prefix;
+      if (strncmp(body, prefix, strlen(prefix)) == 0) {
+        reply = _commands[i].handler(*this, body, _reply + 1,
+                                     SDI12_SENSOR_REPLY_SIZE - 4);
+        if (reply > SDI12_SENSOR_REPLY_SIZE - 4) reply = SDI12_SENSOR_REPLY_SIZE - 4;
+        handled = true;
+        break;
+      }
+    }
+    if (!handled && _measureHandler && _pages && (body[0] == 'M' || body[0] == 'C')) {
+      reply = startMeasurement(body, _reply + 1);
+    } else if (!handled && _pages && body[0] == 'D') {
+      reply = _pages->reply(body, _reply + 1, SDI12_SENSOR_REPLY_SIZE - 4);
+    } else if (!handled && body[0] == 'A' && body[1] != '\0' && body[2] == '\0') {
+      // the reply comes from the new address
+      if (setAddress(body[1])) reply = 0;
+    }
+  }
+  if (reply < 0) return false;
+
+  _reply[0]         = _address;
+  _reply[reply + 1] = '\r';
+  _reply[reply + 2] = '\n';
+  _bus.sendResponse(_reply, reply + 3);
+  if (_serviceRequestDue) {
+    _serviceRequestDue = false;
+    sendServiceRequest();
+  }
+  return true;
+}
+
+int SDI12Sensor::startMeasurement(const char* body, char* reply) {
+  // M or C, then C for a CRC, then the index
+  bool        concurrent = body[0] == 'C';
+  const char* c          = body + 1;
+  bool        crc        = *c == 'C';
+  if (crc) c++;
+  uint8_t index = 0;
+  if (*c >= '1' && *c <= '9') index = *c++ - '0';
+  if (*c != '\0') return SDI12_NO_REPLY;
+
+  // The old values can't be read once a new measurement has started.  It is set up
+  // before the handler is called, so the handler can finish it straight away.
+  _pages->clear();
+  _measuring      = concurrent ? MEASURING_CONCURRENT : MEASURING;
+  _measureCrc     = crc;
+  _measureIndex   = index;
+  _measureSeconds = 0xFFFF;
+
+  uint16_t seconds = 0;
+  uint8_t  count   = 0;
+  bool     started = _measureHandler(*this, index, &seconds, &count);
+  if (seconds > 999) seconds = 999;
+  if (count > (concurrent ? 99 : 9)) count = concurrent ? 99 : 9;
+  _measureSeconds = seconds;
+  if (!started) {
+    _measuring = NOT_MEASURING;
+    return SDI12_NO_REPLY;
+  }
+  // finished by the handler: the service request, if any, follows this reply
+  if (_measuring == NOT_MEASURING && !concurrent && seconds > 0) {
+    _serviceRequestDue = true;
+  }
+
+  // atttn, or atttnn for a concurrent measurement
+  reply[0]       = '0' + seconds / 100;
+  reply[1]       = '0' + seconds / 10 % 10;
+  reply[2]       = '0' + seconds % 10;
+  uint8_t length = 3;
+  if (concurrent) reply[length++] = '0' + count / 10;
+  reply[length++] = '0' + count % 10;
+  return length;
+}
+
+bool SDI12Sensor::finishMeasurement(const float* values, uint8_t count) {
+  if (_measuring == NOT_MEASURING || !_pages) return false;
+  bool concurrent = _measuring == MEASURING_CONCURRENT;
+  _measuring      = NOT_MEASURING;
+  _pages->set(values, count, concurrent ? SDI12_PAGE_SIZE_C : SDI12_PAGE_SIZE_M,
+              _measureCrc ? _address : '\0');
+  // the recorder is waiting for the service request after aM!, but not after aC! or
+  // once it has been told the values are ready at once; while the handler is still
+  // running, it's up to startMeasurement()
+  if (!concurrent && _measureSeconds != 0 && _measureSeconds != 0xFFFF) {
+    sendServiceRequest();
+  }
+  return true;
+}
+
+void SDI12Sensor::sendServiceRequest() {
+  char serviceRequest[3] = {_address, '\r', '\n'};
+  _bus.sendResponse(serviceRequest, 3);
+}
@@ -0,0 +1,342 @@
+/**
+ * @file SDI12Sensor.h
+ * @copyright (c) 2013-2020 Stroud Water Research Center (SWRC)
+ *                          and the EnviroDIY Development Team
+ *            This library is published under the BSD-3 license.
+ *
+ * @brief This file contains the SDI12Sensor class, which makes the board act as an
+ * SDI-12 sensor (slave) and answers commands from a table of handlers.
+ */
+
+/* ======================== Arduino SDI-12 =================================
+An Arduino library for SDI-12 communication with a wide variety of environmental
+sensors. This library provides a general software solution, without requiring
+   ======================== Arduino SDI-12 =================================*/
+
+#ifndef SRC_SDI12_SENSOR_H_
+#define SRC_SDI12_SENSOR_H_
+
+#include "SDI12.h"
+
+#ifndef SDI12_SENSOR_COMMAND_SIZE
+/**
+ * @brief The longest command kept, with the address but without the '!'.
+ *
+ * Longer commands are cut short; the longest standard command is 6 characters
+ * (aHB9..!), but extended (aX) commands can be longer.
+ */
+#define SDI12_SENSOR_COMMAND_SIZE 32
+#endif
+
+#ifndef SDI12_SENSOR_REPLY_SIZE
+/**
+ * @brief The size of the reply buffer.
+ *
+ * Room for the address, the 75 characters of values allowed in the reply to a
+ * concurrent measurement's data command, a 3 character CRC, the <CR><LF> and a null.
+ */
+#define SDI12_SENSOR_REPLY_SIZE 82
+#endif
+
+/**
+ * @brief The value a command handler returns to send no reply at all
+ */
+#define SDI12_NO_REPLY -1
+
+class SDI12Sensor;
+class SDI12DataPages;
+class SDI12SensorNode;
+
+/**
+ * @brief A command handler.
+ *
+ * @param sensor The sensor the command was sent to
+ * @param command The command, without the address or the '!', null terminated, e.g.
+ * "M1" or "D0"
+ * @param reply Where to write the reply, without the address or the <CR><LF>; it
+ * doesn't need to be null terminated
+ * @param size The most characters that can be written to reply
+ * @return **int** The number of characters written to reply, or #SDI12_NO_REPLY
+ */
+typedef int (*SDI12CommandHandler)(SDI12Sensor& sensor, const char* command,
+                                   char* reply, uint8_t size);
+
+/**
+ * @brief A measurement handler, which starts a measurement and returns without waiting
+ * for it.
+ *
+ * @param sensor The sensor the measurement command was sent to
+ * @param index The measurement index: 0 for aM! and aC!, 1-9 for aM1! to aM9! and
+ * aC1! to aC9!
+ * @param seconds Set to the most seconds the measurement can take, 0-999
+ * @param count Set to the number of values it will return, at most 9 for aM! and 99
+ * for aC!
+ * @return **bool** True if the measurement was started; if not, there is no reply
+ *
+ * The measurement is already running when the handler is called, so if the values are
+ * ready at once it can call SDI12Sensor::finishMeasurement() itself and give 0 seconds.
+ */
+typedef bool (*SDI12MeasureHandler)(SDI12Sensor& sensor, uint8_t index,
+                                    uint16_t* seconds, uint8_t* count);
+
+/**
+ * @brief One entry in an SDI12Sensor's command table.
+ */
+struct SDI12Command {
+  /**
+   * @brief The start of the commands this handles, without the address, e.g. "M" for
+   * aM! and aM1! to aM9!, or "MC" for just the measurements with a CRC
+   */
+  const char* prefix;
+  /** @brief The handler */
+  SDI12CommandHandler handler;
+};
+
+/**
+ * @brief Makes the board act as an SDI-12 sensor (slave).
+ *
+ * Commands addressed to the sensor are answered by the first entry in the command
+ * table whose prefix they start with, so more specific prefixes go first.  The
+ * acknowledge (a!) and address query (?!) commands are answered by the sensor itself,
+ * and so is change address (aAb!) unless the table has an "A" entry, and so are the
+ * data commands (aD0! to aD9!) if it has no "D" entry and has been given
+ * SDI12DataPages.  Commands with no handler get no reply, as the standard requires.
+ *
+ * The measurement commands (aM!, aMC!, aC!, aCC! and their aM1!-aM9! forms) can be
+ * left to the sensor too, with setMeasureHandler() and setDataPages(): the handler
+ * starts the measurement and says how long it will take, the sensor replies, and the
+ * program calls finishMeasurement() with the values whenever they are ready.  That
+ * formats them into the pages, with the CRC if one was asked for, and for aM! sends
+ * the service request at once, so the recorder can collect the data without waiting
+ * out the time given.  A command to the sensor's address before then aborts the
+ * measurement; ?! doesn't.
+ *
+ * @code{.cpp}
+ *     int identify(SDI12Sensor&, const char*, char* reply, uint8_t size) {
+ *       return snprintf(reply, size, "14MYCOMPNYSENSOR001SN1234");
+ *     }
+ *     const SDI12Command commands[] = {{"I", identify}, {"M", measure}, {"D", data}};
+ *     SDI12       bus(DATA_PIN);
+ *     SDI12Sensor sensor(bus, '5', commands, 3);
+ *
+ *     void setup() { sensor.begin(); }
+ *     void loop()  { sensor.poll(); }
+ * @endcode
+ *
+ * The received commands end at the '!', which the receive ISR queues like any other
+ * line end, and replies are built in static buffers, so nothing is allocated.
+ * The reply has to start within 15 ms of the end of the command, including the
+ * 8.33 ms of marking before it, so poll() must be called at least every 5 ms or so
+ * and the handlers must be quick; start anything slow and answer later.
+ *
+ * Built with `SDI12_BREAK_DETECT` and `SDI12_ADDRESS_FILTER`, the receive ISR only
+ * buffers the commands for this sensor's address, and ?!, so the traffic to and from
+ * the other sensors on the bus costs neither buffer space nor parsing.
+ */
+class SDI12Sensor {
+ public:
+  /**
+   * @brief Construct a new SDI12Sensor
+   *
+   * @param bus The SDI-12 bus
+   * @param address The sensor's address
+   * @param commands The command table; it must stay alive
+   * @param commandCount The number of entries in the command table
+   */
+  SDI12Sensor(SDI12& bus, char address, const SDI12Command* commands,
+              uint8_t commandCount);
+
+  /**
+   * @brief Start the bus and listen for commands
+   */
+  void begin();
+  /**
+   * @brief Answer the next command waiting, if there is one
+   *
+   * @return **bool** True if a reply was sent
+   */
+  bool poll();
+
+  /**
+   * @brief Get the sensor's address
+   *
+   * @return **char** The address
+   */
+  char getAddress() {
+    return _address;
+  }
+  /**
+   * @brief Set the sensor's address
+   *
+   * @param address The new address
+   * @return **bool** True if the address is valid
+   */
+  bool setAddress(char address);
+  /**
+   * @brief Answer the data commands from a set of pages
+   *
+   * @param pages The pages, or NULL; they must stay alive
+   */
+  void setDataPages(SDI12DataPages* pages);
+  /**
+   * @brief Get the pages set by setDataPages()
+   *
+   * @return **SDI12DataPages*** The pages, or NULL
+   */
+  SDI12DataPages* getDataPages() {
+    return _pages;
+  }
+  /**
+   * @brief Answer the measurement commands by starting measurements in the background
+   *
+   * @param handler The handler that starts a measurement, or NULL; entries in the
+   * command table still come first
+   */
+  void setMeasureHandler(SDI12MeasureHandler handler) {
+    _measureHandler = handler;
+  }
+  /**
+   * @brief Hand over the values of the measurement that is running.
+   *
+   * They are formatted into the data pages, and for aM! the service request is sent,
+   * unless the measure handler gave 0 seconds.  If the handler calls this itself, the
+   * service request goes out after the reply to aM!.  Call this from the main program,
+   * not an interrupt.
+   *
+   * @param values The values
+   * @param count The number of values
+   * @return **bool** False if no measurement is running, because it was never started
+   * or has been aborted
+   */
+  bool finishMeasurement(const float* values, uint8_t count);
+  /**
+   * @brief Check whether a measurement started by the measure handler is running
+   *
+   * @return **bool** True until finishMeasurement() is called or the measurement is
+   * aborted
+   */
+  bool isMeasuring() {
+    return _measuring != NOT_MEASURING;
+  }
+  /**
+   * @brief Get the index of the measurement that is running
+   *
+   * @return **uint8_t** 0 for aM! or aC!, 1-9 for aM1! to aM9! or aC1! to aC9!
+   */
+  uint8_t getMeasureIndex() {
+    return _measureIndex;
+  }
+  /**
+   * @brief Set a pointer for the command handlers to use
+   *
+   * @param context The pointer
+   */
+  void setContext(void* context) {
+    _context = context;
+  }
+  /**
+   * @brief Get the pointer set by setContext()
+   *
+   * @return **void*** The pointer
+   */
+  void* getContext() {
+    return _context;
+  }
+  /**
+   * @brief Get the bus the sensor is on
+   *
+   * @return **SDI12&** The bus
+   */
+  SDI12& getBus() {
+    return _bus;
+  }
+
+  /**
+   * @brief Check whether a character is a valid SDI-12 address: '0'-'9', 'a'-'z' or
+   * 'A'-'Z'
+   *
+   * @param address The character
+   * @return **bool** True if it is a valid address
+   */
+  static bool isValidAddress(char address);
+
+ private:
+  /** @brief The bus */
+  SDI12& _bus;
+  /** @brief The sensor's address */
+  char _address;
+  /** @brief The command table */
+  const SDI12Command* _commands;
+  /** @brief The number of entries in the command table */
+  uint8_t _commandCount;
+  /** @brief The pointer set by setContext() */
+  void* _context = NULL;
+  /** @brief The pages set by setDataPages() */
+  SDI12DataPages* _pages = NULL;
+  /** @brief The node the sensor is on, if it is one of several virtual sensors */
+  SDI12SensorNode* _node = NULL;
+  /** @brief The handler set by setMeasureHandler() */
+  SDI12MeasureHandler _measureHandler = NULL;
+  /** @brief The kinds of measurement that can be running */
+  typedef enum MeasureState : uint8_t {
+    /** None */
+    NOT_MEASURING = 0,
+    /** aM!, which ends with a service request */
+    MEASURING,
+    /** aC! */
+    MEASURING_CONCURRENT
+  } MeasureState;
+  /** @brief What kind of measurement is running */
+  MeasureState _measuring = NOT_MEASURING;
+  /** @brief True if the measurement that is running was asked for with a CRC */
+  bool _measureCrc = false;
+  /** @brief The index of the measurement that is running */
+  uint8_t _measureIndex = 0;
+  /** @brief The seconds the measure handler gave, or 0xFFFF while it is running */
+  uint16_t _measureSeconds = 0;
+  /** @brief True if the service request has to follow the reply being sent */
+  bool _serviceRequestDue = false;
+
+  /** @brief The command being handled, null terminated */
+  static char _command[SDI12_SENSOR_COMMAND_SIZE + 1];
+  /** @brief The reply being built */
+  static char _reply[SDI12_SENSOR_REPLY_SIZE];
+
+  /**
+   * @brief Read the next command from the bus into _command
+   *
+   * @param bus The bus
+   * @return **const char*** The command, starting at the address, or NULL if there
+   * are no more
+   */
+  static const char* nextCommand(SDI12& bus);
+  /**
+   * @brief Run the handler for a command and send the reply
+   *
+   * @param command The command, starting at the address, which is this sensor's or
+   * '?'
+   * @return **bool** True if a reply was sent
+   */
+  bool answer(const char* command);
+  /**
+   * @brief Start a measurement with the measure handler
+   *
+   * @param body The command, after the address, e.g. "MC1"
+   * @param reply Where to write the reply
+   * @return **int** The length of the reply, or #SDI12_NO_REPLY
+   */
+  int startMeasurement(const char* body, char* reply);
+  /**
+   * @brief Send the service request for the measurement that has finished
+   */
+  void sendServiceRequest();
+  /**
+   * @brief Have the receive ISR drop the commands for other addresses, if the library
+   * is built with `SDI12_ADDRESS_FILTER`
+   */
+  void updateAddressFilter();
+
+  friend class SDI12SensorNode;
+};
+
+#endif  // SRC_SDI12_SENSOR_H_
@@ -0,0 +1,73 @@
+/**
+ * @file SDI12SensorNode.cpp
+ * @copyright (c) 2013-2020 Stroud Water Research Center (SWRC)
+ *                          and the EnviroDIY Development Team
+ *            This library is published under the BSD-3 license.
+ *
+ * @brief This file implements the SDI12SensorNode class, which makes the board act as
+ * several SDI-12 sensors on one bus.
+ */
+
+/* ======================== Arduino SDI-12 =================================
+An Arduino library for SDI-12 communication with a wide variety of environmental
+sensors. This library provides a general software solution, without requiring
+   ======================== Arduino SDI-12 =================================*/
+
+#include "SDI12SensorNode.h"
+
+SDI12SensorNode::SDI12SensorNode(SDI12& bus, SDI12Sensor* const* sensors,
+                                 uint8_t sensorCount)
+    : _bus(bus),
+      _sensors(sensors),
+      _sensorCount(sensorCount) {}
+
+void SDI12SensorNode::begin() {
+  _bus.begin();
+  _bus.setLineTerminator('!');  // commands end with '!'
+  _bus.forceListen();
+  for (uint8_t i = 0; i < _sensorCount; i++) { _sensors[i]->_node = this; }
+  reindex();
+}
+
+bool SDI12SensorNode::poll() {
+  const char* command;
+  while ((command = SDI12Sensor::nextCommand(_bus)) != NULL) {
+    SDI12Sensor* sensor = command[0] == '?'
+        ? (_sensorCount > 0 ? _sensors[0] : NULL)
+        : find(command[0]);
+    if (sensor && sensor->answer(command)) return true;
+  }
+  return false;
+}
+
+SDI12Sensor* SDI12SensorNode::find(char address) {
+  int8_t i = indexOf(address);
+  if (i < 0 || _index[i] == 0) return NULL;
+  return _sensors[_index[i] - 1];
+}
+
+int8_t SDI12SensorNode::indexOf(char address) {
+  if (address >= '0' && address <= '9') return address - '0';
+  if (address >= 'A' && address <= 'Z') return address - 'A' + 10;
+  if (address >= 'a' && address <= 'z') return address - 'a' + 36;
+  return -1;
+}
+
+void SDI12SensorNode::reindex() {
+  memset(_index, 0, sizeof(_index));
+  // if two sensors share an address, the first one gets it
+  for (uint8_t i = _sensorCount; i > 0; i--) {
+    int8_t place = indexOf(_sensors[i - 1]->getAddress());
+    if (place >= 0) _index[place] = i;
+  }
+#if defined(SDI12_ADDRESS_FILTER) && defined(SDI12_BREAK_DETECT) && \
+  defined(SDI12_EXTENDED_TIMER)
+  char    addresses[63];
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < _sensorCount && count < sizeof(addresses) - 1; i++) {
+    addresses[count++] = _sensors[i]->getAddress();
+  }
+  addresses[count] = '\0';
+  SDI12::setAddressFilter(addresses);
+#endif
+}
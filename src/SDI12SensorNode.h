@@ -0,0 +1,112 @@
+/**
+ * @file SDI12SensorNode.h
+ * @copyright (c) 2013-2020 Stroud Water Research Center (SWRC)
+ *                          and the EnviroDIY Development Team
+ *            This library is published under the BSD-3 license.
+ *
+ * @brief This file contains the SDI12SensorNode class, which makes the board act as
+ * several SDI-12 sensors on one bus.
+ */
+
+/* ======================== Arduino SDI-12 =================================
+An Arduino library for SDI-12 communication with a wide variety of environmental
+sensors. This library provides a general software solution, without requiring
+   ======================== Arduino SDI-12 =================================*/
+
+#ifndef SRC_SDI12_SENSOR_NODE_H_
+#define SRC_SDI12_SENSOR_NODE_H_
+
+#include "SDI12Sensor.h"
+
+/**
+ * @brief Makes the board act as several SDI-12 sensors, each at its own address, on
+ * one bus.
+ *
+ * Each virtual sensor is an SDI12Sensor, with its own address, command table,
+ * context and data pages; the node reads the commands and hands each to the sensor at
+ * its address, found with a 62 entry index by address character.  The handlers only
+ * start measurements, so a measurement started on one sensor doesn't hold up the
+ * others, and concurrent measurements (aC!) sent to all of them run at the same time.
+ *
+ * @code{.cpp}
+ *     SDI12Sensor probe1(bus, '1', commands, 4);
+ *     SDI12Sensor probe2(bus, '2', commands, 4);
+ *     SDI12Sensor* const probes[] = {&probe1, &probe2};
+ *     SDI12SensorNode    node(bus, probes, 2);
+ *
+ *     void setup() { node.begin(); }
+ *     void loop()  { node.poll(); }
+ * @endcode
+ *
+ * Call the node's begin() and poll() instead of the sensors'.  A change address
+ * command (aAb!) to an address another virtual sensor has gets no reply.  Only one
+ * sensor may be on the bus for an address query (?!), so the first virtual sensor
+ * answers it.
+ */
+class SDI12SensorNode {
+ public:
+  /**
+   * @brief Construct a new SDI12SensorNode
+   *
+   * @param bus The SDI-12 bus
+   * @param sensors The virtual sensors, all on the same bus; the array must stay alive
+   * @param sensorCount The number of virtual sensors
+   */
+  SDI12SensorNode(SDI12& bus, SDI12Sensor* const* sensors, uint8_t sensorCount);
+
+  /**
+   * @brief Start the bus and listen for commands to any of the sensors
+   */
+  void begin();
+  /**
+   * @brief Answer the next command waiting, if there is one
+   *
+   * @return **bool** True if a reply was sent
+   */
+  bool poll();
+  /**
+   * @brief Find the virtual sensor at an address
+   *
+   * @param address The address
+   * @return **SDI12Sensor*** The sensor, or NULL if there is none there
+   */
+  SDI12Sensor* find(char address);
+  /**
+   * @brief Get the bus the sensors are on
+   *
+   * @return **SDI12&** The bus
+   */
+  SDI12& getBus() {
+    return _bus;
+  }
+
+ private:
+  /** @brief The bus */
+  SDI12& _bus;
+  /** @brief The virtual sensors */
+  SDI12Sensor* const* _sensors;
+  /** @brief The number of virtual sensors */
+  uint8_t _sensorCount;
+  /**
+   * @brief One more than the index in _sensors of the sensor at each address, or 0;
+   * see indexOf()
+   */
+  uint8_t _index[62] = {0};
+
+  /**
+   * @brief Get the place of an address in _index: '0'-'9' are 0-9, 'A'-'Z' are 10-35
+   * and 'a'-'z' are 36-61
+   *
+   * @param address The address
+   * @return **int8_t** The place, or -1 if the address isn't valid
+   */
+  static int8_t indexOf(char address);
+  /**
+   * @brief Rebuild the index, and the address filter, after an address has changed
+   */
+  void reindex();
+
+  friend class SDI12Sensor;
+};
+
+#endif  // SRC_SDI12_SENSOR_NODE_H_
@@ -43,8 +43,15 @@ void SDI12Timer::configSDI12TimerPrescale(void) {
                   // OC2B disconnected
   TCCR2B = 0x07;  // TCCR2B = 0x07 = 0b00000111 - Clock Select bits 22, 21, & 20 on -
                   // prescaler set to CK/1024
+#if defined(SDI12_EXTENDED_TIMESTAMPS)
+  TIFR2 = _BV(TOV2);  // clear any old overflow
+  TIMSK2 |= _BV(TOIE2);  // count overflows for the extended timer
+#endif
 }
 void SDI12Timer::resetSDI12TimerPrescale(void) {
+#if defined(SDI12_EXTENDED_TIMESTAMPS)
+  TIMSK2 &= ~_BV(TOIE2);
+#endif
   TCCR2A = preSDI12_TCCR2A;
   TCCR2B = preSDI12_TCCR2B;
 }
@@ -58,8 +65,15 @@ void SDI12Timer::configSDI12TimerPrescale(void) {
                   // OC2B disconnected
   TCCR2B = 0x07;  // TCCR2B = 0x07 = 0b00000111 - Clock Select bits 22, 21, & 20 on -
                   // prescaler set to CK/1024
+#if defined(SDI12_EXTENDED_TIMESTAMPS)
+  TIFR2 = _BV(TOV2);  // clear any old overflow
+  TIMSK2 |= _BV(TOIE2);  // count overflows for the extended timer
+#endif
 }
 void SDI12Timer::resetSDI12TimerPrescale(void) {
+#if defined(SDI12_EXTENDED_TIMESTAMPS)
+  TIMSK2 &= ~_BV(TOIE2);
+#endif
   TCCR2A = preSDI12_TCCR2A;
   TCCR2B = preSDI12_TCCR2B;
 }
@@ -73,8 +87,15 @@ void SDI12Timer::configSDI12TimerPrescale(void) {
                   // OC2B disconnected
   TCCR2B = 0x06;  // TCCR2B = 0x06 = 0b00000110 - Clock Select bits 22 & 20 on -
                   // prescaler set to CK/256
+#if defined(SDI12_EXTENDED_TIMESTAMPS)
+  TIFR2 = _BV(TOV2);  // clear any old overflow
+  TIMSK2 |= _BV(TOIE2);  // count overflows for the extended timer
+#endif
 }
 void SDI12Timer::resetSDI12TimerPrescale(void) {
+#if defined(SDI12_EXTENDED_TIMESTAMPS)
+  TIMSK2 &= ~_BV(TOIE2);
+#endif
   TCCR2A = preSDI12_TCCR2A;
   TCCR2B = preSDI12_TCCR2B;
 }
@@ -94,6 +115,67 @@ void SDI12Timer::resetSDI12TimerPrescale(void) {
 // }
 #endif
 
+#if defined(SDI12_EXTENDED_TIMESTAMPS)
+
+/**
+ * @brief The number of times timer 2 has overflowed; the upper 24 bits of the extended
+ * timer.
+ */
+static volatile uint32_t sdi12TimerOverflows = 0;
+
+uint32_t SDI12Timer::SDI12TimerReadExtended(void) {
+  uint8_t oldSREG = SREG;
+  cli();
+  uint32_t overflows = sdi12TimerOverflows;
+  uint8_t  ticks     = TCNT2;
+  // If the timer has overflowed but the interrupt hasn't run yet (because interrupts
+  // are off) count the overflow here
+  if ((TIFR2 & _BV(TOV2)) && (ticks < 255)) overflows++;
+  SREG = oldSREG;
+  return (overflows << 8) | ticks;
+}
+void SDI12Timer::SDI12TimerOverflow(void) {
+  sdi12TimerOverflows++;
+}
+
+#endif
+
+#if defined(SDI12_INPUT_CAPTURE)
+
+/**
+ * @brief The value of the capture timer's control register A prior to being set for
+ * SDI-12.
+ */
+static uint8_t preSDI12_ICP_TCCRA;
+/**
+ * @brief The value of the capture timer's control register B prior to being set for
+ * SDI-12.
+ */
+static uint8_t preSDI12_ICP_TCCRB;
+
+void SDI12Timer::configSDI12InputCapture(void) {
+  preSDI12_ICP_TCCRA = SDI12_ICP_TCCRA;
+  preSDI12_ICP_TCCRB = SDI12_ICP_TCCRB;
+  // No capture interrupts until we start listening
+  SDI12_ICP_TIMSK &= ~_BV(SDI12_ICP_ICIE);
+  SDI12_ICP_TCCRA = 0x00;  // 0x00 = "normal" operation - Normal port operation, OCnA &
+                           // OCnB disconnected
+#if F_CPU == 8000000L
+  SDI12_ICP_TCCRB = 0x84;  // 0x84 = 0b10000100 - Input capture noise canceler on,
+                           // Clock Select bit n2 on - prescaler set to CK/256
+#else
+  SDI12_ICP_TCCRB = 0x85;  // 0x85 = 0b10000101 - Input capture noise canceler on,
+                           // Clock Select bits n2 & n0 on - prescaler set to CK/1024
+#endif
+}
+void SDI12Timer::resetSDI12InputCapture(void) {
+  SDI12_ICP_TIMSK &= ~_BV(SDI12_ICP_ICIE);
+  SDI12_ICP_TCCRA = preSDI12_ICP_TCCRA;
+  SDI12_ICP_TCCRB = preSDI12_ICP_TCCRB;
+}
+
+#endif
+
 
 // ATtiny boards (ie, adafruit trinket)
 //
@@ -244,9 +326,17 @@ void SDI12Timer::configSDI12TimerPrescale(void) {
     TC_CTRLA_MODE_COUNT8 |        // Put the timer TC3 into 8-bit mode
     TC_CTRLA_ENABLE;              // Enable TC3
   while (TC3->COUNT16.STATUS.bit.SYNCBUSY) {}  // Wait for synchronization
+#if defined(SDI12_EXTENDED_TIMESTAMPS)
+  TC3->COUNT8.INTFLAG.reg  = TC_INTFLAG_OVF;  // clear any old overflow
+  TC3->COUNT8.INTENSET.reg = TC_INTENSET_OVF;  // count overflows for the extended timer
+  NVIC_EnableIRQ(TC3_IRQn);
+#endif
 }
 // NOT resetting the SAMD timer settings
 void SDI12Timer::resetSDI12TimerPrescale(void) {
+#if defined(SDI12_EXTENDED_TIMESTAMPS)
+  NVIC_DisableIRQ(TC3_IRQn);
+#endif
   // Disable TCx
   TC3->COUNT16.CTRLA.reg &= ~TC_CTRLA_ENABLE;
   while (TC3->COUNT16.STATUS.bit.SYNCBUSY) {}
@@ -262,17 +352,66 @@ void SDI12Timer::resetSDI12TimerPrescale(void) {
   while (GCLK->STATUS.bit.SYNCBUSY) {}     // Wait for synchronization
 }
 
+#if defined(SDI12_EXTENDED_TIMESTAMPS)
+
+/**
+ * @brief The number of times TC3 has overflowed; the upper 24 bits of the extended
+ * timer.
+ */
+static volatile uint32_t sdi12TimerOverflows = 0;
+
+uint32_t SDI12Timer::SDI12TimerReadExtended(void) {
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  uint32_t overflows = sdi12TimerOverflows;
+  uint8_t  ticks     = REG_TC3_COUNT8_COUNT;
+  // If the timer has overflowed but the interrupt hasn't run yet (because interrupts
+  // are off) count the overflow here
+  if (TC3->COUNT8.INTFLAG.bit.OVF && (ticks < 255)) overflows++;
+  __set_PRIMASK(primask);
+  return (overflows << 8) | ticks;
+}
+void SDI12Timer::SDI12TimerOverflow(void) {
+  TC3->COUNT8.INTFLAG.reg = TC_INTFLAG_OVF;
+  sdi12TimerOverflows++;
+}
+
+#endif
+
 // Espressif ESP32/ESP8266 boards
 //
 #elif defined(ESP32) || defined(ESP8266)
 
 void         SDI12Timer::configSDI12TimerPrescale(void) {}
 void         SDI12Timer::resetSDI12TimerPrescale(void) {}
-sdi12timer_t SDI12Timer::SDI12TimerRead(void) {
+#if defined(SDI12_ESP_CYCLE_COUNTER)
+sdi12timer_t SDI12_ISR_ATTR SDI12Timer::SDI12TimerRead(void) {
+  // The cycle counter is one CPU register, read in a single instruction
+  return ((sdi12timer_t)(ESP.getCycleCount() >> SDI12_CYCLE_COUNTER_SHIFT));
+}
+#else
+sdi12timer_t SDI12_ISR_ATTR SDI12Timer::SDI12TimerRead(void) {
   // Its a one microsecond clock but we want 64uS ticks so divide by 64 i.e. right shift
   // 6
   return ((sdi12timer_t)(micros() >> 6));
 }
+#endif
+#if defined(SDI12_EXTENDED_TIMESTAMPS)
+uint32_t SDI12_ISR_ATTR SDI12Timer::SDI12TimerReadExtended(void) {
+#if defined(ESP32)
+  uint64_t us = esp_timer_get_time();
+#else
+  uint64_t us = micros64();
+#endif
+#if defined(SDI12_ESP_CYCLE_COUNTER)
+  // Scale to the same ticks as the cycle counter; the low bits won't line up exactly
+  // with SDI12TimerRead(), but only differences between these are ever used
+  return (uint32_t)((us * (F_CPU / 1000000L)) >> SDI12_CYCLE_COUNTER_SHIFT);
+#else
+  return (uint32_t)(us >> 6);
+#endif
+}
+#endif
 // Unknown board
 #else
 #error "Please define your board timer and pins"
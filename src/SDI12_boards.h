@@ -21,9 +21,55 @@ sensors. This library provides a general software solution, without requiring
 #if defined(ESP32) || defined(ESP8266)
 /** The interger type (size) of the timer return value */
 typedef uint32_t sdi12timer_t;
+/**
+ * @brief The attribute for everything called from the receive interrupt.
+ *
+ * On espressif boards (ESP8266 and ESP32), the ISR and every function it calls must be
+ * stored in IRAM.  Code in flash has to be fetched through the cache, which can take
+ * tens of microseconds on a miss, and crashes if the cache is disabled by a flash
+ * write when the interrupt fires.
+ */
+#define SDI12_ISR_ATTR ICACHE_RAM_ATTR
 #else
 /** The interger type (size) of the timer return value */
 typedef uint8_t sdi12timer_t;
+/** @copydoc SDI12_ISR_ATTR */
+#define SDI12_ISR_ATTR
+#endif
+
+#if (defined(__AVR_ATmega168__) || defined(__AVR_ATmega328P__)) && \
+  defined(NUM_DIGITAL_PINS) && NUM_DIGITAL_PINS == 20
+/**
+ * @brief Defined when the digital pin to port mapping is known at compile time.
+ *
+ * The "standard" ATmega168/328P variant (Uno, Nano, Pro Mini, etc) maps digital pins
+ * 0-7 to PORTD, 8-13 to PORTB, and 14-19 (A0-A5) to PORTC.  The Arduino core only
+ * exposes the mapping as tables in flash, which the compiler cannot see through, so it
+ * is repeated here.
+ */
+#define SDI12_FIXED_PIN_MAP
+
+/**
+ * @brief Compile time access to a digital pin on a board with a fixed pin map.
+ *
+ * @tparam pin The digital pin number, 0-19; any other pin fails to compile
+ */
+template <int8_t pin>
+struct SDI12FixedPin {
+  static_assert(pin >= 0 && pin < NUM_DIGITAL_PINS,
+                "SDI12FixedPin: the standard ATmega168/328P map has digital pins 0-19");
+  /**
+   * @brief Read the pin; with a constant pin this is a single bit test on the port.
+   *
+   * @return **uint8_t** HIGH or LOW
+   */
+  static inline uint8_t read() {
+    return ((pin < 8 ? PIND : (pin < 14 ? PINB : PINC)) &
+            (1 << (pin < 8 ? pin : (pin < 14 ? pin - 8 : pin - 14))))
+      ? HIGH
+      : LOW;
+  }
+};
 #endif
 
 /**
@@ -117,6 +163,20 @@ class SDI12Timer {
  * @see https://github.com/SlashDevin/NeoSWSerial/pull/13
  */
 #define RX_WINDOW_FUDGE 2
+/**
+ * @brief The number of "ticks" of the timer between samples of the oversampling
+ * receiver (`SDI12_OVERSAMPLE`), which takes 4 samples per bit, shifted by 2^8.
+ *
+ * (13.0208 ticks/bit) / (4 samples/bit) = 3.2552 ticks/sample
+ * 3.2552 * 2^8 = 833.33
+ */
+#define TICKS_PER_SAMPLE_Q8 833
+/**
+ * @brief The length of one "tick" of the timer in microseconds.
+ *
+ * 1024 prescaler / 16MHz = 64 µs / 'tick'
+ */
+#define MICROS_PER_TICK 64
 
 #elif F_CPU == 12000000L
 /**
@@ -148,6 +208,21 @@ class SDI12Timer {
  * @see https://github.com/SlashDevin/NeoSWSerial/pull/13
  */
 #define RX_WINDOW_FUDGE 2
+/**
+ * @brief The number of "ticks" of the timer between samples of the oversampling
+ * receiver (`SDI12_OVERSAMPLE`), which takes 4 samples per bit, shifted by 2^8.
+ *
+ * (9.765625 ticks/bit) / (4 samples/bit) = 2.4414 ticks/sample
+ * 2.4414 * 2^8 = 625
+ */
+#define TICKS_PER_SAMPLE_Q8 625
+/**
+ * @brief The length of one "tick" of the timer in microseconds.
+ *
+ * 1024 prescaler / 12MHz = 85.333 µs / 'tick'
+ * @note This is rounded down, so times converted with it read about 0.4% short.
+ */
+#define MICROS_PER_TICK 85
 
 #elif F_CPU == 8000000L
 /**
@@ -180,6 +255,20 @@ class SDI12Timer {
  * @see https://github.com/SlashDevin/NeoSWSerial/pull/13
  */
 #define RX_WINDOW_FUDGE 10
+/**
+ * @brief The number of "ticks" of the timer between samples of the oversampling
+ * receiver (`SDI12_OVERSAMPLE`), which takes 4 samples per bit, shifted by 2^8.
+ *
+ * (26.04166667 ticks/bit) / (4 samples/bit) = 6.5104 ticks/sample
+ * 6.5104 * 2^8 = 1666.67
+ */
+#define TICKS_PER_SAMPLE_Q8 1667
+/**
+ * @brief The length of one "tick" of the timer in microseconds.
+ *
+ * 256 prescaler / 8MHz = 32 µs / 'tick'
+ */
+#define MICROS_PER_TICK 32
 
   // #define PRESCALE_IN_USE_STR "1024"
   // #define TICKS_PER_BIT 6
@@ -191,6 +280,101 @@ class SDI12Timer {
 
 #endif
 
+#if defined(SDI12_EXTENDED_TIMESTAMPS)
+/**
+ * @brief Defined when the board can extend the SDI-12 timer to 32 bits.
+ */
+#define SDI12_EXTENDED_TIMER
+  /**
+   * @brief Read the SDI-12 timer extended to 32 bits.
+   *
+   * The upper 24 bits are a count of timer 2 overflows kept by the overflow interrupt,
+   * so the result keeps counting in the same ticks as #TCNTX for over 3 days at 16MHz.
+   * Safe to call from an ISR.
+   *
+   * @return **uint32_t** The current extended timer value
+   */
+  uint32_t SDI12TimerReadExtended(void);
+  /**
+   * @brief Count one overflow of the SDI-12 timer; called from the timer 2 overflow
+   * interrupt.
+   *
+   * @note This takes the timer 2 overflow interrupt; nothing else can use it at the
+   * same time.
+   */
+  static void SDI12TimerOverflow(void);
+#endif
+
+#if defined(SDI12_INPUT_CAPTURE)
+#if defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+/**
+ * @brief The input register of the input capture pin
+ *
+ * ICP1 (PD4) isn't broken out on any Arduino Mega, so timer 4 is used instead; ICP4 is
+ * PL0, digital pin 49.
+ */
+#define SDI12_ICP_PIN_REG PINL
+/**
+ * @brief The bit of the input capture pin within its input register
+ */
+#define SDI12_ICP_PIN_BIT 0
+#define SDI12_ICP_TCCRA TCCR4A /*!< The capture timer's control register A */
+#define SDI12_ICP_TCCRB TCCR4B /*!< The capture timer's control register B */
+#define SDI12_ICP_TIMSK TIMSK4 /*!< The capture timer's interrupt mask register */
+#define SDI12_ICP_TIFR TIFR4   /*!< The capture timer's interrupt flag register */
+#define SDI12_ICP_ICR ICR4     /*!< The capture timer's input capture register */
+#define SDI12_ICP_TCNT TCNT4   /*!< The capture timer's counter */
+#define SDI12_ICP_ICES ICES4   /*!< The capture timer's edge select bit */
+#define SDI12_ICP_ICF ICF4     /*!< The capture timer's capture flag bit */
+#define SDI12_ICP_ICIE ICIE4   /*!< The capture timer's capture interrupt enable bit */
+/** The capture timer's input capture interrupt vector */
+#define SDI12_ICP_vect TIMER4_CAPT_vect
+#else
+#if defined(__AVR_ATmega168__) || defined(__AVR_ATmega328P__)
+/** @copydoc SDI12_ICP_PIN_REG
+ *
+ * ICP1 is PB0, digital pin 8 on an Uno.
+ */
+#define SDI12_ICP_PIN_REG PINB
+/** @copydoc SDI12_ICP_PIN_BIT */
+#define SDI12_ICP_PIN_BIT 0
+#else  // ATmega644(P) and ATmega1284(P)
+/** @copydoc SDI12_ICP_PIN_REG */
+#define SDI12_ICP_PIN_REG PIND
+/** @copydoc SDI12_ICP_PIN_BIT */
+#define SDI12_ICP_PIN_BIT 6
+#endif
+#define SDI12_ICP_TCCRA TCCR1A
+#define SDI12_ICP_TCCRB TCCR1B
+#define SDI12_ICP_TIMSK TIMSK1
+#define SDI12_ICP_TIFR TIFR1
+#define SDI12_ICP_ICR ICR1
+#define SDI12_ICP_TCNT TCNT1
+#define SDI12_ICP_ICES ICES1
+#define SDI12_ICP_ICF ICF1
+#define SDI12_ICP_ICIE ICIE1
+#define SDI12_ICP_vect TIMER1_CAPT_vect
+#endif
+
+  /**
+   * @brief Set up the capture timer (timer 1, or timer 4 on a Mega) to time-stamp edges
+   * on the input capture pin.
+   *
+   * The capture timer is run from the same prescaler as the timer used for
+   * transmitting, so captured values are in the same units as #TICKS_PER_BIT.  The
+   * input capture noise canceler is enabled.
+   *
+   * @note This takes over the capture timer; it cannot be used for PWM or Servo at the
+   * same time.
+   */
+  void configSDI12InputCapture(void);
+  /**
+   * @brief Disable the input capture interrupt and put the capture timer back the way it
+   * was before configSDI12InputCapture().
+   */
+  void resetSDI12InputCapture(void);
+#endif
+
 
 // ATtiny boards (ie, adafruit trinket)
 //
@@ -463,10 +647,125 @@ class SDI12Timer {
  * @see https://github.com/SlashDevin/NeoSWSerial/pull/13
  */
 #define RX_WINDOW_FUDGE 2
+/**
+ * @brief The length of one "tick" of the timer in microseconds.
+ *
+ * 1024 prescaler / 16MHz = 64 µs / 'tick'
+ */
+#define MICROS_PER_TICK 64
+
+#if defined(SDI12_EXTENDED_TIMESTAMPS)
+/** @copydoc SDI12_EXTENDED_TIMER */
+#define SDI12_EXTENDED_TIMER
+  /**
+   * @brief Read the SDI-12 timer extended to 32 bits.
+   *
+   * The upper 24 bits are a count of TC3 overflows kept by the TC3 interrupt.  Safe to
+   * call from an ISR.
+   *
+   * @return **uint32_t** The current extended timer value
+   */
+  uint32_t SDI12TimerReadExtended(void);
+  /**
+   * @brief Count one overflow of the SDI-12 timer; called from TC3_Handler().
+   *
+   * @note This takes the TC3 interrupt handler; nothing else can use it at the same
+   * time.
+   */
+  static void SDI12TimerOverflow(void);
+#endif
 
 // Espressif ESP32/ESP8266 boards
 //
 #elif defined(ESP32) || defined(ESP8266)
+#if defined(SDI12_ESP_CYCLE_COUNTER)
+  /**
+   * @brief Read the processor cycle counter and right shift it to get a tick of about
+   * 50-70µs.
+   *
+   * Reading the cycle counter is a single instruction, where micros() has to do a
+   * 64-bit division (ESP8266) or read a peripheral timer under a lock (ESP32).  The
+   * shift is a whole number of bits, so the low 8 bits of the result still roll over
+   * cleanly when the counter does.
+   *
+   * @note  The cycle counter counts at the current CPU frequency and is separate for
+   * each core of an ESP32.  Don't change the CPU frequency while the SDI-12 object is
+   * in use, and keep it on one core.
+   *
+   * @return **sdi12timer_t** The current processor cycle count, in ticks
+   */
+  sdi12timer_t SDI12TimerRead(void);
+
+#if F_CPU == 240000000L
+/**
+ * @brief The number of bits to right shift the processor cycle count to get one "tick"
+ *
+ * 240MHz / 2^14 = 14648.4 'ticks'/sec = 68.2667 µs / 'tick'
+ */
+#define SDI12_CYCLE_COUNTER_SHIFT 14
+/**
+ * @brief The number of "ticks" of the timer that occur within the timing of one bit
+ * at the SDI-12 baud rate of 1200 bits/second.
+ *
+ * (1 sec/1200 bits) * (1 tick/68.2667 µs) = 12.2070 ticks/bit
+ *
+ * The 8-bit count rolls over after 256 ticks, 20.97 bits, or 17.476 ms
+ * (256 ticks/roll-over) * (1 bit/12.2070 ticks) = 20.97 bits
+ */
+#define TICKS_PER_BIT 12
+/**
+ * @brief The number of "ticks" of the timer per SDI-12 bit, shifted by 2^10.
+ *
+ * 1/(12.2070 ticks/bit) * 2^10 = 83.8861
+ */
+#define BITS_PER_TICK_Q10 84
+/**
+ * @brief The length of one "tick" of the timer in microseconds.
+ */
+#define MICROS_PER_TICK 68
+#elif F_CPU == 160000000L || F_CPU == 80000000L
+/**
+ * @brief The number of bits to right shift the processor cycle count to get one "tick"
+ *
+ * 160MHz / 2^13 = 80MHz / 2^12 = 19531.25 'ticks'/sec = 51.2 µs / 'tick'
+ */
+#if F_CPU == 160000000L
+#define SDI12_CYCLE_COUNTER_SHIFT 13
+#else
+#define SDI12_CYCLE_COUNTER_SHIFT 12
+#endif
+/**
+ * @brief The number of "ticks" of the timer that occur within the timing of one bit
+ * at the SDI-12 baud rate of 1200 bits/second.
+ *
+ * (1 sec/1200 bits) * (1 tick/51.2 µs) = 16.2760 ticks/bit
+ *
+ * The 8-bit count rolls over after 256 ticks, 15.73 bits, or 13.107 ms
+ * (256 ticks/roll-over) * (1 bit/16.2760 ticks) = 15.73 bits
+ */
+#define TICKS_PER_BIT 16
+/**
+ * @brief The number of "ticks" of the timer per SDI-12 bit, shifted by 2^10.
+ *
+ * 1/(16.2760 ticks/bit) * 2^10 = 62.9146
+ */
+#define BITS_PER_TICK_Q10 63
+/**
+ * @brief The length of one "tick" of the timer in microseconds.
+ */
+#define MICROS_PER_TICK 51
+#else
+#error "SDI12_ESP_CYCLE_COUNTER needs a CPU frequency of 80, 160, or 240 MHz"
+#endif
+/**
+ * @brief A "fudge factor" to get the Rx to work well.   It mostly works to ensure that
+ * uneven tick increments get rounded up.
+ *
+ * @see https://github.com/SlashDevin/NeoSWSerial/pull/13
+ */
+#define RX_WINDOW_FUDGE 2
+
+#else  // SDI12_ESP_CYCLE_COUNTER
   /**
    * @brief Read the processor micros and right shift 6 bits (ie, divide by 64) to get a
    * 64µs tick.
@@ -508,6 +807,28 @@ class SDI12Timer {
  * @see https://github.com/SlashDevin/NeoSWSerial/pull/13
  */
 #define RX_WINDOW_FUDGE 2
+/**
+ * @brief The length of one "tick" of the timer in microseconds.
+ *
+ * micros() >> 6 = 64 µs / 'tick'
+ */
+#define MICROS_PER_TICK 64
+#endif  // SDI12_ESP_CYCLE_COUNTER
+
+#if defined(SDI12_EXTENDED_TIMESTAMPS)
+/** @copydoc SDI12_EXTENDED_TIMER */
+#define SDI12_EXTENDED_TIMER
+  /**
+   * @brief Read the SDI-12 timer extended to 32 bits.
+   *
+   * SDI12TimerRead() is 32 bits already, but it is made from the 32-bit micros() or
+   * cycle counter so it wraps after at most 71 minutes.  This is made from the 64-bit
+   * microsecond timer instead, scaled to the same ticks, so it keeps counting for days.
+   *
+   * @return **uint32_t** The current extended timer value
+   */
+  uint32_t SDI12TimerReadExtended(void);
+#endif
 
 // Unknown board
 #else
@@ -0,0 +1,270 @@
+/**
+ * @file AsyncBenchmark.ino
+ * @copyright (c) 2013-2020 Stroud Water Research Center (SWRC)
+ *                          and the EnviroDIY Development Team
+ *            This example is published under the BSD-3 license.
+ *
+ * @brief Tool to compare the time to read 20 sensors one after the other, the way
+ * d_simple_logger does, with reading them interleaved with SDI12Async coroutines.
+ *
+ * The sensors are simulated, on a virtual clock, so nothing needs to be attached and
+ * the results are the same on any board.  The model:
+ * - 1200 baud, 8.33 ms a character; a break is 12 ms and is followed by 8.33 ms of
+ * marking
+ * - sensors answer 10 ms after the end of a command, and go back to sleep if the line
+ * has been marking for more than 87 ms, after which they ignore commands without a
+ * break
+ * - sensor n takes 1-3 s to measure, says so in its atttn reply, and returns 2-6
+ * values, at most 3 to a data command
+ *
+ * The sequential flow is the one in d_simple_logger: aM!, wait for the service request,
+ * then aD0!, aD1!, etc, each with a break, including the example's fixed 100 ms and
+ * 30 ms waits and 10 ms per character read.  The interleaved flow starts an aC!
+ * concurrent measurement on every sensor and collects the data as each is ready.
+ *
+ * Needs a board or host where SDI12Async is available (ESP32, or a host build) and
+ * C++20; on ESP32 add `-std=gnu++2a` to the build flags.
+ */
+
+#include <SDI12.h>
+#include <SDI12Async.h>
+
+#define SERIAL_BAUD 115200 /*!< The baud rate for the output serial port */
+#define DATA_PIN 7         /*!< The pin of the SDI-12 data bus; not used */
+#define NUM_SENSORS 20     /*!< The number of simulated sensors */
+#define CHAR_MICROS 8333   /*!< The time to send one character at 1200 baud */
+
+#if !defined(SDI12_ASYNC_AVAILABLE)
+#error SDI12Async needs ESP32 or a host build, and a compiler with C++20 coroutines
+#endif
+
+/** Define the SDI-12 bus; the simulation never touches the pin */
+SDI12 mySDI12(DATA_PIN);
+
+/**
+ * @brief SDI12Async on a virtual clock, with simulated sensors instead of a wire
+ */
+class SimulatedBus : public SDI12Async {
+ public:
+  explicit SimulatedBus(SDI12& bus) : SDI12Async(bus) {}
+
+  /** @brief The virtual time, in µs */
+  uint32_t clock = 0;
+  /** @brief The number of breaks sent */
+  uint16_t breaks = 0;
+  /** @brief The number of commands sent */
+  uint16_t commands = 0;
+
+  /** @brief Reset the clock and the sensors */
+  void reset() {
+    clock = breaks = commands = 0;
+    _lineEnd                  = 0;
+    _pending[0]               = '\0';
+    for (uint8_t i = 0; i < NUM_SENSORS; i++) {
+      _readyAt[i] = 0;
+      _service[i] = false;
+    }
+  }
+
+  static char address(uint8_t n) {
+    return n < 10 ? '0' + n : 'a' + n - 10;
+  }
+  static uint8_t measureSeconds(uint8_t n) {
+    return 1 + n % 3;
+  }
+  static uint8_t valueCount(uint8_t n) {
+    return 2 + n % 5;
+  }
+
+  /** @brief Put a command on the wire and queue the reply, if any */
+  void transmit(const char* command, bool wake) {
+    commands++;
+    bool asleep = clock - _lineEnd > 87000UL;
+    if (wake) {
+      breaks++;
+      clock += 12000;
+    }
+    clock += CHAR_MICROS * (1 + strlen(command));
+    _pending[0] = '\0';
+    if (asleep && !wake) return;
+
+    int8_t n = -1;
+    for (uint8_t i = 0; i < NUM_SENSORS; i++) {
+      if (address(i) == command[0]) n = i;
+    }
+    if (n < 0) return;
+    char        type = command[1];
+    const char* end  = command + strlen(command) - 1;  // the '!'
+    if (type == 'M' || type == 'C') {
+      _readyAt[n] = clock + 1000000UL * measureSeconds(n) - 100000UL * (n % 4);
+      _service[n] = type == 'M';
+      if (type == 'M') {
+        snprintf(_pending, sizeof(_pending), "%c%03u%u", command[0], measureSeconds(n),
+                 valueCount(n));
+      } else {
+        snprintf(_pending, sizeof(_pending), "%c%03u%02u", command[0],
+                 measureSeconds(n), valueCount(n));
+      }
+    } else if (type == 'D' && end - command == 3) {
+      uint8_t page  = command[2] - '0';
+      uint8_t first = page * 3;
+      uint8_t len   = snprintf(_pending, sizeof(_pending), "%c", command[0]);
+      for (uint8_t v = first; v < first + 3 && v < valueCount(n); v++) {
+        len += snprintf(_pending + len, sizeof(_pending) - len, "%+d.%03u", n - 10,
+                        v * 111);
+      }
+    }
+    _pendingAt = clock + 10000UL + CHAR_MICROS * (strlen(_pending) + 2);
+  }
+
+  /** @brief The time the pending reply, or service request, has been sent by */
+  uint32_t nextLineAt() {
+    if (_pending[0]) return _pendingAt;
+    uint32_t next = 0xFFFFFFFF;
+    for (uint8_t i = 0; i < NUM_SENSORS; i++) {
+      uint32_t srEnd = _readyAt[i] + CHAR_MICROS * 3;
+      if (_service[i] && srEnd < next) next = srEnd;
+    }
+    return next;
+  }
+
+  /** @brief Get the pending reply or service request, once it has been sent */
+  bool receive(SDI12Response& response) {
+    if (_pending[0] && (int32_t)(clock - _pendingAt) >= 0) {
+      strcpy(response.text, _pending);
+      response.length = strlen(_pending);
+      _pending[0]     = '\0';
+      _lineEnd        = _pendingAt;
+      return true;
+    }
+    for (uint8_t i = 0; i < NUM_SENSORS; i++) {
+      uint32_t srEnd = _readyAt[i] + CHAR_MICROS * 3;
+      if (_service[i] && (int32_t)(clock - srEnd) >= 0) {
+        _service[i]      = false;
+        response.text[0] = address(i);
+        response.text[1] = '\0';
+        response.length  = 1;
+        _lineEnd         = srEnd;
+        return true;
+      }
+    }
+    return false;
+  }
+
+ protected:
+  void sendCommand(const char* command, bool wake) override {
+    transmit(command, wake);
+  }
+  bool readLine(SDI12Response& response) override {
+    return receive(response);
+  }
+  uint32_t now() override {
+    return clock / 1000;
+  }
+  void idle(uint32_t maxMillis) override {
+    uint32_t until = clock + maxMillis * 1000UL;
+    uint32_t line  = nextLineAt();
+    if (line != 0xFFFFFFFF && (int32_t)(line - until) < 0) until = line;
+    if ((int32_t)(until - clock) > 0) clock = until;
+  }
+
+ private:
+  char     _pending[SDI12_BUFFER_SIZE] = {0};
+  uint32_t _pendingAt                  = 0;
+  uint32_t _lineEnd                    = 0;
+  uint32_t _readyAt[NUM_SENSORS]       = {0};
+  bool     _service[NUM_SENSORS]       = {false};
+};
+
+SimulatedBus bus(mySDI12);
+uint16_t     valuesRead;
+
+/** @brief Wait on the virtual clock for the next line, up to a timeout */
+bool sequentialRead(SDI12Response& response, uint32_t timeoutMillis) {
+  uint32_t deadline = bus.clock + timeoutMillis * 1000UL;
+  while (!bus.receive(response)) {
+    uint32_t next = bus.nextLineAt();
+    if ((int32_t)(next - deadline) > 0) {
+      bus.clock = deadline;
+      return false;
+    }
+    if ((int32_t)(next - bus.clock) > 0) bus.clock = next;
+  }
+  return true;
+}
+
+/** @brief takeMeasurement() and getResults() from d_simple_logger, on the virtual clock */
+void sequentialMeasurement(char address) {
+  SDI12Response r;
+  char          command[5] = {address, 'M', '!', '\0', '\0'};
+  bus.transmit(command, true);
+  bus.clock += 100000UL;  // delay(100)
+  if (!sequentialRead(r, 1000)) return;
+  uint8_t wait     = (r.text[1] - '0') * 100 + (r.text[2] - '0') * 10 + r.text[3] - '0';
+  uint8_t expected = r.text[4] - '0';
+  sequentialRead(r, 1000UL * (wait + 1));  // the service request
+  bus.clock += 30000UL;                    // delay(30)
+
+  uint8_t received = 0;
+  for (char page = '0'; received < expected && page <= '9'; page++) {
+    char data[5] = {address, 'D', page, '!', '\0'};
+    bus.transmit(data, true);
+    uint32_t start = bus.clock;
+    if (!sequentialRead(r, 1500)) break;
+    // it waits for 3 characters, then reads the rest with a 10 ms delay each
+    uint32_t byLoop = start + 10000UL + CHAR_MICROS * 3 + 10000UL * (r.length + 2);
+    if ((int32_t)(byLoop - bus.clock) > 0) bus.clock = byLoop;
+    for (uint8_t i = 1; i < r.length; i++) {
+      if (r.text[i] == '+' || r.text[i] == '-') received++;
+    }
+  }
+  valuesRead += received;
+}
+
+SDI12Task<> logSensor(char address) {
+  SDI12Measurement m = co_await bus.measure(address);
+  valuesRead += m.count;
+}
+
+void printResult(const char* label, uint32_t micros) {
+  Serial.print(label);
+  Serial.print(": ");
+  Serial.print(micros / 1000000.0, 3);
+  Serial.print(" s, ");
+  Serial.print(bus.commands);
+  Serial.print(" commands, ");
+  Serial.print(bus.breaks);
+  Serial.print(" breaks, ");
+  Serial.print(valuesRead);
+  Serial.println(" values");
+}
+
+void setup() {
+  Serial.begin(SERIAL_BAUD);
+  while (!Serial)
+    ;
+
+  uint16_t expected = 0;
+  for (uint8_t n = 0; n < NUM_SENSORS; n++) expected += SimulatedBus::valueCount(n);
+  Serial.print("Simulated sensors: ");
+  Serial.print(NUM_SENSORS);
+  Serial.print(", values: ");
+  Serial.println(expected);
+
+  bus.reset();
+  valuesRead = 0;
+  for (uint8_t n = 0; n < NUM_SENSORS; n++) {
+    sequentialMeasurement(SimulatedBus::address(n));
+  }
+  printResult("Sequential (d_simple_logger)", bus.clock);
+
+  bus.reset();
+  valuesRead = 0;
+  for (uint8_t n = 0; n < NUM_SENSORS; n++) {
+    bus.spawn(logSensor(SimulatedBus::address(n)));
+  }
+  bus.run();
+  printResult("Interleaved (SDI12Async)", bus.clock);
+}
+
+void loop() {}
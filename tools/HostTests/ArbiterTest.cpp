@@ -0,0 +1,251 @@
+/**
+ * @file ArbiterTest.cpp
+ * @brief Runs an SDI12Arbiter on one thread, with callers on several others, and checks
+ * the order the commands go out in, the breaks, the timeouts, and stop().
+ *
+ * The bus side of the arbiter is the host build of SDI12, except that the commands
+ * aren't clocked out: a sensor answers each one straight into the Rx buffer, as the
+ * receive ISR would, and a sensor at address 9 never answers.  The host clock is
+ * moved on by the time each command and response would take on the wire, and by 1 ms
+ * each time the arbiter waits for the response.
+ *
+ * The bus thread can be held in the middle of a command, so that the callers can queue
+ * up behind it in a known order: each is started on its own thread, and the next one
+ * only once it is in the queue.
+ *
+ * To have ThreadSanitizer check the locking too:
+ *
+ *     make -B CXXFLAGS="-O1 -g -fsanitize=thread" run-ArbiterTest
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "HostTest.h"
+// the producer side of the buffer is only for the ISR
+#define private public
+#include "SDI12.h"
+#undef private
+#include "SDI12Arbiter.h"
+
+/** @brief The time a character takes on the wire at 1200 baud, in µs */
+#define CHARACTER_MICROS 8333
+
+SDI12 mySDI12(7);
+
+/** @brief A command as the bus thread sent it */
+struct Sent {
+  std::string command;
+  bool        wake;
+};
+
+/** @brief An arbiter whose commands are answered by a pretend sensor */
+class TestArbiter : public SDI12Arbiter {
+ public:
+  using SDI12Arbiter::SDI12Arbiter;
+
+  /** @brief Hold the bus thread in the next command until release() */
+  void hold() {
+    std::lock_guard<std::mutex> lock(_testMutex);
+    _held = true;
+  }
+  /** @brief Let the bus thread go on */
+  void release() {
+    std::lock_guard<std::mutex> lock(_testMutex);
+    _held = false;
+    _released.notify_all();
+  }
+  /** @brief The commands sent so far */
+  std::vector<Sent> sent() {
+    std::lock_guard<std::mutex> lock(_testMutex);
+    return _sent;
+  }
+  /** @brief Forget the commands sent so far */
+  void clearSent() {
+    std::lock_guard<std::mutex> lock(_testMutex);
+    _sent.clear();
+  }
+
+ protected:
+  void sendCommand(const char* command, bool wake, int8_t) override {
+    {
+      std::unique_lock<std::mutex> lock(_testMutex);
+      _sent.push_back({command, wake});
+      _released.wait(lock, [&] { return !_held; });
+    }
+    mySDI12.clearBuffer();
+    unsigned long t = micros() + strlen(command) * CHARACTER_MICROS;
+    if (wake) t += 12000 + CHARACTER_MICROS;  // the break and the marking after it
+    hostSetMicros(t);
+    if (command[0] == '9') return;
+    // e.g. "0M!" is answered with "0M+1"
+    std::string response = std::string(command, strlen(command) - 1) + "+1\r\n";
+    for (char c : response) SDI12::charToBuffer(c);
+    hostSetMicros(t + response.size() * CHARACTER_MICROS);
+  }
+
+ private:
+  std::mutex              _testMutex;
+  std::condition_variable _released;
+  bool                    _held = false;
+  std::vector<Sent>       _sent;
+};
+
+TestArbiter arbiter(mySDI12);
+
+/** @brief A caller on its own thread, running one transaction */
+struct Caller {
+  SDI12Transaction transaction;
+  bool             result = false;
+  std::thread      thread;
+
+  Caller(const char* command, SDI12Priority priority) {
+    transaction.command  = command;
+    transaction.priority = priority;
+  }
+  void start() {
+    thread = std::thread([this] { result = arbiter.transact(transaction); });
+  }
+};
+
+/** @brief Wait, for up to 5 s, until a condition holds */
+static bool waitUntil(std::function<bool()> condition) {
+  for (int i = 0; i < 5000; i++) {
+    if (condition()) return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return false;
+}
+
+/** @brief Hold the bus in a first command, and queue the callers behind it in order */
+static void queueBehindHeld(Caller& first, std::vector<Caller>& callers) {
+  arbiter.hold();
+  first.start();
+  CHECK(waitUntil([] { return arbiter.sent().size() == 1; }));
+  for (size_t i = 0; i < callers.size(); i++) {
+    callers[i].start();
+    CHECK(waitUntil([i] { return arbiter.pending() == i + 1; }));
+  }
+}
+
+static void testOrder() {
+  printf("priorities, order within a priority, and one break\n");
+  arbiter.clearSent();
+  std::thread         bus([] { arbiter.run(); });
+  Caller              first("0M!", SDI12_PRIORITY_NORMAL);
+  std::vector<Caller> callers;
+  callers.reserve(6);
+  callers.emplace_back("1M!", SDI12_PRIORITY_ROUTINE);
+  callers.emplace_back("2M!", SDI12_PRIORITY_NORMAL);
+  callers.emplace_back("3M!", SDI12_PRIORITY_NORMAL);
+  callers.emplace_back("4M!", SDI12_PRIORITY_URGENT);
+  callers.emplace_back("5M!", SDI12_PRIORITY_NORMAL);
+  callers.emplace_back("6M!", SDI12_PRIORITY_URGENT);
+  queueBehindHeld(first, callers);
+  arbiter.release();
+  first.thread.join();
+  for (Caller& caller : callers) caller.thread.join();
+
+  // the urgent ones jump the queue, the routine one waits for everything
+  std::vector<Sent> sent  = arbiter.sent();
+  const char*       order[] = {"0M!", "4M!", "6M!", "2M!", "3M!", "5M!", "1M!"};
+  CHECK(sent.size() == 7);
+  for (size_t i = 0; i < sent.size() && i < 7; i++) {
+    CHECK(sent[i].command == order[i]);
+    // the sensors are still awake from the response before
+    CHECK(sent[i].wake == (i == 0));
+  }
+  CHECK(first.result && strcmp(first.transaction.response, "0M+1") == 0);
+  for (Caller& caller : callers) {
+    std::string expected = std::string(caller.transaction.command, 2) + "+1";
+    CHECK(caller.result);
+    CHECK(caller.transaction.status == SDI12_TRANSACTION_DONE);
+    CHECK(caller.transaction.response == expected);
+  }
+  arbiter.stop();
+  bus.join();
+}
+
+static void testTimeout() {
+  printf("a timeout, then the break again\n");
+  arbiter.clearSent();
+  std::thread bus([] { arbiter.run(); });
+
+  Caller silent("9M!", SDI12_PRIORITY_NORMAL);
+  silent.transaction.timeout = 100;
+  unsigned long start        = millis();
+  silent.start();
+  silent.thread.join();
+  CHECK(!silent.result);
+  CHECK(silent.transaction.status == SDI12_TRANSACTION_TIMEOUT);
+  CHECK(silent.transaction.response[0] == '\0');
+  CHECK(millis() - start >= 100);
+
+  // nothing answered, so the next command needs a break; the one after doesn't
+  Caller answered("0M!", SDI12_PRIORITY_NORMAL);
+  answered.start();
+  answered.thread.join();
+  Caller again("0D0!", SDI12_PRIORITY_NORMAL);
+  again.start();
+  again.thread.join();
+  CHECK(answered.result && again.result);
+  std::vector<Sent> sent = arbiter.sent();
+  CHECK(sent.size() == 3);
+  if (sent.size() == 3) CHECK(sent[1].wake && !sent[2].wake);
+  arbiter.stop();
+  bus.join();
+}
+
+/** @brief Counts the callbacks */
+static int callbacks = 0;
+
+static void testStop() {
+  printf("stop() with callers waiting\n");
+  arbiter.clearSent();
+  std::thread         bus([] { arbiter.run(); });
+  Caller              first("0M!", SDI12_PRIORITY_NORMAL);
+  std::vector<Caller> callers;
+  callers.reserve(3);
+  callers.emplace_back("1M!", SDI12_PRIORITY_NORMAL);
+  callers.emplace_back("2M!", SDI12_PRIORITY_URGENT);
+  callers.emplace_back("3M!", SDI12_PRIORITY_ROUTINE);
+  callbacks = 0;
+  for (Caller& caller : callers) {
+    caller.transaction.callback = [](SDI12Transaction&, void*) { callbacks++; };
+  }
+  queueBehindHeld(first, callers);
+  arbiter.stop();
+  arbiter.release();
+  bus.join();
+  first.thread.join();
+  // everyone waiting is let go
+  for (Caller& caller : callers) caller.thread.join();
+
+  // the command on the wire finishes, the ones waiting are never sent
+  CHECK(first.result);
+  CHECK(arbiter.sent().size() == 1);
+  for (Caller& caller : callers) {
+    CHECK(!caller.result);
+    CHECK(caller.transaction.status == SDI12_TRANSACTION_CANCELLED);
+  }
+  CHECK(callbacks == 3);
+  CHECK(arbiter.pending() == 0);
+  SDI12Transaction late;
+  late.command = "0M!";
+  CHECK(!arbiter.submit(late));
+}
+
+int main() {
+  // waiting for a response moves the clock on
+  hostYieldHook = [] { hostSetMicros(micros() + 1000); };
+  mySDI12.begin();
+  testOrder();
+  testTimeout();
+  testStop();
+  return hostTestResult("ArbiterTest");
+}
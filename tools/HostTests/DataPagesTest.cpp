@@ -0,0 +1,207 @@
+/**
+ * @file DataPagesTest.cpp
+ * @brief Checks how SDI12DataPages packs values into the 35 and 75 character pages,
+ * the CRCs it adds, and what it keeps when the values don't all fit.
+ *
+ * The pages are checked against the values formatted one by one: joined up they must
+ * be the values in order, no page may be over the limit, and each page must be as full
+ * as it can be, so that the next value wouldn't have fitted on it.  The CRCs are
+ * checked against the example in the SDI-12 specification and against a CRC-16 worked
+ * out here a bit at a time.
+ */
+
+#include <string>
+#include <vector>
+
+#include "HostTest.h"
+#include "SDI12DataPages.h"
+
+SDI12DataPages pages;
+
+/** @brief The values formatted one by one, as set() should */
+static std::vector<std::string> formatted(const std::vector<float>& values,
+                                          uint8_t decimals) {
+  std::vector<std::string> out;
+  char                     value[10];
+  for (float v : values) {
+    out.push_back(std::string(value, SDI12::formatValue(v, decimals, value)));
+  }
+  return out;
+}
+
+/** @brief A page as a string */
+static std::string pageText(uint8_t n) {
+  uint8_t     length;
+  const char* text = pages.page(n, &length);
+  return std::string(text, length);
+}
+
+/** @brief The CRC-16 of the SDI-12 specification, encoded as 3 characters */
+static std::string referenceCrc(const std::string& response) {
+  uint16_t crc = 0;
+  for (char c : response) {
+    crc ^= (uint8_t)c;
+    for (int bit = 0; bit < 8; bit++) crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+  }
+  std::string out;
+  out += (char)(0x40 | (crc >> 12));
+  out += (char)(0x40 | ((crc >> 6) & 0x3F));
+  out += (char)(0x40 | (crc & 0x3F));
+  return out;
+}
+
+/**
+ * @brief Check the pages hold the values, in order and each page as full as it can be
+ *
+ * @param values The values given to set()
+ * @param decimals The decimal places they were formatted with
+ * @param pageSize The page size given to set()
+ * @param crcAddress The CRC address given to set()
+ * @param fitted The number of values expected to have fitted
+ */
+static void checkPages(const std::vector<float>& values, uint8_t decimals,
+                       uint8_t pageSize, char crcAddress, size_t fitted) {
+  std::vector<std::string> expected = formatted(values, decimals);
+  CHECK(pages.valueCount() == fitted);
+  size_t next = 0;
+  for (uint8_t n = 0; n < pages.pageCount(); n++) {
+    std::string page = pageText(n);
+    if (crcAddress) {
+      CHECK(page.size() > 3);
+      std::string crc = page.substr(page.size() - 3);
+      page.resize(page.size() - 3);
+      CHECK(crc == referenceCrc(crcAddress + page));
+    }
+    CHECK(page.size() <= pageSize);
+    // the values on the page, in order
+    size_t used = 0;
+    while (next < fitted && used + expected[next].size() <= page.size() &&
+           page.compare(used, expected[next].size(), expected[next]) == 0) {
+      used += expected[next++].size();
+    }
+    CHECK(used == page.size());
+    // a page is only started when the next value doesn't fit on the one before
+    if (n + 1 < pages.pageCount()) {
+      CHECK(page.size() + expected[next].size() > pageSize);
+    }
+  }
+  CHECK(next == fitted);
+  // the pages after the last are empty
+  CHECK(pageText(pages.pageCount()).empty());
+}
+
+static void testSpecCrc() {
+  printf("the CRC example in the specification\n");
+  // SDI-12 v1.4, 4.4.12.3: 0+3.14 has the CRC OqZ
+  char out[3];
+  SDI12DataPages::crc('0', "+3.14", 5, out);
+  CHECK(std::string(out, 3) == "OqZ");
+  CHECK(referenceCrc("0+3.14") == "OqZ");
+}
+
+static void testExactFit() {
+  printf("values that fill a page exactly, and one more\n");
+  pages.setDecimals(2);
+  for (uint8_t pageSize : {(uint8_t)SDI12_PAGE_SIZE_M, (uint8_t)SDI12_PAGE_SIZE_C}) {
+    // each is "+1.50", 5 characters
+    size_t             perPage = pageSize / 5;
+    std::vector<float> values(perPage, 1.5f);
+    CHECK(pages.set(values.data(), values.size(), pageSize));
+    CHECK(pages.pageCount() == 1);
+    CHECK(pageText(0).size() == pageSize);
+    checkPages(values, 2, pageSize, '\0', values.size());
+    values.push_back(-2.25f);
+    CHECK(pages.set(values.data(), values.size(), pageSize));
+    CHECK(pages.pageCount() == 2);
+    CHECK(pageText(1) == "-2.25");
+    checkPages(values, 2, pageSize, '\0', values.size());
+    // the CRC isn't counted in the page size
+    values.pop_back();
+    CHECK(pages.set(values.data(), values.size(), pageSize, '3'));
+    CHECK(pages.pageCount() == 1);
+    CHECK(pageText(0).size() == pageSize + 3u);
+  }
+  pages.setDecimals(6);
+}
+
+static void testPacking() {
+  printf("mixed values packed into 35 and 75 character pages\n");
+  // widths from 2 to 9 characters, so the pages end short by different amounts
+  std::vector<float> values = {1.5f, -0.000123f, 12345678.f, 0.f, -99.5f, 3.14159f,
+                               1e-7f, -1234567.f, 42.f, 0.5f, 7.25f, -3.f,
+                               100.125f, 9999999.f, -0.75f, 2.f, 0.001f, 65.5f};
+  for (uint8_t decimals : {0, 2, 6}) {
+    pages.setDecimals(decimals);
+    for (uint8_t pageSize : {(uint8_t)SDI12_PAGE_SIZE_M, (uint8_t)SDI12_PAGE_SIZE_C}) {
+      for (char crcAddress : {'\0', 'a'}) {
+        // every number of values, from one on
+        for (size_t count = 1; count <= values.size(); count++) {
+          std::vector<float> some(values.begin(), values.begin() + count);
+          CHECK(pages.set(some.data(), count, pageSize, crcAddress));
+          checkPages(some, decimals, pageSize, crcAddress, count);
+        }
+      }
+    }
+  }
+  pages.setDecimals(6);
+}
+
+static void testReply() {
+  printf("the replies to aD0! to aD9!\n");
+  std::vector<float> values(6, 1.234567f);  // 9 characters each, 3 to a page
+  CHECK(pages.set(values.data(), values.size(), SDI12_PAGE_SIZE_M, '0'));
+  CHECK(pages.pageCount() == 2);
+  char reply[SDI12_SENSOR_REPLY_SIZE];
+  for (int n = 0; n < 10; n++) {
+    char command[3] = {'D', (char)('0' + n), '\0'};
+    int  length     = pages.reply(command, reply, sizeof(reply));
+    if (n < 2) {
+      CHECK(std::string(reply, length) == pageText(n));
+    } else {
+      // no values, but still a CRC, of just the address
+      CHECK(std::string(reply, length) == referenceCrc("0"));
+    }
+  }
+  CHECK(pages.reply("D10", reply, sizeof(reply)) == SDI12_NO_REPLY);
+  CHECK(pages.reply("M0", reply, sizeof(reply)) == SDI12_NO_REPLY);
+  CHECK(pages.reply("D", reply, sizeof(reply)) == SDI12_NO_REPLY);
+  // never more than there is room for
+  CHECK(pages.reply("D0", reply, 10) == 10);
+  pages.clear();
+  CHECK(pages.pageCount() == 0 && pages.valueCount() == 0);
+  CHECK(pages.reply("D0", reply, sizeof(reply)) == 0);
+}
+
+static void testTruncation() {
+  printf("more values than fit\n");
+  // 9 characters each, 8 to a 75 character page, and the pages are stored one after
+  // another, so 22 fit in the 200 characters
+  std::vector<float> values(30, -1.234567f);
+  size_t             fit = SDI12_DATA_PAGES_SIZE / 9;
+  CHECK(!pages.set(values.data(), values.size(), SDI12_PAGE_SIZE_C));
+  CHECK(pages.valueCount() == fit);
+  checkPages(values, 6, SDI12_PAGE_SIZE_C, '\0', fit);
+  // with a CRC on each page: two full pages, 150 characters with theirs, then 5 more
+  // values and the third CRC
+  CHECK(!pages.set(values.data(), values.size(), SDI12_PAGE_SIZE_C, '0'));
+  CHECK(pages.valueCount() == 2 * 8 + 5);
+  checkPages(values, 6, SDI12_PAGE_SIZE_C, '0', 2 * 8 + 5);
+  // and with 35 character pages, 30 with the CRC: after 6 of them and one more value,
+  // a second would end at 198 and fit, but its page's CRC wouldn't
+  CHECK(!pages.set(values.data(), values.size(), SDI12_PAGE_SIZE_M, '0'));
+  CHECK(pages.valueCount() == 6 * 3 + 1);
+  checkPages(values, 6, SDI12_PAGE_SIZE_M, '0', 6 * 3 + 1);
+  // or more pages than aD0! to aD9! can ask for
+  CHECK(!pages.set(values.data(), 12, 9));
+  CHECK(pages.pageCount() == 10 && pages.valueCount() == 10);
+  checkPages(values, 6, 9, '\0', 10);
+}
+
+int main() {
+  testSpecCrc();
+  testExactFit();
+  testPacking();
+  testReply();
+  testTruncation();
+  return hostTestResult("DataPagesTest");
+}
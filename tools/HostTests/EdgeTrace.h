@@ -0,0 +1,200 @@
+/**
+ * @file EdgeTrace.h
+ * @brief Edge traces of SDI-12 responses, and playing them to the receive interrupts,
+ * shared by the receiver tests.
+ *
+ * A trace is the changes of the data line for a response at 1200 baud, plus the short
+ * pulses of any noise.  A TraceReceiver sets the data pin for each change and runs the
+ * interrupt the change causes, for the way the library was built to receive: a pin
+ * change interrupt (the default), the input capture interrupt, or the sampling timer.
+ * The main program reads the buffer once a millisecond.
+ */
+#pragma once
+
+#include "HostTest.h"
+#include "SDI12.h"
+
+#include <math.h>
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+
+/** @brief The bit width at 1200 baud, in µs */
+#define BIT_MICROS 833.333
+
+/** @brief A change of the data line */
+struct Edge {
+  double t;
+  int    level;
+};
+
+/** @brief A short pulse of the opposite level */
+struct Glitch {
+  double start;
+  double end;
+};
+
+/** @brief The changes for a string, starting at t, with bits bitWidth µs wide */
+inline std::vector<Edge> encode(const char* s, double t, double bitWidth) {
+  std::vector<Edge> edges;
+  int               level = LOW;
+  for (; *s; s++) {
+    uint8_t c     = *s & 0x7F;
+    uint8_t frame = c | (__builtin_parity(c) << 7);
+    // inverse logic: the start bit and 0s are HIGH, 1s and the stop bit are LOW
+    int bits[10];
+    bits[0] = HIGH;
+    for (int i = 0; i < 8; i++) bits[i + 1] = ((frame >> i) & 1) ? LOW : HIGH;
+    bits[9] = LOW;
+    for (int i = 0; i < 10; i++) {
+      if (bits[i] != level) {
+        level = bits[i];
+        edges.push_back({t + i * bitWidth, level});
+      }
+    }
+    t += 10 * bitWidth;
+  }
+  return edges;
+}
+
+/** @brief The level of a bit of the frames for a string, from its first start bit */
+inline int bitLevel(const char* s, size_t bit) {
+  uint8_t c     = s[bit / 10] & 0x7F;
+  uint8_t frame = c | (__builtin_parity(c) << 7);
+  size_t  i     = bit % 10;
+  if (i == 0) return HIGH;
+  if (i == 9) return LOW;
+  return ((frame >> (i - 1)) & 1) ? LOW : HIGH;
+}
+
+/**
+ * @brief Gets the changes of a trace to an SDI12 instance through its pin change
+ * interrupt.
+ *
+ * The instance's data pin must be 7 or 8, the pins the fake registers wire up.  As on
+ * the chip, the interrupt runs once for any number of changes while it is pending, and
+ * reads the pin when it does run.  By default it runs as soon as the line changes;
+ * set `latency` to hold it off, as another interrupt would.
+ */
+class TraceReceiver {
+ public:
+  explicit TraceReceiver(SDI12& bus)
+    : bus(bus),
+      _pin(bus.getDataPin() == 7 ? &PIND : &PINB),
+      _pcmsk(bus.getDataPin() == 7 ? &PCMSK2 : &PCMSK0),
+      _mask(bus.getDataPin() == 7 ? 0x80 : 0x01) {}
+  virtual ~TraceReceiver() {}
+
+  /** @brief Set the data pin, at the current host time */
+  void setLevel(int level) {
+    if (level) {
+      *_pin |= _mask;
+    } else {
+      *_pin &= ~_mask;
+    }
+  }
+  /** @brief The level of the data pin */
+  int level() const {
+    return (*_pin & _mask) ? HIGH : LOW;
+  }
+  /** @brief The line has just changed, at host time now */
+  virtual void changed(unsigned long now) {
+    if (*_pcmsk & _mask) request(now);
+  }
+  /** @brief Run the interrupts due by host time now */
+  virtual void runUntil(unsigned long now) {
+    if (_pending && _due <= now) {
+      _pending = false;
+      hostSetMicros(_due);
+      isrCalls++;
+      isr();
+    }
+  }
+
+  /** @brief The instance the characters are read from */
+  SDI12& bus;
+  /** @brief The number of interrupts run */
+  long isrCalls = 0;
+  /** @brief How long each interrupt is held off, in µs */
+  std::function<unsigned long()> latency = [] { return 0UL; };
+
+ protected:
+  /** @brief The interrupt handler */
+  virtual void isr() {
+    SDI12::handleInterrupt();
+  }
+  /** @brief Set the interrupt pending, unless it already is */
+  void request(unsigned long now) {
+    if (_pending) return;
+    _pending = true;
+    _due     = now + latency();
+  }
+
+ private:
+  volatile uint8_t* _pin;
+  volatile uint8_t* _pcmsk;
+  uint8_t           _mask;
+  bool              _pending = false;
+  unsigned long     _due     = 0;
+};
+
+/** @brief The time the next trace starts at, in µs */
+static double traceStart = 1000;
+
+/**
+ * @brief Play the edges, with the glitches, to a receiver and read the buffer once a
+ * millisecond until the line has been idle for 20 ms.
+ *
+ * @return **std::string** What was read
+ */
+inline std::string play(TraceReceiver& receiver, const std::vector<Edge>& edges,
+                        const std::vector<Glitch>& glitches, bool readBuffer = true) {
+  double end = (edges.empty() ? 0 : edges.back().t) + 20000;
+  for (const Glitch& g : glitches) end = std::max(end, g.end + 20000);
+
+  auto levelAt = [&](double t) {
+    int level = LOW;
+    for (const Edge& e : edges) {
+      if (e.t > t) break;
+      level = e.level;
+    }
+    for (const Glitch& g : glitches) {
+      if (t >= g.start && t < g.end) level = !level;
+    }
+    return level;
+  };
+
+  // every time the line could change, and the reads, which are tagged true
+  std::vector<std::pair<double, bool>> times;
+  for (const Edge& e : edges) times.push_back({e.t, false});
+  for (const Glitch& g : glitches) {
+    times.push_back({g.start, false});
+    times.push_back({g.end, false});
+  }
+  for (double t = 0; t < end; t += 1000) times.push_back({t + 1, true});
+  std::stable_sort(times.begin(), times.end());
+
+  std::string got;
+  auto        readAll = [&] {
+    while (readBuffer && receiver.bus.available() > 0) got += (char)receiver.bus.read();
+  };
+  for (auto& point : times) {
+    unsigned long now = (unsigned long)(traceStart + point.first);
+    receiver.runUntil(now);
+    hostSetMicros(now);
+    if (point.second) {
+      readAll();
+      continue;
+    }
+    int newLevel = levelAt(point.first);
+    if (newLevel == receiver.level()) continue;
+    receiver.setLevel(newLevel);
+    receiver.changed(now);
+    receiver.runUntil(now);
+  }
+  receiver.runUntil((unsigned long)(traceStart + end));
+  readAll();
+  traceStart += end;
+  return got;
+}
@@ -0,0 +1,89 @@
+/**
+ * @file FormatterBenchmark.cpp
+ * @brief Times SDI12::formatValue() and SDI12::formatFixed() on the host, against
+ * snprintf() and the formatter SDI12DataPages had before, which divides by 10 for each
+ * digit.
+ *
+ * These are host numbers only.  A desktop processor divides in a few cycles, while an
+ * AVR has no divide instruction at all, so they say nothing about which is quicker on a
+ * board; time them there before relying on either.
+ */
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "SDI12.h"
+
+/** @brief The values formatted in each run */
+#define VALUE_COUNT 65536
+/** @brief The number of runs over them */
+#define RUNS 50
+
+/** @brief The formatter SDI12DataPages had before formatValue() */
+static uint8_t divisionFormat(float value, uint8_t decimals, char* out) {
+  static const float limits[] = {9999999.5f, 999999.95f, 99999.995f, 9999.9995f,
+                                 999.99995f, 99.999995f, 9.9999995f};
+  char* p = out;
+  if (value < 0) {
+    *p++  = '-';
+    value = -value;
+  } else {
+    *p++ = '+';
+  }
+  if (!(value < 9999999.5f)) value = 9999999;
+  while (decimals > 0 && !(value < limits[decimals])) decimals--;
+  uint32_t power = 1;
+  for (uint8_t i = 0; i < decimals; i++) power *= 10;
+  uint32_t n = (uint32_t)(value * power + 0.5f);
+  char     digits[8];
+  uint8_t  count = 0;
+  do {
+    digits[count++] = '0' + n % 10;
+    n /= 10;
+  } while (n || count <= decimals);
+  while (count) {
+    if (count == decimals) *p++ = '.';
+    *p++ = digits[--count];
+  }
+  *p = '\0';
+  return p - out;
+}
+
+static std::vector<float>   values(VALUE_COUNT);
+static std::vector<int32_t> fixedValues(VALUE_COUNT);
+
+/** @brief Time a formatter over all of the values and print ns a value */
+template <typename Format>
+static void run(const char* name, Format format) {
+  volatile uint32_t sink  = 0;
+  auto              start = std::chrono::steady_clock::now();
+  for (int r = 0; r < RUNS; r++) {
+    for (size_t i = 0; i < VALUE_COUNT; i++) sink = sink + format(i);
+  }
+  double ns = std::chrono::duration<double, std::nano>(
+                std::chrono::steady_clock::now() - start)
+                .count() /
+    ((double)RUNS * VALUE_COUNT);
+  printf("  %-32s %7.1f ns a value\n", name, ns);
+}
+
+int main() {
+  // values of every size from 10^7 down, with 6 decimals asked for
+  std::mt19937 random(7);
+  for (size_t i = 0; i < VALUE_COUNT; i++) {
+    values[i] = (float)((int32_t)(random() % 20000001) - 10000000) /
+      (float)(1UL << (random() % 20));
+    fixedValues[i] = (int32_t)(random() % 19999999) - 9999999;
+  }
+  char out[32];
+  printf("Formatting %d values, %d times\n", VALUE_COUNT, RUNS);
+  run("snprintf(\"%+.6f\")",
+      [&](size_t i) { return snprintf(out, sizeof(out), "%+.6f", values[i]); });
+  run("division per digit", [&](size_t i) { return divisionFormat(values[i], 6, out); });
+  run("SDI12::formatValue()",
+      [&](size_t i) { return SDI12::formatValue(values[i], 6, out); });
+  run("SDI12::formatFixed(), 3 decimals",
+      [&](size_t i) { return SDI12::formatFixed(fixedValues[i], 3, out); });
+  return 0;
+}
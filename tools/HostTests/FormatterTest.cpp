@@ -0,0 +1,174 @@
+/**
+ * @file FormatterTest.cpp
+ * @brief Checks SDI12::formatValue() and SDI12::formatFixed() against exact references,
+ * over every input that matters.
+ *
+ * - formatFixed(): every value from -9999999 to 9999999 with 0 to 6 decimals, and 20
+ * million random 32-bit values with 0 to 9 decimals
+ * - formatValue(): every float under 10,000,000 in magnitude, both signs, with the
+ * decimals taken from the bits of the float
+ *
+ * Each result is checked for its form, read back, and compared with a reference worked
+ * out in 64-bit integers or, for a float, in doubles, where a float times a power of 10
+ * up to 10^6 is exact.  Some of the floats are also read back with strtod(), and must
+ * be within half a unit of their last decimal of the value.  The float sweep takes a
+ * minute or two.
+ */
+
+#include <math.h>
+#include <random>
+
+#include "HostTest.h"
+#include "SDI12.h"
+
+static const uint64_t powers[] = {1,      10,      100,      1000,      10000,
+                                  100000, 1000000, 10000000, 100000000, 1000000000};
+
+/** @brief A formatted value, as its sign, digits and decimal places */
+struct Formatted {
+  bool     negative;
+  uint64_t n;
+  int      decimals;
+  bool operator==(const Formatted& other) const {
+    return negative == other.negative && n == other.n && decimals == other.decimals;
+  }
+};
+
+/**
+ * @brief Read back a formatted value, checking its form: a sign, then digits with no
+ * leading zeros, and if there are decimals a point with at least one digit before it
+ */
+static bool parse(const char* text, Formatted* value) {
+  if (*text != '+' && *text != '-') return false;
+  value->negative = *text++ == '-';
+  value->n        = 0;
+  value->decimals = -1;
+  int digits      = 0;
+  for (const char* c = text; *c; c++) {
+    if (*c == '.' && value->decimals < 0 && digits > 0 && c[1] != '\0') {
+      value->decimals = 0;
+    } else if (*c >= '0' && *c <= '9') {
+      if (digits == 1 && value->n == 0 && value->decimals < 0) return false;
+      value->n = value->n * 10 + *c - '0';
+      digits++;
+      if (value->decimals >= 0) value->decimals++;
+    } else {
+      return false;
+    }
+  }
+  if (value->decimals < 0) value->decimals = 0;
+  // at most 7 digits, and no -0
+  return digits > 0 && digits <= 7 && !(value->negative && value->n == 0);
+}
+
+/** @brief What formatFixed() should give: at most 7 digits, rounded half up once */
+static Formatted referenceFixed(int32_t value, int decimals) {
+  bool     negative = value < 0;
+  uint64_t n        = negative ? -(int64_t)value : value;
+  if (decimals > 9) decimals = 9;
+  uint64_t divisor = 1;
+  while (decimals > 0 && (decimals > 6 || n / divisor > 9999999)) {
+    divisor *= 10;
+    decimals--;
+  }
+  if (divisor > 1) n = n / divisor + (n % divisor >= divisor / 2);
+  if (n > 9999999) {
+    if (decimals > 0) {
+      n /= 10;
+      decimals--;
+    } else {
+      n = 9999999;
+    }
+  }
+  return {negative && n != 0, n, decimals};
+}
+
+/** @brief What formatValue() should give, for |value| < 10,000,000 */
+static Formatted referenceValue(float value, int decimals) {
+  double   x           = fabs((double)value);
+  uint64_t whole       = (uint64_t)x;
+  int      wholeDigits = 1;
+  while (wholeDigits < 7 && whole >= powers[wholeDigits]) wholeDigits++;
+  if (decimals > 7 - wholeDigits) decimals = 7 - wholeDigits;
+  double   scaled = x * powers[decimals];  // exact
+  uint64_t n      = (uint64_t)scaled;
+  if (scaled - n >= 0.5) n++;
+  if (n > 9999999) {
+    n = 1000000;
+    decimals--;
+  }
+  return {value < 0 && n != 0, n, decimals};
+}
+
+static void testFixed() {
+  printf("formatFixed(), every value of up to 7 digits with 0-6 decimals\n");
+  char      out[16];
+  Formatted got;
+  long      cases = 0, wrong = 0;
+  for (int decimals = 0; decimals <= 6; decimals++) {
+    for (int32_t value = -9999999; value <= 9999999; value++) {
+      uint8_t length = SDI12::formatFixed(value, decimals, out);
+      cases++;
+      // these need no rounding, so they read back exactly
+      bool ok = parse(out, &got) && got == referenceFixed(value, decimals) &&
+        length == strlen(out) && (int64_t)(got.negative ? -got.n : got.n) == value;
+      if (!ok && wrong++ < 5) printf("  %d, %d decimals: %s\n", value, decimals, out);
+    }
+  }
+  printf("  %ld cases, %ld wrong\n", cases, wrong);
+  CHECK(wrong == 0);
+
+  printf("formatFixed(), random 32-bit values with 0-9 decimals\n");
+  std::mt19937 random(1);
+  cases = wrong = 0;
+  for (long i = 0; i < 20000000L; i++) {
+    int32_t value    = (int32_t)random();
+    uint8_t decimals = random() % 10;
+    uint8_t length   = SDI12::formatFixed(value, decimals, out);
+    cases++;
+    bool ok = parse(out, &got) && got == referenceFixed(value, decimals) &&
+      length == strlen(out);
+    if (!ok && wrong++ < 5) printf("  %d, %d decimals: %s\n", value, decimals, out);
+  }
+  printf("  %ld cases, %ld wrong\n", cases, wrong);
+  CHECK(wrong == 0);
+}
+
+static void testValue() {
+  printf("formatValue(), every float under 10,000,000 with 0-6 decimals\n");
+  char      out[16];
+  Formatted got;
+  long      cases = 0, wrong = 0;
+  for (uint64_t b = 0; b <= 0xFFFFFFFFULL; b++) {
+    uint32_t bits = (uint32_t)b;
+    if ((bits & 0x7FFFFFFFUL) >= 0x4B189680UL) continue;  // 10^7 or more, or NaN
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    uint8_t decimals = (bits >> 8) % 7;
+    uint8_t length   = SDI12::formatValue(value, decimals, out);
+    cases++;
+    bool ok = parse(out, &got) && got == referenceValue(value, decimals) &&
+      length == strlen(out);
+    // and, for one in 64, through strtod() as a recorder would read it
+    if (ok && (bits & 0x3F) == 0) {
+      double error = fabs(strtod(out, NULL) - value);
+      ok = error <= 0.5 / powers[got.decimals] + fabs(value) * 1e-15;
+    }
+    if (!ok && wrong++ < 5) printf("  %.9g, %d decimals: %s\n", value, decimals, out);
+  }
+  printf("  %ld cases, %ld wrong\n", cases, wrong);
+  CHECK(wrong == 0);
+
+  printf("formatValue(), 10,000,000 or more, infinity and NaN\n");
+  CHECK(SDI12::formatValue(1e7f, 3, out) == 8 && strcmp(out, "+9999999") == 0);
+  CHECK(SDI12::formatValue(-3e38f, 6, out) == 8 && strcmp(out, "-9999999") == 0);
+  CHECK(SDI12::formatValue(INFINITY, 2, out) == 8 && strcmp(out, "+9999999") == 0);
+  CHECK(SDI12::formatValue(NAN, 2, out) == 8 && strcmp(out, "+9999999") == 0);
+}
+
+int main() {
+  setvbuf(stdout, NULL, _IONBF, 0);
+  testFixed();
+  testValue();
+  return hostTestResult("FormatterTest");
+}
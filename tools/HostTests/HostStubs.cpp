@@ -0,0 +1,78 @@
+/**
+ * @file HostStubs.cpp
+ * @brief The fake registers and the Arduino functions declared in stubs/Arduino.h.
+ */
+
+#include <Arduino.h>
+#include "SDI12_boards.h"
+
+HostTimer2        TCNT2;
+bool              hostTimerRunning = false;
+volatile uint8_t  TCCR2A, TCCR2B, TIFR2, TIMSK2, OCR2A, OCR2B;
+volatile uint8_t  TCCR1A, TCCR1B, TIFR1, TIMSK1;
+volatile uint16_t TCNT1, ICR1;
+volatile uint8_t  SREG, SMCR, MCUCR, PCICR, PCMSK0, PCMSK1, PCMSK2;
+volatile uint8_t  PINB, PORTB, DDRB, PINC, PIND, PORTD, DDRD;
+
+static unsigned long hostMicros = 0;
+
+std::vector<uint8_t> hostLineTicks;
+
+HostTimer2::operator uint8_t() {
+  if (!hostTimerRunning) return value;
+  hostLineTicks.push_back((PORTD >> 7) & 1);
+  return value++;
+}
+
+void hostSetMicros(unsigned long us) {
+  // timer 2 runs at F_CPU/1024, 64 µs a tick, and wraps every 256 ticks; timer 1, when
+  // it is the input capture timer, at the same rate
+  unsigned long tick = us / 64;
+#if defined(SDI12_EXTENDED_TIMER)
+  static unsigned long lastTick = 0;
+  while (lastTick < tick) {
+    if ((++lastTick & 0xFF) == 0) SDI12Timer::SDI12TimerOverflow();
+  }
+#endif
+  TIFR2      = 0;  // the overflow interrupt has already run
+  TCNT2      = (uint8_t)tick;
+  TCNT1      = (uint16_t)tick;
+  hostMicros = us;
+}
+
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t, uint8_t) {}
+int  digitalRead(uint8_t pin) {
+  if (pin == 7) return (PIND >> 7) & 1;
+  if (pin == 8) return PINB & 1;
+  return 0;
+}
+unsigned long micros() {
+  return hostMicros;
+}
+unsigned long millis() {
+  return hostMicros / 1000;
+}
+void delay(unsigned long ms) {
+  hostSetMicros(hostMicros + ms * 1000);
+}
+void delayMicroseconds(unsigned int us) {
+  hostSetMicros(hostMicros + us);
+}
+void (*hostYieldHook)() = NULL;
+void (*hostSleepHook)() = NULL;
+
+void yield() {
+  if (hostYieldHook) hostYieldHook();
+}
+void noInterrupts() {
+  cli();
+}
+void interrupts() {
+  sei();
+}
+void attachInterrupt(uint8_t, void (*)(void), int) {}
+void detachInterrupt(uint8_t) {}
+void sleep_cpu() {
+  if (hostSleepHook) hostSleepHook();
+}
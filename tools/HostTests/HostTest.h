@@ -0,0 +1,24 @@
+/**
+ * @file HostTest.h
+ * @brief The checks shared by the host tests.
+ */
+#pragma once
+#include <stdio.h>
+
+/** @brief The number of checks that failed so far */
+static int hostTestFailures = 0;
+
+/** @brief Check a condition, printing it if it doesn't hold */
+#define CHECK(condition)                                                    \
+  do {                                                                      \
+    if (!(condition)) {                                                     \
+      printf("  FAILED %s:%d: %s\n", __FILE__, __LINE__, #condition);       \
+      hostTestFailures++;                                                   \
+    }                                                                       \
+  } while (0)
+
+/** @brief Print the result and give the exit code for main() */
+static inline int hostTestResult(const char* name) {
+  printf("%s: %s\n", name, hostTestFailures ? "FAILED" : "passed");
+  return hostTestFailures ? 1 : 0;
+}
@@ -0,0 +1,107 @@
+/**
+ * @file InputCaptureTest.cpp
+ * @brief Plays the same responses, with the receive interrupt held off by a random
+ * latency, to the pin change decoder on pin 7 and to the input capture decoder on pin 8
+ * (ICP1), with `SDI12_INPUT_CAPTURE`.
+ *
+ * Another interrupt (the millis() timer, a UART, a slow library) can keep the receive
+ * ISR from running for a while after each change.  The pin change ISR reads the timer
+ * when it does run, so the latency is added to the time of the change, and once the
+ * difference between two changes is off by around half a bit the character is decoded
+ * wrong.  The capture unit latches the timer at the change itself, so its ISR gets the
+ * exact time however late it runs.
+ *
+ * Here each interrupt is held off by 0 to 600 µs, less than the shortest time between
+ * changes, so every change still gets its own interrupt.
+ */
+
+#include "EdgeTrace.h"
+
+/** @brief The longest time an interrupt is held off, in µs */
+#define MAX_LATENCY_MICROS 600
+/** @brief The number of responses played to each decoder */
+#define RESPONSES 100
+
+/**
+ * @brief Gets the changes of a trace to the input capture interrupt.
+ *
+ * As on the chip, a change in the direction the capture edge is set to latches timer 1
+ * in ICR1 and sets the interrupt pending; a change the other way only changes the pin.
+ */
+class CaptureReceiver : public TraceReceiver {
+ public:
+  using TraceReceiver::TraceReceiver;
+
+  void changed(unsigned long now) override {
+    if (!(TIMSK1 & _BV(ICIE1))) return;
+    bool rising = level() == HIGH;
+    if (rising != (bool)(TCCR1B & _BV(ICES1))) return;
+    if (!captured) {
+      ICR1     = TCNT1;
+      captured = true;
+    }
+    request(now);
+  }
+
+ protected:
+  void isr() override {
+    captured = false;
+    SDI12::handleInputCapture();
+  }
+
+ private:
+  bool captured = false;
+};
+
+SDI12 pinChangeSDI12(7);
+SDI12 captureSDI12(8);
+
+static const char* response = "0+1.234-5.6789+3\r\n";
+
+/** @brief Play the response a number of times and count how many come out intact */
+static int playResponses(TraceReceiver& receiver, bool withLatency) {
+  srand(3);
+  receiver.latency = [withLatency] {
+    return withLatency ? (unsigned long)(rand() % (MAX_LATENCY_MICROS + 1)) : 0UL;
+  };
+  receiver.bus.begin();
+  receiver.bus.forceListen();
+  int intact = 0;
+  for (int k = 0; k < RESPONSES; k++) {
+    receiver.bus.clearBuffer();
+    if (play(receiver, encode(response, 10000, BIT_MICROS), {}) == response) intact++;
+  }
+  receiver.bus.end();
+  return intact;
+}
+
+static void testPinChange() {
+  TraceReceiver receiver(pinChangeSDI12);
+  printf("pin change interrupt on pin 7\n");
+  int intact = playResponses(receiver, false);
+  printf("  %d/%d intact without latency\n", intact, RESPONSES);
+  CHECK(intact == RESPONSES);
+  intact = playResponses(receiver, true);
+  printf("  %d/%d intact with 0-%d µs latency\n", intact, RESPONSES, MAX_LATENCY_MICROS);
+  // the latency is enough to break most of them
+  CHECK(intact < RESPONSES / 2);
+}
+
+static void testInputCapture() {
+  CaptureReceiver receiver(captureSDI12);
+  printf("input capture interrupt on pin 8\n");
+  int intact = playResponses(receiver, false);
+  printf("  %d/%d intact without latency\n", intact, RESPONSES);
+  CHECK(intact == RESPONSES);
+  intact = playResponses(receiver, true);
+  printf("  %d/%d intact with 0-%d µs latency\n", intact, RESPONSES, MAX_LATENCY_MICROS);
+  CHECK(intact == RESPONSES);
+  CHECK(receiver.isrCalls > 0);
+  CHECK((PCMSK0 & 0x01) == 0);  // never through the pin change interrupt
+}
+
+int main() {
+  testPinChange();
+  testInputCapture();
+  return hostTestResult("InputCaptureTest");
+}
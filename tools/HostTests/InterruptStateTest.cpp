@@ -0,0 +1,42 @@
+/**
+ * @file InterruptStateTest.cpp
+ * @brief Calls the functions that turn the interrupts off around what they share with
+ * the receive ISR, with the interrupts on and off, and checks that each leaves them the
+ * way they were.
+ *
+ * They must not turn the interrupts on when they were off, since the main program may
+ * call them from a critical section of its own or from another ISR.  The host cli()
+ * and sei() clear and set the I bit of SREG.
+ */
+
+#include "HostTest.h"
+#include "SDI12.h"
+
+#include <initializer_list>
+
+/** @brief Call a function with the I bit of SREG set and clear, and check it after */
+template <typename Function>
+static void checkKeepsState(const char* name, Function function) {
+  printf("%s\n", name);
+  for (uint8_t state : {(uint8_t)0x80, (uint8_t)0x00}) {
+    SREG = state;
+    function();
+    CHECK(SREG == state);
+  }
+}
+
+SDI12 mySDI12(7);
+
+int main() {
+  mySDI12.begin();
+  checkKeepsState("getGlitchCount()", [] { (void)SDI12::getGlitchCount(); });
+  checkKeepsState("getEdgeStormCount()", [] { (void)SDI12::getEdgeStormCount(); });
+  checkKeepsState("clearNoiseCounts()", [] { SDI12::clearNoiseCounts(); });
+  checkKeepsState("getBitsPerTick_Q10()",
+                  [] { (void)SDI12::getBitsPerTick_Q10('0'); });
+  checkKeepsState("clearCalibration()", [] { SDI12::clearCalibration(); });
+  // SDI12Sensor::updateAddressFilter() and SDI12SensorNode::reindex() call this
+  checkKeepsState("setAddressFilter()", [] { SDI12::setAddressFilter("05"); });
+  checkKeepsState("setAddressFilter(NULL)", [] { SDI12::setAddressFilter(NULL); });
+  return hostTestResult("InterruptStateTest");
+}
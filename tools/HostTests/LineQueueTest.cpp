@@ -0,0 +1,169 @@
+/**
+ * @file LineQueueTest.cpp
+ * @brief Walks lines across every offset of the Rx buffer and checks availableLines()
+ * and peekLine() as they are read, cleared, re-terminated and overflowed.
+ *
+ * Built twice: with `SDI12_LINE_QUEUE` the line ends come from the queue the receive
+ * ISR fills, and without it from searching the buffer; the counts must be the same
+ * either way.  The lines start at each of the `SDI12_BUFFER_SIZE` offsets in turn, so
+ * the queued ends and the line views are split across the wrap at every point.  After
+ * clearBuffer() and setLineTerminator() none of the old ends may be counted, and when
+ * more lines come in than the queue has room for, or than the buffer has room for, the
+ * count must still be right.
+ */
+
+#include <string>
+
+#include "HostTest.h"
+// the producer side of the buffer is only for the ISR
+#define private public
+#include "SDI12.h"
+#undef private
+
+SDI12 mySDI12(7);
+
+/** @brief Empty the buffer with its head and tail at offset */
+static void moveTo(size_t offset) {
+  mySDI12.clearBuffer();
+  while (SDI12::_rxBufferHead != offset) {
+    SDI12::charToBuffer('x');
+    mySDI12.read();
+  }
+}
+
+/** @brief Put characters in the buffer as the receive ISR would */
+static void receive(const std::string& s) {
+  for (char c : s) SDI12::charToBuffer(c);
+}
+
+/** @brief The next line, or "none" if there isn't a whole one */
+static std::string nextLine() {
+  SDI12Line line;
+  if (!mySDI12.peekLine(line)) return "none";
+  return std::string(line.first, line.firstLength) +
+    std::string(line.second, line.secondLength);
+}
+
+/** @brief Take the next line out of the buffer, if it is the one expected */
+static bool consumeLine(const std::string& expected) {
+  if (nextLine() != expected) return false;
+  mySDI12.consume();
+  return true;
+}
+
+static void testWalk() {
+  printf("two lines and a part, at every offset\n");
+  for (size_t offset = 0; offset < SDI12_BUFFER_SIZE; offset++) {
+    moveTo(offset);
+    receive("0+1.234-5.6789+3\r\n0+2\r\n0+3");
+    CHECK(mySDI12.availableLines() == 2);
+    SDI12Line line;
+    CHECK(mySDI12.peekLine(line));
+    CHECK(line.firstLength == std::min<size_t>(16, SDI12_BUFFER_SIZE - offset));
+    CHECK(consumeLine("0+1.234-5.6789+3"));
+    CHECK(mySDI12.availableLines() == 1);
+    // read past a line end some other way than consume()
+    for (int i = 0; i < 5; i++) mySDI12.read();
+    CHECK(mySDI12.availableLines() == 0);
+    CHECK(nextLine() == "none");
+    receive("\r\n");
+    CHECK(mySDI12.availableLines() == 1);
+    CHECK(consumeLine("0+3"));
+    CHECK(mySDI12.available() == 0);
+  }
+}
+
+static void testClearBuffer() {
+  printf("clearBuffer() at every offset\n");
+  for (size_t offset = 0; offset < SDI12_BUFFER_SIZE; offset++) {
+    moveTo(offset);
+    receive("0+1\r\n0+2\r\n0+3\r\n");
+    mySDI12.clearBuffer();
+#if defined(SDI12_LINE_QUEUE)
+    // emptied by clearBuffer() itself, not just skipped by the next reader
+    CHECK(SDI12::_rxLineHead == SDI12::_rxLineTail);
+#endif
+    CHECK(mySDI12.availableLines() == 0);
+    // enough to come round to where the cleared lines ended
+    std::string longLine(SDI12_BUFFER_SIZE - 14, 'y');
+    receive("0+4\r\n" + longLine + "\r\n");
+    CHECK(mySDI12.availableLines() == 2);
+    CHECK(consumeLine("0+4"));
+    CHECK(consumeLine(longLine));
+    CHECK(mySDI12.availableLines() == 0);
+  }
+}
+
+static void testSetLineTerminator() {
+  printf("setLineTerminator() at every offset\n");
+  for (size_t offset = 0; offset < SDI12_BUFFER_SIZE; offset++) {
+    moveTo(offset);
+    receive("0+1\r\n0+2\r\n");
+    mySDI12.setLineTerminator('!');
+    CHECK(mySDI12.availableLines() == 0);
+    // the old terminator no longer ends a line
+    receive("0M!\r\n0D0!");
+    CHECK(mySDI12.availableLines() == 2);
+    CHECK(consumeLine("0M"));
+    CHECK(consumeLine("\r\n0D0"));
+    CHECK(mySDI12.availableLines() == 0);
+    mySDI12.setLineTerminator('\n');
+    receive("0!0+1\r\n");
+    CHECK(mySDI12.availableLines() == 1);
+    CHECK(consumeLine("0!0+1"));
+  }
+}
+
+static void testQueueOverflow() {
+  printf("more lines than the queue holds, at every offset\n");
+  const int lines = SDI12_LINE_QUEUE_SIZE + 4;
+  for (size_t offset = 0; offset < SDI12_BUFFER_SIZE; offset++) {
+    moveTo(offset);
+#if defined(SDI12_LINE_QUEUE)
+    uint8_t dropsBefore = SDI12::_rxLineDrops;
+#endif
+    for (int i = 0; i < lines; i++) receive(std::string(1, 'a' + i) + "\r\n");
+#if defined(SDI12_LINE_QUEUE)
+    CHECK(SDI12::_rxLineDrops != dropsBefore);
+#endif
+    for (int i = 0; i < lines; i++) {
+      CHECK(mySDI12.availableLines() == lines - i);
+      CHECK(consumeLine(std::string(1, 'a' + i)));
+    }
+    CHECK(mySDI12.availableLines() == 0);
+    // the queue is to be trusted again once it has been emptied
+    receive("0+1\r\n0+2\r\n");
+    CHECK(mySDI12.availableLines() == 2);
+    CHECK(consumeLine("0+1"));
+    CHECK(consumeLine("0+2"));
+  }
+}
+
+static void testBufferOverflow() {
+  printf("more lines than the buffer holds, at every offset\n");
+  const int fit = (SDI12_BUFFER_SIZE - 1) / 5;
+  for (size_t offset = 0; offset < SDI12_BUFFER_SIZE; offset++) {
+    moveTo(offset);
+    // the ends of the lines that didn't fit must not be counted
+    for (int i = 0; i < fit + 4; i++) receive("0+1\r\n");
+    CHECK(SDI12::_bufferOverflow);
+    CHECK(mySDI12.availableLines() == fit);
+    for (int i = 0; i < fit; i++) CHECK(consumeLine("0+1"));
+    CHECK(mySDI12.availableLines() == 0);
+    CHECK(mySDI12.available() == 0);
+  }
+}
+
+int main() {
+  mySDI12.begin();
+  testWalk();
+  testClearBuffer();
+  testSetLineTerminator();
+  testQueueOverflow();
+  testBufferOverflow();
+#if defined(SDI12_LINE_QUEUE)
+  return hostTestResult("LineQueueTest");
+#else
+  return hostTestResult("LineQueueTest_Scan");
+#endif
+}
@@ -0,0 +1,177 @@
+/**
+ * @file MeasureTest.cpp
+ * @brief Sends measurement commands to the background measurements of SDI12Sensor
+ * over the data line and checks the replies, the service requests and the aborts.
+ *
+ * Two sensors, 5 and 6, share a node.  Sensor 5's measure handler gives the seconds
+ * and count it is told to, and finishes the measurement itself if told to.  Only aM!
+ * is followed by a service request, and not when the handler gave 0 seconds; only a
+ * command to sensor 5's own address aborts its measurement, not ?! or one to sensor 6.
+ */
+
+#include <string>
+#include <vector>
+
+#include "SensorBus.h"
+#include "SDI12DataPages.h"
+#include "SDI12SensorNode.h"
+
+SDI12 mySDI12(7);
+
+/** @brief What the measure handler does next */
+static uint16_t           giveSeconds;
+static uint8_t            giveCount;
+static std::vector<float> finishAtOnce;
+
+static bool measure(SDI12Sensor& sensor, uint8_t, uint16_t* seconds, uint8_t* count) {
+  *seconds = giveSeconds;
+  *count   = giveCount;
+  if (!finishAtOnce.empty()) {
+    sensor.finishMeasurement(finishAtOnce.data(), finishAtOnce.size());
+  }
+  return true;
+}
+
+SDI12Sensor        sensor5(mySDI12, '5', NULL, 0);
+SDI12Sensor        sensor6(mySDI12, '6', NULL, 0);
+SDI12Sensor* const sensors[] = {&sensor5, &sensor6};
+SDI12SensorNode    node(mySDI12, sensors, 2);
+SDI12DataPages     pages5, pages6;
+TraceReceiver      receiver(mySDI12);
+
+/** @brief Send a command, and get the reply */
+static std::string ask(const std::string& command) {
+  playCommand(receiver, command);
+  return pollReply([] { node.poll(); });
+}
+
+/** @brief Finish sensor 5's measurement, and get what it sent */
+static std::string finish(const std::vector<float>& values, bool* finished = NULL) {
+  bool        result = false;
+  std::string sent   = pollReply(
+    [&] { result = sensor5.finishMeasurement(values.data(), values.size()); });
+  if (finished) *finished = result;
+  return sent;
+}
+
+/** @brief Have the measure handler give seconds and count, and leave it running */
+static void willTake(uint16_t seconds, uint8_t count) {
+  giveSeconds = seconds;
+  giveCount   = count;
+  finishAtOnce.clear();
+}
+
+static void testServiceRequest() {
+  printf("the service request after aM!, and not after aC!\n");
+  bool finished;
+  willTake(5, 2);
+  CHECK(ask("5M!") == "50052\r\n");
+  CHECK(sensor5.isMeasuring());
+  CHECK(finish({1.5f, -2.f}, &finished) == "5\r\n");
+  CHECK(finished && !sensor5.isMeasuring());
+  CHECK(ask("5D0!") == "5+1.500000-2.000000\r\n");
+  // the numbered forms, and with a CRC
+  CHECK(ask("5MC3!") == "50052\r\n");
+  CHECK(sensor5.getMeasureIndex() == 3);
+  CHECK(finish({1.5f, -2.f}) == "5\r\n");
+  std::string data = ask("5D0!");
+  CHECK(data.size() == 1 + 18 + 3 + 2);
+  CHECK(data.compare(0, 19, "5+1.500000-2.000000") == 0);
+  // aC! and aCC!: the recorder doesn't wait for one
+  CHECK(ask("5C!") == "500502\r\n");
+  CHECK(finish({1.5f, -2.f}, &finished) == "");
+  CHECK(finished);
+  CHECK(ask("5CC1!") == "500502\r\n");
+  CHECK(finish({1.5f, -2.f}) == "");
+  CHECK(ask("5D0!").size() == 1 + 18 + 3 + 2);
+  // once finished, there is no measurement to finish
+  CHECK(finish({1.5f}, &finished) == "");
+  CHECK(!finished);
+}
+
+static void testFinishedAtOnce() {
+  printf("measurements the handler finishes itself\n");
+  // 0 seconds: the values are ready, no service request
+  willTake(0, 1);
+  finishAtOnce = {7.25f};
+  CHECK(ask("5M!") == "50001\r\n");
+  CHECK(!sensor5.isMeasuring());
+  CHECK(ask("5D0!") == "5+7.250000\r\n");
+  // more than 0: the service request follows the reply at once
+  willTake(2, 1);
+  finishAtOnce = {7.25f};
+  CHECK(ask("5M!") == "50021\r\n5\r\n");
+  // but never after aC!
+  CHECK(ask("5C!") == "500201\r\n");
+  CHECK(ask("5D0!") == "5+7.250000\r\n");
+}
+
+static void testAbort() {
+  printf("aborted only by a command to the sensor's own address\n");
+  bool finished;
+  // ?! is for every sensor on the bus, and the one to sensor 6 isn't for sensor 5
+  willTake(10, 1);
+  CHECK(ask("5M!") == "50101\r\n");
+  CHECK(ask("?!") == "5\r\n");
+  CHECK(ask("6!") == "6\r\n");
+  CHECK(ask("6D0!") == "6\r\n");
+  CHECK(ask("3M!") == "");
+  CHECK(sensor5.isMeasuring());
+  CHECK(finish({1.f}, &finished) == "5\r\n");
+  CHECK(finished);
+  // any command to sensor 5 does, even one it doesn't answer
+  const char* aborts[] = {"5!", "5I!", "5D0!", "5Z!"};
+  for (const char* command : aborts) {
+    willTake(10, 1);
+    CHECK(ask("5M!") == "50101\r\n");
+    ask(command);
+    CHECK(!sensor5.isMeasuring());
+    // so the values are thrown away, and there is no service request
+    CHECK(finish({1.f}, &finished) == "");
+    CHECK(!finished);
+    CHECK(ask("5D0!") == "5\r\n");
+  }
+  // a new measurement aborts the one before, and its values are the ones kept
+  willTake(10, 1);
+  CHECK(ask("5M!") == "50101\r\n");
+  CHECK(ask("5M1!") == "50101\r\n");
+  CHECK(sensor5.getMeasureIndex() == 1);
+  CHECK(finish({2.f}) == "5\r\n");
+  CHECK(ask("5D0!") == "5+2.000000\r\n");
+}
+
+static void testCounts() {
+  printf("counts over the limits\n");
+  // the count in the reply is at most 9 for aM! and 99 for aC!
+  willTake(1, 20);
+  CHECK(ask("5M!") == "50019\r\n");
+  willTake(1, 120);
+  CHECK(ask("5C!") == "500199\r\n");
+  // more values than SDI12_DATA_PAGES_SIZE holds: the pages have the ones that fit,
+  // 8 to a 75 character page, and the data commands after them get none
+  willTake(1, 30);
+  CHECK(ask("5C!") == "500130\r\n");
+  std::vector<float> values(30, -1.234567f);
+  CHECK(finish(values) == "");
+  CHECK(pages5.valueCount() == SDI12_DATA_PAGES_SIZE / 9);
+  size_t got = 0;
+  for (int n = 0; n < 10; n++) {
+    std::string command = "5D" + std::to_string(n) + "!";
+    std::string reply   = ask(command);
+    got += (reply.size() - 3) / 9;
+    CHECK((reply.size() - 3) % 9 == 0);
+  }
+  CHECK(got == SDI12_DATA_PAGES_SIZE / 9);
+}
+
+int main() {
+  sensor5.setMeasureHandler(measure);
+  sensor5.setDataPages(&pages5);
+  sensor6.setDataPages(&pages6);
+  node.begin();
+  testServiceRequest();
+  testFinishedAtOnce();
+  testAbort();
+  testCounts();
+  return hostTestResult("MeasureTest");
+}
@@ -0,0 +1,195 @@
+/**
+ * @file NoiseFilterTest.cpp
+ * @brief Feeds edge traces with glitches and edge storms through the receive ISR and
+ * checks what comes out of the Rx buffer, with `SDI12_NOISE_FILTER`.
+ *
+ * The traces are played to the pin change interrupt of pin 7 with EdgeTrace.h, with no
+ * latency.
+ *
+ * The glitches are placed where the filter has work to do:
+ * - in the middle of a run of two or more equal bits
+ * - in the last bit of a character ending with a 0 (HIGH), where the first edge of the
+ * glitch finishes the character early; the glitch must take the character, and for a
+ * LF the line end, back out of the buffer
+ * - in the stop bit of a character ending with two 1s (LOW), where the glitch looks
+ * like the next start bit and so finishes the character early
+ * - around the time the main program reads the buffer, so the character the glitch
+ * finished is gone before the glitch is over
+ * - on the idle line between responses
+ *
+ * Most of the glitches are far enough from the real changes that they can be told
+ * apart; one too close to a change merges with it.
+ */
+
+#include "EdgeTrace.h"
+
+/** @brief How long the glitches are, in µs; the filter takes anything under 1/4 bit */
+#define GLITCH_MICROS 40
+
+SDI12         mySDI12(7);
+TraceReceiver receiver(mySDI12);
+
+/** @brief A glitch in the middle of each bit for which pick() is true */
+template <typename Pick>
+static std::vector<Glitch> glitchBits(const char* s, double t, Pick pick) {
+  std::vector<Glitch> glitches;
+  for (size_t bit = 0; bit < strlen(s) * 10; bit++) {
+    if (!pick(bit)) continue;
+    double mid = t + (bit + 0.5) * BIT_MICROS;
+    glitches.push_back({mid, mid + GLITCH_MICROS});
+  }
+  return glitches;
+}
+
+static void startTest(const char* name) {
+  printf("%s\n", name);
+  mySDI12.clearBuffer();
+  SDI12::clearNoiseCounts();
+}
+
+static const char* response       = "0+1.234-5.6789+3\r\n";
+static const char* identification = "013ACME    SENSOR1.0\r\n";
+
+static void testCleanResponse() {
+  startTest("a response without noise");
+  CHECK(play(receiver, encode(response, 10000, BIT_MICROS), {}) == response);
+  CHECK(SDI12::getGlitchCount() == 0);
+  CHECK(SDI12::getEdgeStormCount() == 0);
+}
+
+static void testGlitchesInRuns() {
+  startTest("a glitch in the middle of every run of equal bits");
+  // a glitch in the second bit of each run, so never right after a real change
+  auto glitches = glitchBits(response, 10000, [](size_t bit) {
+    size_t i = bit % 10;
+    return i > 0 && bitLevel(response, bit) == bitLevel(response, bit - 1);
+  });
+  CHECK(play(receiver, encode(response, 10000, BIT_MICROS), glitches) == response);
+  CHECK(SDI12::getGlitchCount() == glitches.size());
+}
+
+static void testGlitchFinishingCharacter() {
+  startTest("a glitch in the last bit of every character that ends with a 0");
+  auto glitches = glitchBits(response, 10000, [](size_t bit) {
+    return bit % 10 == 8 && bitLevel(response, bit) == HIGH;
+  });
+  CHECK(glitches.size() > 0);
+#if defined(SDI12_LINE_QUEUE)
+  // the LF ends with a 0, so its glitch queues a line end that has to be taken back
+  play(receiver, encode(response, 10000, BIT_MICROS), glitches, false);
+  CHECK(mySDI12.availableLines() == 1);
+  SDI12Line line;
+  CHECK(mySDI12.peekLine(line));
+  CHECK(line.length() == strlen(response) - 2);
+  for (uint8_t i = 0; i < line.length(); i++) CHECK(line[i] == response[i]);
+  mySDI12.consume();
+  CHECK(mySDI12.available() == 0);
+  CHECK(mySDI12.availableLines() == 0);
+#else
+  CHECK(play(receiver, encode(response, 10000, BIT_MICROS), glitches) == response);
+#endif
+  CHECK(SDI12::getGlitchCount() == glitches.size());
+}
+
+/**
+ * @brief Whether a bit is the stop bit of a character ending in two 1s.  Such a
+ * character has no change at its parity bit, so only the next start bit finishes it.
+ */
+static bool isLateStopBit(const char* s, size_t bit) {
+  return bit % 10 == 9 && bitLevel(s, bit - 1) == LOW && bitLevel(s, bit - 2) == LOW;
+}
+
+static void testGlitchStartingCharacter() {
+  startTest("a glitch in the stop bit of every character that ends with two 1s");
+  // the glitch looks like the next start bit, and so finishes the character
+  auto glitches = glitchBits(identification, 10000, [](size_t bit) {
+    return isLateStopBit(identification, bit);
+  });
+  CHECK(glitches.size() > 0);
+  CHECK(play(receiver, encode(identification, 10000, BIT_MICROS), glitches) ==
+        identification);
+  CHECK(SDI12::getGlitchCount() == glitches.size());
+}
+
+/** @brief Play a glitch in a bit so that the buffer is read half way through it */
+static void playReadDuringGlitch(const char* s, size_t bit) {
+  // the main program reads the buffer 1 ms (and 1 µs) into each millisecond
+  double glitchStart = 21001 - GLITCH_MICROS / 2;
+  double start       = glitchStart - (bit + 0.5) * BIT_MICROS;
+  std::vector<Glitch> glitches = {{glitchStart, glitchStart + GLITCH_MICROS}};
+  CHECK(play(receiver, encode(s, start, BIT_MICROS), glitches) == s);
+}
+
+static void testReadDuringGlitch() {
+  startTest("a character read between the edges of the glitch that finished it");
+  // it can't be taken back, but mustn't be finished a second time either
+  size_t bit = 8;
+  while (bitLevel(response, bit) != HIGH) bit += 10;
+  playReadDuringGlitch(response, bit);
+  bit = 9;
+  while (!isLateStopBit(identification, bit)) bit += 10;
+  playReadDuringGlitch(identification, bit);
+  CHECK(SDI12::getGlitchCount() == 2);
+}
+
+static void testGlitchesWhileIdle() {
+  startTest("glitches on the idle line before and after a response");
+  std::vector<Glitch> glitches;
+  for (double t = 1000; t < 9000; t += 997) glitches.push_back({t, t + GLITCH_MICROS});
+  auto   edges = encode(response, 10000, BIT_MICROS);
+  double after = edges.back().t + 2 * BIT_MICROS;
+  for (double t = after; t < after + 8000; t += 997) {
+    glitches.push_back({t, t + GLITCH_MICROS});
+  }
+  CHECK(play(receiver, edges, glitches) == response);
+  CHECK(SDI12::getGlitchCount() == glitches.size());
+}
+
+static void testEdgeStorm() {
+  startTest("an edge storm before a response");
+  // 20 ms of pulses every 50 µs, then the response 60 ms after the storm
+  std::vector<Glitch> glitches;
+  for (double t = 20000; t < 40000; t += 50) glitches.push_back({t, t + 15});
+  std::string got = play(receiver, encode(response, 100000, BIT_MICROS), glitches);
+  CHECK(SDI12::getEdgeStormCount() == 1);
+  CHECK(got == response);
+  CHECK(PCMSK2 & 0x80);  // listening again
+}
+
+static void testRandomGlitches() {
+  startTest("random glitches away from the edges, 100 responses at +/-2% baud");
+  srand(2);
+  int intact = 0;
+  for (int k = 0; k < 100; k++) {
+    mySDI12.clearBuffer();
+    double bitWidth = BIT_MICROS * (1.0 + ((rand() % 41) - 20) / 1000.0);
+    auto   edges    = encode(response, 10000, bitWidth);
+    // about one every 5 ms, but none within 1/4 bit of a real change
+    std::vector<Glitch> glitches;
+    for (double t = 0; t < edges.back().t + 10000; t += 2500 + rand() % 5000) {
+      bool nearEdge = false;
+      for (const Edge& e : edges) {
+        if (fabs(e.t - t) < bitWidth / 4 + GLITCH_MICROS) nearEdge = true;
+      }
+      if (!nearEdge) glitches.push_back({t, t + 10 + rand() % 50});
+    }
+    if (play(receiver, edges, glitches) == response) intact++;
+  }
+  printf("  %d/100 intact, %u glitches\n", intact, SDI12::getGlitchCount());
+  CHECK(intact == 100);
+  CHECK(SDI12::getEdgeStormCount() == 0);
+}
+
+int main() {
+  mySDI12.begin();
+  mySDI12.forceListen();
+  testCleanResponse();
+  testGlitchesInRuns();
+  testGlitchFinishingCharacter();
+  testGlitchStartingCharacter();
+  testReadDuringGlitch();
+  testGlitchesWhileIdle();
+  testEdgeStorm();
+  testRandomGlitches();
+  return hostTestResult("NoiseFilterTest");
+}
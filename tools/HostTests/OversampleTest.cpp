@@ -0,0 +1,150 @@
+/**
+ * @file OversampleTest.cpp
+ * @brief Plays the same clean and noisy responses to the receiver the library was built
+ * with, and reports the decode errors and the interrupts run per character.
+ *
+ * Built twice: with `SDI12_OVERSAMPLE` the traces go to the sampling timer interrupt
+ * (a compare match on timer 2 wherever the receiver set OCR2A), and without it to the
+ * pin change interrupt of the plain edge decoder.  The traces are:
+ * - clean responses at 1200 baud +/-2%
+ * - the same with a glitch of 10 to 150 µs, under a quarter of a bit, about every
+ * 2.5 ms anywhere but right on a real change
+ * - a glitch on every bit
+ *
+ * Both must decode all of the clean ones.  The oversampling receiver outvotes a glitch
+ * inside a bit, but one in the quarter bit before a start bit looks the same at 4
+ * samples a bit as one in the start bit, and can shift the character; it must still
+ * get at least 9 in 10 characters of the noisy ones right, where the edge decoder gets
+ * almost none.  The interrupts are counted over the whole of each trace, including the
+ * 20 ms of idle line after the response, which is where the sampling receiver spends
+ * most of them.
+ */
+
+#include "EdgeTrace.h"
+
+/** @brief The number of responses in each set */
+#define RESPONSES 100
+
+#if defined(SDI12_OVERSAMPLE)
+/** @brief Gets the line to the sampling timer interrupt, at each compare match */
+class SampleReceiver : public TraceReceiver {
+ public:
+  using TraceReceiver::TraceReceiver;
+
+  void changed(unsigned long) override {}  // no pin interrupts
+  void runUntil(unsigned long now) override {
+    for (unsigned long tick = _lastTick + 1; tick <= now / 64; tick++) {
+      _lastTick = tick;
+      if (!(TIMSK2 & _BV(OCIE2A)) || (uint8_t)tick != OCR2A) continue;
+      hostSetMicros(tick * 64);
+      isrCalls++;
+      SDI12::handleSampleTimer();
+    }
+  }
+
+ private:
+  unsigned long _lastTick = 0;
+};
+#define RECEIVER "oversampling receiver"
+#else
+/** @brief The plain pin change interrupt */
+typedef TraceReceiver SampleReceiver;
+#define RECEIVER "edge decoder"
+#endif
+
+SDI12          mySDI12(7);
+SampleReceiver receiver(mySDI12);
+
+static const char* response = "0+1.234-5.6789+3\r\n";
+
+/** @brief What a set of responses gave */
+struct Result {
+  int  intact;
+  long wrongCharacters;
+  long isrCalls;
+};
+
+/**
+ * @brief Play a set of responses, with the glitches glitchesFor() gives for each, and
+ * count the responses that came out intact and the characters that didn't
+ */
+template <typename GlitchesFor>
+static Result playSet(const char* name, GlitchesFor glitchesFor) {
+  srand(5);
+  Result result      = {0, 0, 0};
+  long   callsBefore = receiver.isrCalls;
+  for (int k = 0; k < RESPONSES; k++) {
+    mySDI12.clearBuffer();
+    double      bitWidth = BIT_MICROS * (1.0 + ((rand() % 41) - 20) / 1000.0);
+    auto        edges    = encode(response, 10000, bitWidth);
+    std::string got      = play(receiver, edges, glitchesFor(edges, bitWidth));
+    if (got == response) result.intact++;
+    // characters missing, extra or in the wrong place
+    size_t length = std::max(got.size(), strlen(response));
+    for (size_t i = 0; i < length; i++) {
+      if (i >= got.size() || i >= strlen(response) || got[i] != response[i]) {
+        result.wrongCharacters++;
+      }
+    }
+  }
+  result.isrCalls = receiver.isrCalls - callsBefore;
+  printf("  %-28s %3d/%d intact, %4ld characters wrong, %6.1f interrupts a character\n",
+         name, result.intact, RESPONSES, result.wrongCharacters,
+         (double)result.isrCalls / (RESPONSES * strlen(response)));
+  return result;
+}
+
+/** @brief Whether a glitch from t to end would touch a real change */
+static bool nearEdge(const std::vector<Edge>& edges, double t, double end) {
+  for (const Edge& e : edges) {
+    if (e.t > t - 5 && e.t < end + 5) return true;
+  }
+  return false;
+}
+
+int main() {
+  mySDI12.begin();
+  mySDI12.forceListen();
+  printf("%s\n", RECEIVER);
+
+  Result clean = playSet("clean, +/-2% baud",
+                         [](const std::vector<Edge>&, double) {
+                           return std::vector<Glitch>();
+                         });
+  CHECK(clean.intact == RESPONSES);
+
+  Result random = playSet("a glitch every ~2.5 ms",
+                          [](const std::vector<Edge>& edges, double) {
+                            std::vector<Glitch> glitches;
+                            for (double t = 1000; t < edges.back().t + 10000;
+                                 t += 1500 + rand() % 2000) {
+                              double end = t + 10 + rand() % 141;
+                              if (!nearEdge(edges, t, end)) glitches.push_back({t, end});
+                            }
+                            return glitches;
+                          });
+
+  Result everyBit = playSet("a glitch on every bit",
+                            [](const std::vector<Edge>& edges, double bitWidth) {
+                              std::vector<Glitch> glitches;
+                              for (double t = edges.front().t + bitWidth * 0.3;
+                                   t < edges.back().t; t += bitWidth) {
+                                double end = t + 10 + rand() % 141;
+                                if (!nearEdge(edges, t, end)) {
+                                  glitches.push_back({t, end});
+                                }
+                              }
+                              return glitches;
+                            });
+
+#if defined(SDI12_OVERSAMPLE)
+  long characters = RESPONSES * strlen(response);
+  CHECK(random.wrongCharacters < characters / 10);
+  CHECK(everyBit.wrongCharacters < characters / 10);
+  return hostTestResult("OversampleTest");
+#else
+  (void)random;
+  (void)everyBit;
+  return hostTestResult("OversampleTest_Edge");
+#endif
+}
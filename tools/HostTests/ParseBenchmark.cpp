@@ -0,0 +1,138 @@
+/**
+ * @file ParseBenchmark.cpp
+ * @brief Times SDI12::parseValues() on the host, on the corpus of the ParseBenchmark
+ * tool, from memory and as lines in the Rx buffer at every offset, against strtod().
+ *
+ * Built twice: with `SDI12_SWAR_PARSE` the values are taken 8 characters at a time
+ * where they can be, and without it, as ParseBenchmark_Scalar, one character at a
+ * time, as on AVR boards.  For the Rx buffer, each response is put in it at each
+ * offset in turn, and what peekLine() gives for it is kept with a copy of the buffer,
+ * so the lines can all be parsed one after the other; the values across the wrap go
+ * the character way in both builds.  The times and, on x86, the cycles are per value.
+ * These are host numbers only; time them on a board with the ParseBenchmark tool
+ * before relying on them.
+ */
+
+#include <chrono>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_CYCLES
+#endif
+
+// the producer side of the buffer is only for the ISR
+#define private public
+#include "SDI12.h"
+#undef private
+
+/** @brief The number of runs over each set of texts */
+#define RUNS 2000L
+
+SDI12 mySDI12(7);
+
+/** @brief The responses, without their <CR><LF> */
+static const char* const corpus[] = {
+  "0+12.3456+0.0012+25.37",
+  "1+22.54+1013.2+45.61-0.03+3.312+0.000+12.5+7.12+101.25",
+  "2+18.6432+0.0351+35.1234OqZ",
+  "3+0.145+23.7+0.032+0.068+0.052+10.5",
+  "4+1.234567-2.345678+3.456789-4.567890+5.678901-6.789012+7.890123+8.901234",
+  "5+1+2+3+4-5+60+700",
+  "6-12.5-0.0013-273.15+0.5",
+  "7+1234567+9999999-1000000+0.000001",
+};
+
+/** @brief The values parsed, so the parsing isn't optimized away */
+static float values[20];
+
+/** @brief Each value with strtod(), up to the next sign */
+static uint8_t parseStrtod(const char* text) {
+  uint8_t count = 0;
+  while (*text == '+' || *text == '-') {
+    char* end;
+    values[count++ % 20] = strtod(text, &end);
+    if (end == text) break;
+    text = end;
+  }
+  return count;
+}
+
+/** @brief A line as peekLine() gave it, pointing into a copy of the Rx buffer */
+struct RingLine {
+  std::vector<char> buffer;
+  SDI12Line         line;
+};
+
+/** @brief Each response as a line in the Rx buffer, starting at each offset */
+static std::vector<RingLine> ringLines() {
+  std::vector<RingLine> lines;
+  for (const char* response : corpus) {
+    for (size_t offset = 0; offset < SDI12_BUFFER_SIZE; offset++) {
+      mySDI12.clearBuffer();
+      SDI12::_rxBufferHead = SDI12::_rxBufferTail = offset;
+      for (const char* c = response; *c; c++) SDI12::charToBuffer(*c);
+      SDI12::charToBuffer('\r');
+      SDI12::charToBuffer('\n');
+      RingLine    ring;
+      const char* rx = (const char*)SDI12::_rxBuffer;
+      ring.buffer.assign(rx, rx + SDI12_BUFFER_SIZE);
+      mySDI12.peekLine(ring.line);
+      lines.push_back(ring);
+    }
+  }
+  // moved to the copies once they are all in place
+  for (RingLine& ring : lines) {
+    const char* rx   = (const char*)SDI12::_rxBuffer;
+    ring.line.first  = ring.buffer.data() + (ring.line.first - rx);
+    ring.line.second = ring.buffer.data() + (ring.line.second - rx);
+  }
+  return lines;
+}
+
+/** @brief Time parsing each of a set of texts, and print it per value */
+template <typename Parse>
+static void run(const char* name, size_t texts, Parse parse) {
+  volatile size_t sink  = 0;
+  long            count = 0;
+  auto            start = std::chrono::steady_clock::now();
+#if defined(HAVE_CYCLES)
+  unsigned long long startCycles = __rdtsc();
+#endif
+  for (long r = 0; r < RUNS; r++) {
+    for (size_t i = 0; i < texts; i++) count += parse(i);
+  }
+#if defined(HAVE_CYCLES)
+  double cycles = __rdtsc() - startCycles;
+#endif
+  double ns =
+    std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start)
+      .count();
+  sink = count;
+  printf("  %-32s %6.2f ns", name, ns / sink);
+#if defined(HAVE_CYCLES)
+  printf(" %6.2f cycles", cycles / sink);
+#endif
+  printf(" a value\n");
+}
+
+int main() {
+  mySDI12.begin();
+  std::vector<RingLine> lines      = ringLines();
+  size_t                corpusSize = sizeof(corpus) / sizeof(corpus[0]);
+#if defined(SDI12_SWAR_PARSE)
+  printf("Parsing 8 characters at a time, %ld times over each\n", RUNS);
+#else
+  printf("Parsing one character at a time, %ld times over each\n", RUNS);
+#endif
+  run("strtod()", corpusSize, [](size_t i) { return parseStrtod(corpus[i] + 1); });
+  run("parseValues(), from memory", corpusSize, [](size_t i) {
+    const char* text = corpus[i] + 1;
+    return SDI12::parseValues(text, strlen(text), values, 20);
+  });
+  run("parseValues(), every offset", lines.size(),
+      [&](size_t i) { return SDI12::parseValues(lines[i].line, values, 20); });
+  return 0;
+}
@@ -0,0 +1,200 @@
+/**
+ * @file ParseTest.cpp
+ * @brief Checks SDI12::parseValues() on a corpus of responses, cut short at every
+ * point and starting at every offset of the Rx buffer.
+ *
+ * Built twice: with `SDI12_SWAR_PARSE` the values are taken 8 characters at a time
+ * where they can be, and without it, as ParseTest_Scalar, one character at a time, as
+ * on AVR boards.  Either way each value must come out bit for bit the same as from the
+ * character-at-a-time model here, so the two paths agree:
+ * - the text cut short after every character, with digits after the end that must not
+ *   be read, so the 8 character loads at the end of the text are covered
+ * - the responses as lines in the Rx buffer, starting at each of its offsets, so a
+ *   value is split by the wrap at every point and the part after it is a short span
+ * - values of more than 8 characters, leading zeros and second points, which the
+ *   8 character path leaves to the character path
+ * The model is checked against strtod() too.
+ *
+ * Near the end of a span, the 8 character path loads the 8 characters before its end,
+ * and throws away the ones before the value; only a sanitizer sees it load from before
+ * the start of the Rx buffer, so to have AddressSanitizer check that too:
+ *
+ *     make -B CXXFLAGS="-O1 -g -fsanitize=address" run-ParseTest
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "HostTest.h"
+// the producer side of the buffer is only for the ISR
+#define private public
+#include "SDI12.h"
+#undef private
+
+SDI12 mySDI12(7);
+
+/** @brief The responses, without their <CR><LF> */
+static const char* const corpus[] = {
+  // the corpus of the ParseBenchmark tool
+  "0+12.3456+0.0012+25.37",
+  "1+22.54+1013.2+45.61-0.03+3.312+0.000+12.5+7.12+101.25",
+  "2+18.6432+0.0351+35.1234OqZ",
+  "3+0.145+23.7+0.032+0.068+0.052+10.5",
+  "4+1.234567-2.345678+3.456789-4.567890+5.678901-6.789012+7.890123+8.901234",
+  "5+1+2+3+4-5+60+700",
+  "6-12.5-0.0013-273.15+0.5",
+  "7+1234567+9999999-1000000+0.000001",
+  // 7 and 8 characters after the sign, then more than fit in a word
+  "8+1234.56-12345678+123456789-1.2345678+.5+5.",
+  // leading zeros, more than 9 digits, and tiny values
+  "9+00000001.5+1234567890123-0.0000000000123+000.000",
+  // stopped by a second point, a sign with no digits, and other characters
+  "a+1.2.3+4",
+  "b+1-.+2",
+  "c+7.5 +8",
+  "d-0+0.+.0",
+};
+
+/** @brief 10^n as floats */
+static const float divisors[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f,
+                                 1e5f, 1e6f, 1e7f, 1e8f, 1e9f};
+
+/** @brief The values of text, one character at a time, as SDI12::parseValues() does */
+static std::vector<float> model(const std::string& text) {
+  std::vector<float> out;
+  size_t             p = 0;
+  while (p < text.size() && (text[p] == '+' || text[p] == '-')) {
+    bool     negative = text[p++] == '-';
+    uint32_t mantissa = 0;
+    int      decimals = 0, digits = 0, extra = 0;
+    bool     any = false, point = false;
+    for (; p < text.size(); p++) {
+      char c = text[p];
+      if (c >= '0' && c <= '9') {
+        if (digits < 9) {
+          mantissa = mantissa * 10 + (c - '0');
+          if (mantissa) digits++;
+          if (point && decimals < 45) decimals++;
+        } else if (!point) {
+          extra++;
+        }
+        any = true;
+      } else if (c == '.' && !point) {
+        point = true;
+      } else {
+        break;
+      }
+    }
+    if (!any) break;
+    float value = mantissa;
+    for (; decimals > 9; decimals -= 9) value /= divisors[9];
+    if (decimals) value /= divisors[decimals];
+    while (extra--) value *= 10;
+    out.push_back(negative ? -value : value);
+  }
+  return out;
+}
+
+/** @brief Whether the values parsed are the model's, bit for bit */
+static bool same(const std::vector<float>& expected, uint8_t count,
+                 const float* values) {
+  if (count != expected.size()) return false;
+  return memcmp(values, expected.data(), count * sizeof(float)) == 0;
+}
+
+static void testModel() {
+  printf("the model against strtod()\n");
+  for (const char* response : corpus) {
+    std::string        text = response + 1;
+    std::vector<float> values = model(text);
+    // each value is the text up to the next sign, where there is one
+    size_t p = 0;
+    for (float value : values) {
+      double exact = strtod(text.c_str() + p, NULL);
+      CHECK(fabs(value - exact) <= fabs(exact) * 2e-7);
+      p = text.find_first_of("+-", p + 1);
+    }
+  }
+}
+
+static void testCutShort() {
+  printf("the corpus cut short after every character\n");
+  int failures = 0, checked = 0;
+  for (const char* response : corpus) {
+    std::string text = response + 1;
+    for (size_t length = 0; length <= text.size(); length++) {
+      // at each alignment, with digits after the end
+      for (size_t align = 0; align < 8; align++) {
+        std::string buffer = std::string(align, '+') + text.substr(0, length);
+        buffer += "12345678";
+        float   values[20];
+        uint8_t count = SDI12::parseValues(buffer.data() + align, length, values, 20);
+        failures += !same(model(text.substr(0, length)), count, values);
+        checked++;
+      }
+    }
+  }
+  printf("  %d texts\n", checked);
+  CHECK(failures == 0);
+}
+
+/** @brief Empty the buffer with its head and tail at offset */
+static void moveTo(size_t offset) {
+  mySDI12.clearBuffer();
+  while (SDI12::_rxBufferHead != offset) {
+    SDI12::charToBuffer('x');
+    mySDI12.read();
+  }
+}
+
+static void testWrap() {
+  printf("the corpus in the Rx buffer at every offset\n");
+  int failures = 0, wrapped = 0;
+  for (const char* response : corpus) {
+    std::vector<float> expected = model(response + 1);
+    for (size_t offset = 0; offset < SDI12_BUFFER_SIZE; offset++) {
+      moveTo(offset);
+      for (const char* c = response; *c; c++) SDI12::charToBuffer(*c);
+      SDI12::charToBuffer('\r');
+      SDI12::charToBuffer('\n');
+      SDI12Line line;
+      CHECK(mySDI12.peekLine(line));
+      wrapped += line.secondLength > 0;
+      float   values[20];
+      uint8_t count = SDI12::parseValues(line, values, 20);
+      failures += !same(expected, count, values);
+    }
+  }
+  CHECK(failures == 0);
+  CHECK(wrapped > 0);
+}
+
+static void testMaxValues() {
+  printf("more values than there is room for\n");
+  const char*        text     = "+1+2+3+4+5.5";
+  std::vector<float> expected = model(text);
+  float              values[6] = {0, 0, 0, 0, 0, -1};
+  CHECK(SDI12::parseValues(text, strlen(text), values, 3) == 5);
+  CHECK(same(std::vector<float>(expected.begin(), expected.begin() + 3), 3, values));
+  CHECK(values[3] == 0 && values[5] == -1);
+}
+
+int main() {
+  mySDI12.begin();
+#if defined(SDI12_SWAR_PARSE)
+  printf("8 characters at a time\n");
+#else
+  printf("one character at a time\n");
+#endif
+  testModel();
+  testCutShort();
+  testWrap();
+  testMaxValues();
+#if defined(SDI12_SWAR_PARSE)
+  return hostTestResult("ParseTest");
+#else
+  return hostTestResult("ParseTest_Scalar");
+#endif
+}
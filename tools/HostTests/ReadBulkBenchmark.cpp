@@ -0,0 +1,129 @@
+/**
+ * @file ReadBulkBenchmark.cpp
+ * @brief Times readBytes(), readBytesUntil() and readStringUntil() on the host, against
+ * the Stream versions they hide, which call read() and millis() for every character.
+ *
+ * Each run puts an 80 character response in the buffer, at a different offset each
+ * time so the copies are split across the wrap, and reads it back out.  The time and,
+ * on x86, the cycles are per character read.  These are host numbers only, and the
+ * host String is not the Arduino one; time them on a board before relying on them.
+ */
+
+#include <chrono>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_CYCLES
+#endif
+
+// the producer side of the buffer is only for the ISR
+#define private public
+#include "SDI12.h"
+#undef private
+
+/** @brief The number of times each is run */
+#define RUNS 200000L
+
+SDI12 mySDI12(7);
+
+/** @brief An 80 character response */
+static const std::string response =
+  "0+1.234-5.6789+3+12.5-0.001+99999+0.25+1.5+2.5+3.5+4.5+5.5"
+  "+6.5+7.5+8.5+9.5+100\r\n";
+
+/** @brief Stream::readBytes(): read() with a timeout for each character */
+static size_t streamReadBytes(char* buffer, size_t length) {
+  size_t count = 0;
+  while (count < length) {
+    unsigned long start = millis();
+    int           c;
+    while ((c = mySDI12.read()) < 0 && millis() - start < 1) {}
+    if (c < 0) break;
+    *buffer++ = (char)c;
+    count++;
+  }
+  return count;
+}
+
+/** @brief Stream::readBytesUntil() */
+static size_t streamReadBytesUntil(char terminator, char* buffer, size_t length) {
+  size_t count = 0;
+  while (count < length) {
+    unsigned long start = millis();
+    int           c;
+    while ((c = mySDI12.read()) < 0 && millis() - start < 1) {}
+    if (c < 0 || c == terminator) break;
+    *buffer++ = (char)c;
+    count++;
+  }
+  return count;
+}
+
+/** @brief Stream::readStringUntil() */
+static String streamReadStringUntil(char terminator) {
+  String ret;
+  while (true) {
+    unsigned long start = millis();
+    int           c;
+    while ((c = mySDI12.read()) < 0 && millis() - start < 1) {}
+    if (c < 0 || c == terminator) break;
+    ret += (char)c;
+  }
+  return ret;
+}
+
+/** @brief Put the response in the buffer, starting one further along each time */
+static void fill() {
+  static size_t offset = 0;
+  offset               = (offset + 1) % SDI12_BUFFER_SIZE;
+  mySDI12.clearBuffer();
+  SDI12::_rxBufferHead = SDI12::_rxBufferTail = offset;
+  for (char c : response) SDI12::charToBuffer(c);
+}
+
+/** @brief Time a read, less the time to fill the buffer, and print it per character */
+template <typename Read>
+static void run(const char* name, Read read) {
+  volatile size_t sink   = 0;
+  double          ns     = 0;
+  double          cycles = 0;
+  for (long r = 0; r < RUNS; r++) {
+    fill();
+    auto start = std::chrono::steady_clock::now();
+#if defined(HAVE_CYCLES)
+    unsigned long long startCycles = __rdtsc();
+#endif
+    sink = sink + read();
+#if defined(HAVE_CYCLES)
+    cycles += __rdtsc() - startCycles;
+#endif
+    ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() -
+                                                   start)
+            .count();
+  }
+  double characters = (double)RUNS * response.size();
+  printf("  %-28s %6.2f ns", name, ns / characters);
+#if defined(HAVE_CYCLES)
+  printf(" %6.2f cycles", cycles / characters);
+#endif
+  printf(" a character\n");
+}
+
+int main() {
+  mySDI12.begin();
+  mySDI12.setTimeout(1);
+  char buffer[SDI12_BUFFER_SIZE];
+  printf("Reading an 80 character response, %ld times\n", RUNS);
+  run("Stream readBytes()", [&] { return streamReadBytes(buffer, response.size()); });
+  run("SDI12 readBytes()", [&] { return mySDI12.readBytes(buffer, response.size()); });
+  run("Stream readBytesUntil()",
+      [&] { return streamReadBytesUntil('\n', buffer, sizeof(buffer)); });
+  run("SDI12 readBytesUntil()",
+      [&] { return mySDI12.readBytesUntil('\n', buffer, sizeof(buffer)); });
+  run("Stream readStringUntil()",
+      [&] { return (size_t)streamReadStringUntil('\n').length(); });
+  run("SDI12 readStringUntil()",
+      [&] { return (size_t)mySDI12.readStringUntil('\n').length(); });
+  return 0;
+}
@@ -0,0 +1,125 @@
+/**
+ * @file ReadBulkTest.cpp
+ * @brief Checks readBytes(), readBytesUntil() and readStringUntil() with what they read
+ * starting at every offset of the Rx buffer.
+ *
+ * They copy out of the ring with at most two memcpy() calls: the part up to the end of
+ * the array, then the part wrapped around to its start.  Here the buffer holds a long
+ * line and a short one, starting at each of the `SDI12_BUFFER_SIZE` offsets in turn,
+ * so the copy is split at every point of the line, and the terminator is found in the
+ * first segment for some offsets and in the second for the others.  What is read must
+ * be what Stream would have read, and what is left must still be in the buffer.
+ *
+ * The timeout is 0, so the reads stop as soon as the buffer is empty.
+ */
+
+#include <string>
+
+#include "HostTest.h"
+// the producer side of the buffer is only for the ISR
+#define private public
+#include "SDI12.h"
+#undef private
+
+SDI12 mySDI12(7);
+
+/** @brief The characters the buffer holds for each offset: a long line, a short one */
+static const std::string lines =
+  "0+1.234-5.6789+3+12.5-0.001+99999+0.25+1.5+2.5+3.5+4.5+5.5\r\n"
+  "0+1\r\n";
+
+/** @brief Empty the buffer with its head and tail at offset, then put s in it */
+static void fill(size_t offset, const std::string& s) {
+  mySDI12.clearBuffer();
+  while (SDI12::_rxBufferHead != offset) {
+    SDI12::charToBuffer('x');
+    mySDI12.read();
+  }
+  for (char c : s) SDI12::charToBuffer(c);
+}
+
+/** @brief Read what is left in the buffer */
+static std::string rest() {
+  std::string s;
+  int         c;
+  while ((c = mySDI12.read()) >= 0) s += (char)c;
+  return s;
+}
+
+/** @brief The offset of a character of lines in the ring, if lines starts at offset */
+static size_t ringIndex(size_t offset, size_t i) {
+  return (offset + i) % SDI12_BUFFER_SIZE;
+}
+
+static void testReadBytes() {
+  printf("readBytes() at every offset\n");
+  char buffer[SDI12_BUFFER_SIZE];
+  int  failures = 0;
+  for (size_t offset = 0; offset < SDI12_BUFFER_SIZE; offset++) {
+    // all of it, more than there is, and only part of it
+    fill(offset, lines);
+    size_t n  = mySDI12.readBytes(buffer, lines.size());
+    failures += n != lines.size() || std::string(buffer, n) != lines;
+    fill(offset, lines);
+    n = mySDI12.readBytes(buffer, sizeof(buffer));
+    failures += n != lines.size() || std::string(buffer, n) != lines;
+    fill(offset, lines);
+    n = mySDI12.readBytes(buffer, 40);
+    failures += n != 40 || std::string(buffer, n) != lines.substr(0, 40) ||
+      rest() != lines.substr(40);
+  }
+  CHECK(failures == 0);
+}
+
+static void testReadBytesUntil() {
+  printf("readBytesUntil() at every offset\n");
+  size_t end = lines.find('\n');
+  char   buffer[SDI12_BUFFER_SIZE];
+  int    failures = 0, inSecondSegment = 0;
+  for (size_t offset = 0; offset < SDI12_BUFFER_SIZE; offset++) {
+    if (ringIndex(offset, end) < ringIndex(offset, 0)) inSecondSegment++;
+    // the terminator is consumed but not copied, and the next line is left
+    fill(offset, lines);
+    size_t n  = mySDI12.readBytesUntil('\n', buffer, sizeof(buffer));
+    failures += n != end || std::string(buffer, n) != lines.substr(0, end) ||
+      rest() != lines.substr(end + 1);
+    // stopped by the length just before the terminator, which is left
+    fill(offset, lines);
+    n = mySDI12.readBytesUntil('\n', buffer, end);
+    failures += n != end || std::string(buffer, n) != lines.substr(0, end) ||
+      rest() != lines.substr(end);
+    // no terminator: everything there is
+    fill(offset, lines);
+    n = mySDI12.readBytesUntil('#', buffer, sizeof(buffer));
+    failures += n != lines.size() || std::string(buffer, n) != lines;
+  }
+  CHECK(failures == 0);
+  // both segments were covered
+  CHECK(inSecondSegment > 0);
+  CHECK(inSecondSegment < SDI12_BUFFER_SIZE);
+}
+
+static void testReadStringUntil() {
+  printf("readStringUntil() at every offset\n");
+  size_t end      = lines.find('\n');
+  int    failures = 0;
+  for (size_t offset = 0; offset < SDI12_BUFFER_SIZE; offset++) {
+    fill(offset, lines);
+    String line = mySDI12.readStringUntil('\n');
+    failures += line.c_str() != lines.substr(0, end) || rest() != lines.substr(end + 1);
+    // the terminator as the first character
+    fill(offset, lines.substr(end));
+    line = mySDI12.readStringUntil('\n');
+    failures += line.length() != 0 || rest() != lines.substr(end + 1);
+  }
+  CHECK(failures == 0);
+}
+
+int main() {
+  mySDI12.begin();
+  mySDI12.setTimeout(0);
+  testReadBytes();
+  testReadBytesUntil();
+  testReadStringUntil();
+  return hostTestResult("ReadBulkTest");
+}
@@ -0,0 +1,127 @@
+/**
+ * @file RxRingStressTest.cpp
+ * @brief Runs the Rx buffer with the producer and the consumer on two threads, and
+ * times filling and draining it.
+ *
+ * One thread plays the receive ISR and puts a counting sequence into the buffer with
+ * charToBuffer(), waiting whenever it is full; the other takes it out with read() or,
+ * in bulk, with copyFromBuffer(), and checks that every character comes out once and
+ * in order.  On a multi-core host this is the same situation as the ISR and the program
+ * on the two cores of an ESP32; only the acquire/release ordering on the head and tail
+ * keeps the consumer from seeing a new tail before the character under it.
+ *
+ * Then, on one thread, 80 characters (a long response) at a time are put in and taken
+ * out with each, and the time per character printed.
+ *
+ * To have ThreadSanitizer check the ordering too:
+ *
+ *     make -B CXXFLAGS="-O1 -g -fsanitize=thread" run-RxRingStressTest
+ */
+
+#include <chrono>
+#include <thread>
+
+#include "HostTest.h"
+// the producer side of the buffer is only for the ISR
+#define private public
+#include "SDI12.h"
+#undef private
+
+/** @brief The number of characters sent through the buffer by each thread test */
+#define STRESS_CHARACTERS 2000000L
+
+SDI12 mySDI12(7);
+
+/** @brief The ISR side: put count characters of a counting sequence in the buffer */
+static void produce(long count) {
+  uint8_t value = 0;
+  for (long i = 0; i < count;) {
+    uint8_t next = (SDI12::_rxBufferTail + 1) % SDI12_BUFFER_SIZE;
+    if (next == SDI12::loadIndexAcquire(SDI12::_rxBufferHead)) {
+      std::this_thread::yield();  // full
+      continue;
+    }
+    SDI12::charToBuffer(value++);
+    i++;
+  }
+}
+
+static void testTwoThreads(bool bulk) {
+  printf("%s on one thread, charToBuffer() on another\n",
+         bulk ? "copyFromBuffer()" : "read()");
+  mySDI12.clearBuffer();
+  auto        start = std::chrono::steady_clock::now();
+  std::thread producer(produce, STRESS_CHARACTERS);
+
+  long    received = 0, errors = 0;
+  uint8_t expected = 0;
+  uint8_t chunk[SDI12_BUFFER_SIZE];
+  while (received < STRESS_CHARACTERS) {
+    size_t n = 0;
+    if (bulk) {
+      n = SDI12::copyFromBuffer(chunk, sizeof(chunk));
+    } else {
+      int c = mySDI12.read();
+      if (c >= 0) {
+        chunk[0] = c;
+        n        = 1;
+      }
+    }
+    if (n == 0) {
+      std::this_thread::yield();  // empty
+      continue;
+    }
+    for (size_t i = 0; i < n; i++) {
+      if (chunk[i] != expected) {
+        errors++;
+        expected = chunk[i];
+      }
+      expected++;
+    }
+    received += n;
+  }
+  producer.join();
+  double seconds =
+    std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("  %ld characters, %ld out of order, %.1f M characters/s\n", received, errors,
+         received / seconds / 1e6);
+  CHECK(received == STRESS_CHARACTERS);
+  CHECK(errors == 0);
+  CHECK(mySDI12.available() == 0);
+}
+
+static void timeFillAndDrain(bool bulk) {
+  mySDI12.clearBuffer();
+  uint8_t chunk[SDI12_BUFFER_SIZE];
+  long    drained = 0, sum = 0;
+  auto    start   = std::chrono::steady_clock::now();
+  for (long k = 0; k < 100000L; k++) {
+    for (uint8_t i = 0; i < 80; i++) SDI12::charToBuffer(i);
+    if (bulk) {
+      size_t n = SDI12::copyFromBuffer(chunk, sizeof(chunk));
+      drained += n;
+      sum += chunk[n - 1];
+    } else {
+      int c;
+      while ((c = mySDI12.read()) >= 0) {
+        drained++;
+        sum += c;
+      }
+    }
+  }
+  double seconds =
+    std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("  %-16s %6.2f ns a character\n", bulk ? "copyFromBuffer()" : "read()",
+         seconds / drained * 1e9);
+  CHECK(drained == 80 * 100000L);
+  CHECK(sum == 79 * (bulk ? 100000L : 40 * 100000L));
+}
+
+int main() {
+  testTwoThreads(false);
+  testTwoThreads(true);
+  printf("80 characters in, then out, on one thread\n");
+  timeFillAndDrain(false);
+  timeFillAndDrain(true);
+  return hostTestResult("RxRingStressTest");
+}
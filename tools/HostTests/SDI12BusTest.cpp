@@ -0,0 +1,72 @@
+/**
+ * @file SDI12BusTest.cpp
+ * @brief Plays responses to SDI12Bus<7>::handleInterrupt(), the fixed-pin handler, with
+ * another SDI12 instance on pin 8 in the program.
+ *
+ * The handler must only decode while its own bus is the instance that is listening:
+ * not while the bus holds the line itself, nor while the other instance is listening,
+ * but also not stop when the other instance merely changes state, is set up or is
+ * destroyed.
+ */
+
+#include "EdgeTrace.h"
+
+/** @brief Gets the changes of a trace to the fixed-pin handler */
+class BusReceiver : public TraceReceiver {
+ public:
+  using TraceReceiver::TraceReceiver;
+
+ protected:
+  void isr() override {
+    SDI12Bus<7>::handleInterrupt();
+  }
+};
+
+SDI12Bus<7> bus;
+SDI12       other(8);
+BusReceiver receiver(bus);
+
+static const char* response = "0+1.234-5.6789+3\r\n";
+
+static std::string playResponse() {
+  bus.clearBuffer();
+  return play(receiver, encode(response, 10000, BIT_MICROS), {});
+}
+
+static void testListening() {
+  printf("the bus listening on its own\n");
+  bus.begin();
+  bus.forceListen();
+  CHECK(playResponse() == response);
+  printf("the bus holding the line\n");
+  bus.forceHold();
+  CHECK(playResponse() == "");
+}
+
+static void testOtherInstance() {
+  printf("the bus listening while the other instance changes state\n");
+  bus.forceListen();
+  other.forceHold();
+  CHECK(playResponse() == response);
+  other.begin();
+  bus.forceListen();
+  other.forceHold();
+  CHECK(playResponse() == response);
+  {
+    SDI12 temporary(8);
+    temporary.begin();
+  }
+  CHECK(playResponse() == response);
+
+  printf("the other instance listening\n");
+  other.forceListen();
+  CHECK(playResponse() == "");
+  bus.forceListen();
+  CHECK(playResponse() == response);
+}
+
+int main() {
+  testListening();
+  testOtherInstance();
+  return hostTestResult("SDI12BusTest");
+}
@@ -0,0 +1,130 @@
+/**
+ * @file SampleRingStressTest.cpp
+ * @brief Runs an SDI12SampleRing with the producer and the consumer on two threads.
+ *
+ * One thread plays the sampler and fills in a numbered sample at each reserve(), every
+ * field of it from the number, then commits it; the other takes them out with pop()
+ * and checks that every sample comes out whole, once and in order.  On a multi-core
+ * host this is the same situation as the sampler and the program in two tasks on the
+ * two cores of an ESP32; only the acquire/release ordering on the head and tail keeps
+ * the consumer from seeing a new tail before the sample under it, and the producer
+ * from reusing a place before the sample in it has been copied out.
+ *
+ * The producer first waits whenever the ring is full, so nothing may be lost.  Then it
+ * is paced to about the speed of the consumer, which now and then stops for a
+ * millisecond, and drops and counts the samples that don't fit, as the sampler does;
+ * what comes out has gaps but must still be in order, and with the drops must add up.
+ *
+ * To have ThreadSanitizer check the ordering too:
+ *
+ *     make -B CXXFLAGS="-O1 -g -fsanitize=thread" run-SampleRingStressTest
+ */
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+#include "HostTest.h"
+#include "SDI12Sampler.h"
+
+/** @brief The number of samples sent through the ring by each test */
+#define STRESS_SAMPLES 1000000L
+
+/** @brief Fill in every field of a sample from its number */
+static void fillSample(SDI12Sample& sample, uint32_t n) {
+  sample.timestamp = n;
+  sample.address   = '0' + n % 10;
+  sample.count     = n % (SDI12_SAMPLE_MAX_VALUES + 1);
+  for (uint8_t i = 0; i < SDI12_SAMPLE_MAX_VALUES; i++) sample.values[i] = n + i;
+}
+
+/** @brief Whether every field of a sample is the one fillSample() gave it */
+static bool isWhole(const SDI12Sample& sample) {
+  uint32_t n = sample.timestamp;
+  if (sample.address != (char)('0' + n % 10)) return false;
+  if (sample.count != n % (SDI12_SAMPLE_MAX_VALUES + 1)) return false;
+  for (uint8_t i = 0; i < SDI12_SAMPLE_MAX_VALUES; i++) {
+    if (sample.values[i] != (float)(n + i)) return false;
+  }
+  return true;
+}
+
+/** @brief Set by the producer once it has committed its last sample */
+static std::atomic<bool> produced;
+
+/** @brief The sampler side: count samples, waiting or dropping when the ring is full */
+static void produce(SDI12SampleRing& ring, long count, bool drop) {
+  for (long n = 0; n < count;) {
+    SDI12Sample* sample = ring.reserve();
+    if (sample) {
+      fillSample(*sample, n++);
+      ring.commit();
+    } else if (drop) {
+      ring.drop();
+      n++;
+    }
+    // full and waiting, or paced to about the speed of the consumer
+    if (!sample || drop) std::this_thread::yield();
+  }
+  produced = true;
+}
+
+static void testTwoThreads(bool drop) {
+  printf("pop() on one thread, reserve() and commit() on another, %s when full\n",
+         drop ? "dropping" : "waiting");
+  static SDI12SampleRing ring;
+  ring     = SDI12SampleRing();
+  produced = false;
+  auto        start = std::chrono::steady_clock::now();
+  std::thread producer(produce, std::ref(ring), STRESS_SAMPLES, drop);
+
+  long        received = 0, torn = 0, outOfOrder = 0, tooMany = 0;
+  long        next     = 0;  // the lowest number the next sample can have
+  SDI12Sample sample;
+  while (true) {
+    if (ring.available() >= SDI12_SAMPLE_RING_SIZE) tooMany++;
+    if (!ring.pop(sample)) {
+      // everything committed before the flag was set can be seen once it is
+      if (!produced) {
+        std::this_thread::yield();  // empty
+        continue;
+      }
+      if (!ring.pop(sample)) break;
+    }
+    received++;
+    torn += !isWhole(sample);
+    // without drops every number comes in turn; with them, some are skipped
+    if (drop ? (long)sample.timestamp < next : (long)sample.timestamp != next) {
+      outOfOrder++;
+    }
+    next = sample.timestamp + 1;
+    // now and then the program is busy, and the ring fills up
+    if (drop && received % 4096 == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  producer.join();
+  double seconds =
+    std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("  %ld samples, %u dropped, %ld torn, %ld out of order, %.1f M samples/s\n",
+         received, ring.dropped(), torn, outOfOrder, received / seconds / 1e6);
+  CHECK(torn == 0);
+  CHECK(outOfOrder == 0);
+  CHECK(tooMany == 0);
+  CHECK(ring.available() == 0);
+  if (drop) {
+    // the drop count wraps at 65535
+    CHECK(received < STRESS_SAMPLES);
+    CHECK(ring.dropped() == (uint16_t)(STRESS_SAMPLES - received));
+  } else {
+    CHECK(received == STRESS_SAMPLES);
+    CHECK(ring.dropped() == 0);
+  }
+}
+
+int main() {
+  testTwoThreads(false);
+  testTwoThreads(true);
+  return hostTestResult("SampleRingStressTest");
+}
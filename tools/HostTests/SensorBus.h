@@ -0,0 +1,79 @@
+/**
+ * @file SensorBus.h
+ * @brief Sending commands to the sensor-mode classes and reading what they send back,
+ * shared by the sensor tests.
+ *
+ * A command is played to the data pin as an edge trace, after a break unless asked
+ * not to, so it goes through the receive ISR like one from a real recorder.  The reply
+ * is sent by the library's own writeChar(), which spins on timer 2; the host timer
+ * moves on a tick each time it is read while a poll runs, and the data output of the
+ * pin is recorded for each tick and decoded back into characters.
+ */
+#pragma once
+
+#include "EdgeTrace.h"
+
+/** @brief The break before a command, in µs */
+#define BREAK_MICROS 12000
+/** @brief The marking after the break, in µs */
+#define MARKING_MICROS 8333
+
+/**
+ * @brief Play a command to a receiver, leaving it in the buffer
+ *
+ * @param receiver The receiver of the sensor's bus
+ * @param command The command, e.g. "5M!"
+ * @param withBreak Whether to send the break and marking first
+ */
+inline void playCommand(TraceReceiver& receiver, const std::string& command,
+                        bool withBreak = true) {
+  std::vector<Edge> edges;
+  double            t = 10000;
+  if (withBreak) {
+    edges.push_back({t, HIGH});
+    edges.push_back({t + BREAK_MICROS, LOW});
+    t += BREAK_MICROS + MARKING_MICROS;
+  }
+  for (const Edge& e : encode(command.c_str(), t, BIT_MICROS)) edges.push_back(e);
+  play(receiver, edges, {}, false);
+}
+
+/**
+ * @brief Decode the characters in the recorded data output.
+ *
+ * writeChar() reads the timer once more at the start of each bit, so every bit up to
+ * the last HIGH one is 14 ticks long; after that the line stays LOW (1s and the stop
+ * bit) until the next start bit, which is the only thing needed to find it.
+ */
+inline std::string decodeLineTicks(const std::vector<uint8_t>& ticks) {
+  std::string out;
+  size_t      i = 0;
+  while (true) {
+    while (i < ticks.size() && ticks[i] == LOW) i++;
+    if (i >= ticks.size()) break;
+    // i is the start bit; sample the middle of each of the 7 data bits
+    uint8_t c = 0;
+    for (int bit = 0; bit < 7; bit++) {
+      size_t sample = i + 14 * (bit + 1) + 7;
+      if (sample < ticks.size() && ticks[sample] == LOW) c |= 1 << bit;
+    }
+    out += (char)c;
+    i += 14 * 9 + 1;  // past the last HIGH bit it could have had
+  }
+  return out;
+}
+
+/**
+ * @brief Run a poll, and get what was sent during it
+ *
+ * @param poll Calls the poll() of the sensor or node
+ * @return **std::string** Everything sent, e.g. "5\r\n", or "" for no reply
+ */
+template <typename Poll>
+inline std::string pollReply(Poll poll) {
+  hostLineTicks.clear();
+  hostTimerRunning = true;
+  poll();
+  hostTimerRunning = false;
+  return decodeLineTicks(hostLineTicks);
+}
@@ -0,0 +1,111 @@
+/**
+ * @file SensorNodeTest.cpp
+ * @brief Sends commands to an SDI12SensorNode of four virtual sensors over the data
+ * line and checks that each is answered by the sensor at its address, before and
+ * after the addresses change.
+ *
+ * Built twice: as it is, and as SensorNodeTest_Filter with `SDI12_BREAK_DETECT` and
+ * `SDI12_ADDRESS_FILTER`, where the receive ISR drops the commands to the addresses
+ * none of the sensors have, and the filter has to follow the address changes.
+ */
+
+#include <string>
+
+#include "SensorBus.h"
+#include "SDI12DataPages.h"
+#include "SDI12SensorNode.h"
+
+SDI12 mySDI12(7);
+
+/** @brief Answers with the name in the sensor's context */
+static int identify(SDI12Sensor& sensor, const char*, char* reply, uint8_t size) {
+  return snprintf(reply, size, "14TESTCOMP%s", (const char*)sensor.getContext());
+}
+
+static const SDI12Command commands[] = {{"I", identify}};
+
+SDI12Sensor         probe1(mySDI12, '1', commands, 1);
+SDI12Sensor         probe2(mySDI12, '2', commands, 1);
+SDI12Sensor         probeA(mySDI12, 'a', commands, 1);
+SDI12Sensor         probeZ(mySDI12, 'Z', commands, 1);
+SDI12Sensor* const  probes[] = {&probe1, &probe2, &probeA, &probeZ};
+SDI12SensorNode     node(mySDI12, probes, 4);
+SDI12DataPages      pages[4];
+TraceReceiver       receiver(mySDI12);
+
+/** @brief Send a command, and get the reply */
+static std::string ask(const std::string& command, bool withBreak = true) {
+  playCommand(receiver, command, withBreak);
+  return pollReply([] { node.poll(); });
+}
+
+static void testRouting() {
+  printf("each command to the sensor at its address\n");
+  CHECK(ask("1I!") == "114TESTCOMPPROBE1\r\n");
+  CHECK(ask("2I!") == "214TESTCOMPPROBE2\r\n");
+  CHECK(ask("aI!") == "a14TESTCOMPPROBEA\r\n");
+  CHECK(ask("ZI!") == "Z14TESTCOMPPROBEZ\r\n");
+  // the addresses are case sensitive, and no one is at the others
+  CHECK(ask("AI!") == "");
+  CHECK(ask("zI!") == "");
+  CHECK(ask("3!") == "");
+  // the first sensor answers ?!, as only one may
+  CHECK(ask("?!") == "1\r\n");
+  // the data commands from each sensor's own pages
+  for (int i = 0; i < 4; i++) {
+    float value = i + 1;
+    pages[i].set(&value, 1, SDI12_PAGE_SIZE_M);
+  }
+  CHECK(ask("1D0!") == "1+1.000000\r\n");
+  CHECK(ask("2D0!") == "2+2.000000\r\n");
+  CHECK(ask("aD0!") == "a+3.000000\r\n");
+  CHECK(ask("ZD0!") == "Z+4.000000\r\n");
+  // one after another without breaks, as to sensors that are still awake
+  CHECK(ask("ZD0!", false) == "Z+4.000000\r\n");
+  CHECK(ask("2!", false) == "2\r\n");
+}
+
+static void testChangeAddress() {
+  printf("change address\n");
+  // to an address another sensor has: no reply, nothing changes
+  CHECK(ask("2A1!") == "");
+  CHECK(probe2.getAddress() == '2');
+  CHECK(ask("1I!") == "114TESTCOMPPROBE1\r\n");
+  // to a free one: the reply comes from the new address, and the old one is free
+  CHECK(ask("2A7!") == "7\r\n");
+  CHECK(ask("7I!") == "714TESTCOMPPROBE2\r\n");
+  CHECK(ask("2I!") == "");
+  CHECK(node.find('7') == &probe2);
+  CHECK(node.find('2') == NULL);
+  // so another sensor can take it
+  CHECK(probeZ.setAddress('2'));
+  CHECK(ask("2I!") == "214TESTCOMPPROBEZ\r\n");
+  CHECK(ask("ZI!") == "");
+  // and back
+  CHECK(ask("7A2!") == "");
+  CHECK(probeZ.setAddress('Z'));
+  CHECK(ask("7A2!") == "2\r\n");
+  CHECK(ask("ZI!") == "Z14TESTCOMPPROBEZ\r\n");
+  CHECK(ask("2I!") == "214TESTCOMPPROBE2\r\n");
+}
+
+int main() {
+  const char* names[] = {"PROBE1", "PROBE2", "PROBEA", "PROBEZ"};
+  for (int i = 0; i < 4; i++) {
+    probes[i]->setContext((void*)names[i]);
+    probes[i]->setDataPages(&pages[i]);
+  }
+  node.begin();
+#if defined(SDI12_ADDRESS_FILTER)
+  printf("commands to other addresses dropped by the receive ISR\n");
+#else
+  printf("commands to other addresses dropped by the node\n");
+#endif
+  testRouting();
+  testChangeAddress();
+#if defined(SDI12_ADDRESS_FILTER)
+  return hostTestResult("SensorNodeTest_Filter");
+#else
+  return hostTestResult("SensorNodeTest");
+#endif
+}
@@ -0,0 +1,107 @@
+/**
+ * @file SensorTest.cpp
+ * @brief Sends commands to an SDI12Sensor over the data line and checks what it
+ * answers, and that it picks each command out of whatever came before it.
+ *
+ * Built twice: without `SDI12_BREAK_DETECT` the break before each command is read as a
+ * character or two of garbage, which nextCommand() has to skip, and with it, as
+ * SensorTest_Break, the receive ISR drops everything from before the break.  Either way
+ * the sensor has to answer a command after another sensor's response, the end of an
+ * overlong command, and ?! but nothing else starting with '?'.
+ */
+
+#include <string>
+
+#include "SensorBus.h"
+#include "SDI12Sensor.h"
+
+SDI12 mySDI12(7);
+
+static int identify(SDI12Sensor&, const char*, char* reply, uint8_t size) {
+  return snprintf(reply, size, "14TESTCOMPSENSOR001");
+}
+
+/** @brief Echoes the body of an extended command, to see what the sensor kept of it */
+static int echo(SDI12Sensor&, const char* command, char* reply, uint8_t size) {
+  return snprintf(reply, size, "%s", command);
+}
+
+static const SDI12Command commands[] = {{"I", identify}, {"X", echo}};
+
+SDI12Sensor   sensor(mySDI12, '5', commands, 2);
+TraceReceiver receiver(mySDI12);
+
+/** @brief Send a command, and get the reply */
+static std::string ask(const std::string& command, bool withBreak = true) {
+  playCommand(receiver, command, withBreak);
+  return pollReply([] { sensor.poll(); });
+}
+
+static void testCommands() {
+  printf("acknowledge, address query, identify, another address\n");
+  CHECK(ask("5!") == "5\r\n");
+  CHECK(ask("?!") == "5\r\n");
+  CHECK(ask("5I!") == "514TESTCOMPSENSOR001\r\n");
+  CHECK(ask("3I!") == "");
+  CHECK(ask("5Z!") == "");  // no handler, no reply
+  // '?' only stands for the address in ?!
+  CHECK(ask("?I!") == "");
+  CHECK(ask("5!") == "5\r\n");
+}
+
+static void testAfterResponse() {
+  printf("a command straight after another sensor's response\n");
+  // the recorder sends the next command to a sensor that is still awake, without a
+  // break, and the response before it is in the same line
+  CHECK(ask("3+1.234-5.6789\r\n5I!", false) == "514TESTCOMPSENSOR001\r\n");
+  // with garbage after the LF, such as a glitch
+  CHECK(ask("3+1\r\n\x01+ 5!", false) == "5\r\n");
+}
+
+static void testBreakGarbage() {
+  printf("the break left in front of the command\n");
+  // a break before each command, and some commands the sensor ignores in between
+  for (int i = 0; i < 20; i++) {
+    CHECK(ask("5!") == "5\r\n");
+    CHECK(ask("3M!") == "");
+    std::string conf = "XCONF=" + std::to_string(i);
+    CHECK(ask("5" + conf + "!") == "5" + conf + "\r\n");
+  }
+  // and non-address characters that look like it
+  CHECK(ask(std::string("\x7F\x01.+-", 5) + "5!", false) == "5\r\n");
+}
+
+static void testOverlong() {
+  printf("overlong commands\n");
+  // a long run of garbage with no address character in it: the command is at the end
+  std::string garbage(SDI12_SENSOR_COMMAND_SIZE + 16, '+');
+  CHECK(ask(garbage + "5I!") == "514TESTCOMPSENSOR001\r\n");
+  CHECK(ask(garbage + "?!", false) == "5\r\n");
+  // an extended command that is too long loses its start, address and all, so it goes
+  // unanswered rather than being taken for someone else's
+  std::string body(2 * SDI12_SENSOR_COMMAND_SIZE, 'A');
+  CHECK(ask("5X" + body + "!") == "");
+  // one that just fits is kept whole
+  std::string fits(SDI12_SENSOR_COMMAND_SIZE - 2, 'B');
+  CHECK(ask("5X" + fits + "!") == "5X" + fits + "\r\n");
+  // and the sensor is still answering
+  CHECK(ask("5!") == "5\r\n");
+}
+
+int main() {
+  sensor.begin();
+#if defined(SDI12_BREAK_DETECT)
+  printf("breaks recognized by the receive ISR\n");
+#else
+  printf("breaks read as garbage\n");
+#endif
+  testCommands();
+  testAfterResponse();
+  testBreakGarbage();
+  testOverlong();
+#if defined(SDI12_BREAK_DETECT)
+  return hostTestResult("SensorTest_Break");
+#else
+  return hostTestResult("SensorTest");
+#endif
+}
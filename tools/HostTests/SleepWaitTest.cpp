@@ -0,0 +1,180 @@
+/**
+ * @file SleepWaitTest.cpp
+ * @brief Simulates the time an ATmega328P spends busy and asleep in waitAvailable(),
+ * while a response comes in and while a read times out.
+ *
+ * Built twice: with `SDI12_SLEEP_WAIT` the wait goes into idle sleep between checks,
+ * and without it, as SleepWaitTest_Spin, it calls yield() in a loop.  The simulation
+ * runs on the host clock, with the costs of a 16 MHz board:
+ * - each pass of the waiting loop (available(), millis()) takes #PASS_MICROS
+ * - the millis() timer interrupt comes every 1000 µs and takes #TICK_MICROS
+ * - each change of the data line runs the receive interrupt, #ISR_MICROS, and the
+ *   character is in the buffer at the end of its stop bit
+ *
+ * yield() moves the clock on by a pass; sleep_cpu() moves it to the next interrupt and
+ * counts the time in between as idle.  The current is worked out from the busy time,
+ * at #ACTIVE_MA busy and #IDLE_MA in idle sleep.  These are a model, not measurements.
+ */
+
+// the producer side of the buffer is only for the ISR
+#define private public
+#include "SDI12.h"
+#undef private
+
+#include "EdgeTrace.h"
+
+/** @brief The time for one pass of the waiting loop, in µs */
+#define PASS_MICROS 2
+/** @brief The time for the millis() timer interrupt, in µs */
+#define TICK_MICROS 4
+/** @brief The time for the receive interrupt, for each change of the line, in µs */
+#define ISR_MICROS 10
+/** @brief The current of an ATmega328P at 16 MHz and 5 V, running */
+#define ACTIVE_MA 9.5
+/** @brief ... and in idle sleep */
+#define IDLE_MA 2.5
+
+SDI12 mySDI12(7);
+
+/** @brief A character and when it is in the buffer, with its receive interrupt time */
+struct Arrival {
+  unsigned long t;
+  char          c;
+  unsigned long isrMicros;
+};
+
+static std::vector<Arrival> arrivals;
+static size_t               nextArrival;
+static unsigned long        now;
+static unsigned long        idleMicros;
+static unsigned long        lastArrival;
+static unsigned long        lastTick;
+
+/** @brief Run the interrupts due by now, each moving the clock on by its own time */
+static void runInterrupts() {
+  while (true) {
+    unsigned long tick = (lastTick / 1000 + 1) * 1000;
+    bool character = nextArrival < arrivals.size() && arrivals[nextArrival].t <= tick;
+    unsigned long due = character ? arrivals[nextArrival].t : tick;
+    if (due > now) break;
+    if (character) {
+      SDI12::charToBuffer(arrivals[nextArrival].c);
+      lastArrival = arrivals[nextArrival].t;
+      now += arrivals[nextArrival++].isrMicros;
+    } else {
+      lastTick = tick;
+      now += TICK_MICROS;
+    }
+  }
+  hostSetMicros(now);
+}
+
+/** @brief yield(): the loop goes round again */
+static void spin() {
+  now += PASS_MICROS;
+  runInterrupts();
+}
+
+/** @brief sleep_cpu(): idle until the next interrupt */
+static void sleep() {
+  now += PASS_MICROS;
+  unsigned long wake = (now / 1000 + 1) * 1000;
+  if (nextArrival < arrivals.size()) wake = std::min(wake, arrivals[nextArrival].t);
+  if (wake > now) {
+    idleMicros += wake - now;
+    now = wake;
+  }
+  runInterrupts();
+}
+
+/** @brief Queue a response to arrive starting at t */
+static void sendResponse(const char* response, unsigned long t) {
+  arrivals.clear();
+  nextArrival = 0;
+  for (const char* c = response; *c; c++) {
+    // each character's changes, 10 bits from its start bit
+    size_t        changes = encode(std::string(1, *c).c_str(), 0, BIT_MICROS).size();
+    unsigned long end     = t + (unsigned long)(10 * BIT_MICROS);
+    arrivals.push_back({end, *c, changes * ISR_MICROS});
+    t = end;
+  }
+}
+
+/** @brief What a wait cost */
+struct Cost {
+  double busyPercent;
+  double milliamps;
+  double elapsedMillis;
+};
+
+/** @brief Run a wait from the current time, and work out what it cost */
+template <typename Wait>
+static Cost simulate(const char* name, Wait wait) {
+  unsigned long start = now;
+  idleMicros          = 0;
+  wait();
+  double elapsed = now - start;
+  double busy    = (elapsed - idleMicros) / elapsed;
+  Cost   cost    = {busy * 100, busy * ACTIVE_MA + (1 - busy) * IDLE_MA,
+                    elapsed / 1000};
+  printf("  %-40s %7.1f ms, busy %5.1f%%, %5.2f mA average\n", name, cost.elapsedMillis,
+         cost.busyPercent, cost.milliamps);
+  return cost;
+}
+
+static void testResponse() {
+  const char* response = "0+1.234-5.6789+3\r\n";
+  mySDI12.clearBuffer();
+  sendResponse(response, now + 50000);
+  String got;
+  Cost   cost = simulate("readStringUntil(), reply after 50 ms",
+                         [&] { got = mySDI12.readStringUntil('\n'); });
+  printf("  %-40s %7lu µs after the LF\n", "returned", now - lastArrival);
+  CHECK(strcmp(got.c_str(), "0+1.234-5.6789+3\r") == 0);
+  CHECK(now - lastArrival < 100);
+#if defined(SDI12_SLEEP_WAIT)
+  CHECK(cost.busyPercent < 5);
+#else
+  CHECK(cost.busyPercent == 100);
+#endif
+}
+
+static void testTimeout() {
+  mySDI12.clearBuffer();
+  sendResponse("", 0);
+  bool got  = true;
+  Cost cost = simulate("waitAvailable() timing out after 1500 ms",
+                       [&] { got = mySDI12.waitAvailable(1, 1500); });
+  CHECK(!got);
+  // millis() only counts whole milliseconds
+  CHECK(cost.elapsedMillis > 1499 && cost.elapsedMillis < 1502);
+#if defined(SDI12_SLEEP_WAIT)
+  CHECK(cost.busyPercent < 5);
+#else
+  CHECK(cost.busyPercent == 100);
+#endif
+}
+
+int main() {
+  hostYieldHook = spin;
+  hostSleepHook = sleep;
+  mySDI12.begin();
+  mySDI12.setTimeout(1000);
+  SREG = 0x80;  // nothing sleeps with the interrupts off
+  now      = 1000000;
+  lastTick = now;
+  hostSetMicros(now);
+#if defined(SDI12_SLEEP_WAIT)
+  printf("sleeping in waitAvailable()\n");
+#else
+  printf("spinning in waitAvailable()\n");
+#endif
+  testResponse();
+  testTimeout();
+#if defined(SDI12_SLEEP_WAIT)
+  CHECK(SREG == 0x80);
+  return hostTestResult("SleepWaitTest");
+#else
+  return hostTestResult("SleepWaitTest_Spin");
+#endif
+}
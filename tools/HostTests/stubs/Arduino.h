@@ -0,0 +1,162 @@
+/**
+ * @file Arduino.h
+ * @brief Just enough of the Arduino core for the library to build on the host, as an
+ * ATmega328P.
+ *
+ * Time doesn't pass by itself: the tests move it with hostSetMicros(), which also sets
+ * timer 2 the way the library programs it (64 µs a tick) and runs its overflow
+ * interrupt.  The registers are plain variables, declared in avr_registers.h.
+ */
+#pragma once
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+typedef uint8_t byte;
+typedef bool    boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+#define PROGMEM
+#ifndef F_CPU
+#define F_CPU 16000000L
+#endif
+#define clockCyclesPerMicrosecond() (F_CPU / 1000000L)
+#define digitalPinToInterrupt(p) (p)
+
+typedef const char* PGM_P;
+class __FlashStringHelper;
+#define F(s) ((const __FlashStringHelper*)(s))
+inline uint8_t pgm_read_byte(const void* p) {
+  return *(const uint8_t*)p;
+}
+inline size_t strlen_P(const char* s) {
+  return strlen(s);
+}
+
+void          pinMode(uint8_t pin, uint8_t mode);
+void          digitalWrite(uint8_t pin, uint8_t value);
+int           digitalRead(uint8_t pin);
+unsigned long micros();
+unsigned long millis();
+void          delay(unsigned long ms);
+void          delayMicroseconds(unsigned int us);
+void          yield();
+void          noInterrupts();
+void          interrupts();
+void          attachInterrupt(uint8_t interrupt, void (*isr)(void), int mode);
+void          detachInterrupt(uint8_t interrupt);
+
+/** @brief Set the host clock, and timer 2 with it */
+void hostSetMicros(unsigned long us);
+/**
+ * @brief Called by yield() and sleep_cpu(), if set, so a test can move the clock on and
+ * run the interrupts that would have come in meanwhile
+ */
+extern void (*hostYieldHook)();
+extern void (*hostSleepHook)();
+/** @brief The data output of pin 7, a timer 2 tick at a time; see HostTimer2 */
+extern std::vector<uint8_t> hostLineTicks;
+
+/** @brief A fixed-size String; only what the library uses */
+class String {
+ public:
+  String(const char* s = "") {
+    strncpy(_b, s, sizeof(_b) - 1);
+    _b[sizeof(_b) - 1] = '\0';
+  }
+  explicit String(char c) {
+    _b[0] = c;
+    _b[1] = '\0';
+  }
+  unsigned int length() const {
+    return strlen(_b);
+  }
+  char operator[](unsigned int i) const {
+    return _b[i];
+  }
+  char charAt(unsigned int i) const {
+    return _b[i];
+  }
+  String& operator+=(char c) {
+    size_t l = strlen(_b);
+    if (l < sizeof(_b) - 1) {
+      _b[l]     = c;
+      _b[l + 1] = '\0';
+    }
+    return *this;
+  }
+  String& operator+=(const char* s) {
+    strncat(_b, s, sizeof(_b) - 1 - strlen(_b));
+    return *this;
+  }
+  bool reserve(unsigned int) {
+    return true;
+  }
+  const char* c_str() const {
+    return _b;
+  }
+
+ private:
+  char _b[256];
+};
+
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) n += write(*buffer++);
+    return n;
+  }
+  size_t write(const char* s) {
+    return write((const uint8_t*)s, strlen(s));
+  }
+  virtual void flush() {}
+};
+
+enum LookaheadMode { SKIP_ALL, SKIP_NONE, SKIP_WHITESPACE };
+
+class Stream : public Print {
+ public:
+  virtual int available() = 0;
+  virtual int read()      = 0;
+  virtual int peek()      = 0;
+  void        setTimeout(unsigned long timeout) {
+    _timeout = timeout;
+  }
+
+ protected:
+  unsigned long _timeout = 1000;
+  unsigned long _startMillis;
+  int           timedRead() {
+    _startMillis = millis();
+    do {
+      int c = read();
+      if (c >= 0) return c;
+    } while (millis() - _startMillis < _timeout);
+    return -1;
+  }
+  int timedPeek() {
+    _startMillis = millis();
+    do {
+      int c = peek();
+      if (c >= 0) return c;
+    } while (millis() - _startMillis < _timeout);
+    return -1;
+  }
+};
+
+#include "avr_registers.h"
+#include <avr/interrupt.h>
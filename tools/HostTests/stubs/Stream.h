@@ -0,0 +1,3 @@
+// Host stand-in for the Arduino Stream header; everything is in Arduino.h
+#pragma once
+#include "Arduino.h"
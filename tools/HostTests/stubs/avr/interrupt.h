@@ -0,0 +1,10 @@
+// Host stand-in for <avr/interrupt.h>; the tests have no real interrupts, but cli() and
+// sei() clear and set the I bit of SREG so a test can see what the library left on
+#pragma once
+#include "avr_registers.h"
+inline void cli() {
+  SREG &= ~0x80;
+}
+inline void sei() {
+  SREG |= 0x80;
+}
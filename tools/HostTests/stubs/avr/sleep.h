@@ -0,0 +1,7 @@
+// Host stand-in for <avr/sleep.h>
+#pragma once
+#define SLEEP_MODE_IDLE 0
+inline void set_sleep_mode(int) {}
+inline void sleep_enable() {}
+inline void sleep_disable() {}
+void        sleep_cpu();
@@ -0,0 +1,65 @@
+/**
+ * @file avr_registers.h
+ * @brief The ATmega328P registers and pin maps the library uses, as plain variables.
+ *
+ * Only digital pin 7 (PD7, PCINT23) and pin 8 (PB0, ICP1) are wired up.
+ */
+#pragma once
+#include <stdint.h>
+
+/**
+ * @brief Timer 2's count.  While hostTimerRunning is set, each read moves it on a tick,
+ * as though the program had spent that long spinning on it, and the level of the data
+ * output of pin 7 over that tick is added to hostLineTicks, so a test can see what was
+ * sent.
+ */
+struct HostTimer2 {
+  uint8_t     value;
+  operator uint8_t();
+  HostTimer2& operator=(uint8_t v) {
+    value = v;
+    return *this;
+  }
+};
+extern HostTimer2       TCNT2;
+extern bool             hostTimerRunning;
+extern volatile uint8_t TCCR2A, TCCR2B, TIFR2, TIMSK2, OCR2A, OCR2B;
+extern volatile uint8_t TCCR1A, TCCR1B, TIFR1, TIMSK1;
+extern volatile uint16_t TCNT1, ICR1;
+extern volatile uint8_t SREG, SMCR, MCUCR, PCICR, PCMSK0, PCMSK1, PCMSK2;
+extern volatile uint8_t PINB, PORTB, DDRB, PINC, PIND, PORTD, DDRD;
+
+#define _BV(b) (1 << (b))
+#define TOV2 0
+#define TOIE2 0
+#define OCF2A 1
+#define OCIE2A 1
+#define OCF2B 2
+#define OCIE2B 2
+#define CS11 1
+#define ICF1 5
+#define ICIE1 5
+#define ICES1 6
+#define ICNC1 7
+
+#define NOT_A_PIN 0
+#define digitalPinToPCICR(p) (&PCICR)
+#define digitalPinToPCICRbit(p) (((p) <= 7) ? 2 : 0)
+#define digitalPinToPCMSK(p) (((p) <= 7) ? &PCMSK2 : &PCMSK0)
+#define digitalPinToPCMSKbit(p) ((p)&7)
+#define digitalPinToPort(p) (((p) <= 7) ? 4 : 2)
+#define digitalPinToBitMask(p) (1 << ((p)&7))
+#define portInputRegister(P) (((P) == 4) ? &PIND : &PINB)
+#define portOutputRegister(P) (((P) == 4) ? &PORTD : &PORTB)
+#define portModeRegister(P) (((P) == 4) ? &DDRD : &DDRB)
+
+#define PCINT0_vect __vector_3
+#define PCINT1_vect __vector_4
+#define PCINT2_vect __vector_5
+#define TIMER2_COMPA_vect __vector_7
+#define TIMER2_COMPB_vect __vector_8
+#define TIMER2_OVF_vect __vector_9
+#define TIMER1_CAPT_vect __vector_10
+#define ISR(vector)               \
+  extern "C" void vector(void); \
+  extern "C" void vector(void)
@@ -0,0 +1,3 @@
+// Host stand-in for <util/parity.h>
+#pragma once
+#define parity_even_bit(v) (__builtin_parity(v))
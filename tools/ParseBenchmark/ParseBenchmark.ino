@@ -0,0 +1,120 @@
+/**
+ * @file ParseBenchmark.ino
+ * @copyright (c) 2013-2020 Stroud Water Research Center (SWRC)
+ *                          and the EnviroDIY Development Team
+ *            This example is published under the BSD-3 license.
+ *
+ * @brief Tool to time parsing the values out of data and continuous measurement
+ * responses on the target board.
+ *
+ * Nothing needs to be attached.  The responses are a small corpus of the kinds real
+ * sensors send: flow and level (aR0!), multi-parameter sondes with 9 values to a page,
+ * pages with CRCs, full 75 character pages, integers and negative values.  Each is
+ * parsed, over many repetitions:
+ * - one character at a time, the way parseFloat() reads the Rx buffer (but from
+ * memory, so without its per-character timedPeek() and read() calls)
+ * - with strtod(), one value at a time
+ * - with SDI12::parseValues(), which on 32-bit boards takes 8 characters at a time
+ *
+ * The times are per response, averaged over the corpus.
+ */
+
+#include <SDI12.h>
+
+#define SERIAL_BAUD 115200 /*!< The baud rate for the output serial port */
+#define REPS 200           /*!< The number of repetitions to average over */
+#define MAX_VALUES 20      /*!< The most values in a response */
+
+/** The responses, without their <CR><LF> */
+const char* const corpus[] = {
+  "0+12.3456+0.0012+25.37",
+  "1+22.54+1013.2+45.61-0.03+3.312+0.000+12.5+7.12+101.25",
+  "2+18.6432+0.0351+35.1234OqZ",
+  "3+0.145+23.7+0.032+0.068+0.052+10.5",
+  "4+1.234567-2.345678+3.456789-4.567890+5.678901-6.789012+7.890123+8.901234",
+  "5+1+2+3+4-5+60+700",
+  "6-12.5-0.0013-273.15+0.5",
+  "7+1234567+9999999-1000000+0.000001",
+};
+/** The number of responses in the corpus */
+const uint8_t corpusSize = sizeof(corpus) / sizeof(corpus[0]);
+/** The values parsed, so the parsing isn't optimized away */
+float values[MAX_VALUES];
+/** The number of values parsed in one pass over the corpus */
+uint16_t valueCount;
+
+/** @brief One character at a time, with the arithmetic of SDI12::parseFloat() */
+uint8_t parseByCharacter(const char* text) {
+  uint8_t count = 0;
+  while (*text == '+' || *text == '-') {
+    bool  isNegative = *text++ == '-';
+    bool  isFraction = false;
+    long  value      = 0;
+    float fraction   = 1.0;
+    while ((*text >= '0' && *text <= '9') || (*text == '.' && !isFraction)) {
+      if (*text == '.') {
+        isFraction = true;
+      } else {
+        value = value * 10 + *text - '0';
+        if (isFraction) fraction *= 0.1;
+      }
+      text++;
+    }
+    if (count < MAX_VALUES) values[count] = (isNegative ? -value : value) * fraction;
+    count++;
+  }
+  return count;
+}
+
+/** @brief With strtod(), as SDI12Async used to */
+uint8_t parseByStrtod(const char* text) {
+  uint8_t count = 0;
+  while (*text == '+' || *text == '-') {
+    char* end;
+    float value = strtod(text, &end);
+    if (end == text) break;
+    if (count < MAX_VALUES) values[count] = value;
+    count++;
+    text = end;
+  }
+  return count;
+}
+
+/** @brief With SDI12::parseValues() */
+uint8_t parseBySDI12(const char* text) {
+  return SDI12::parseValues(text, strlen(text), values, MAX_VALUES);
+}
+
+/** @brief Time one way of parsing over the whole corpus, and print it */
+void timeParser(const char* label, uint8_t (*parse)(const char*)) {
+  uint32_t elapsed = 0;
+  valueCount       = 0;
+  for (uint16_t rep = 0; rep < REPS; rep++) {
+    for (uint8_t i = 0; i < corpusSize; i++) {
+      uint32_t start = micros();
+      uint8_t  count = parse(corpus[i] + 1);  // after the address
+      elapsed += micros() - start;
+      if (rep == 0) valueCount += count;
+    }
+  }
+  Serial.print(label);
+  Serial.print(": ");
+  Serial.print((float)elapsed / (REPS * corpusSize), 3);
+  Serial.print(" µs a response, ");
+  Serial.print(valueCount);
+  Serial.println(" values");
+}
+
+void setup() {
+  Serial.begin(SERIAL_BAUD);
+  while (!Serial)
+    ;
+
+  Serial.print("Responses in the corpus: ");
+  Serial.println(corpusSize);
+  timeParser("One character at a time", parseByCharacter);
+  timeParser("strtod()", parseByStrtod);
+  timeParser("SDI12::parseValues()", parseBySDI12);
+}
+
+void loop() {}
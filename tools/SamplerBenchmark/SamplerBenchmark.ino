@@ -0,0 +1,246 @@
+/**
+ * @file SamplerBenchmark.ino
+ * @copyright (c) 2013-2020 Stroud Water Research Center (SWRC)
+ *                          and the EnviroDIY Development Team
+ *            This example is published under the BSD-3 license.
+ *
+ * @brief Tool to compare the sustained rate of continuous measurements (aR0!) from one
+ * flow sensor, read the usual way and with SDI12Sampler.
+ *
+ * The sensor is simulated, on a virtual clock, so nothing needs to be attached and the
+ * results are the same on any board.  The model, as in AsyncBenchmark:
+ * - 1200 baud, 8.33 ms a character; a break is 12 ms and is followed by 8.33 ms of
+ * marking
+ * - the sensor answers 10 ms after the end of a command, and goes back to sleep if the
+ * line has been marking for more than 87 ms, after which it ignores commands without
+ * a break
+ * - it answers aR0! with 1, 2 or 4 values, e.g. 0+0.352+12.47
+ *
+ * The usual way is each poll with sendCommand(), so with a break, then the fixed
+ * delay(100) of d_simple_logger, readStringUntil() and parseFloat() for each value.
+ * SDI12Sampler sends the next command as soon as the response is in, without a break,
+ * and is polled once a millisecond.
+ * Each is run for 60 s of virtual time.
+ */
+
+#include <SDI12.h>
+#include <SDI12Sampler.h>
+
+#define SERIAL_BAUD 115200    /*!< The baud rate for the output serial port */
+#define DATA_PIN 7            /*!< The pin of the SDI-12 data bus; not used */
+#define CHAR_MICROS 8333      /*!< The time to send one character at 1200 baud */
+#define RUN_MICROS 60000000UL /*!< The virtual time each way is run for */
+
+/** Define the SDI-12 bus; the simulation never touches the pin */
+SDI12 mySDI12(DATA_PIN);
+/** The ring SDI12Sampler puts the samples in */
+SDI12SampleRing samples;
+
+/**
+ * @brief SDI12Sampler on a virtual clock, with a simulated flow sensor instead of a
+ * wire
+ */
+class SimulatedSampler : public SDI12Sampler {
+ public:
+  SimulatedSampler(SDI12& bus, SDI12SampleRing& ring) : SDI12Sampler(bus, ring) {}
+
+  /** @brief The virtual time, in µs */
+  uint32_t clock = 0;
+  /** @brief The number of breaks sent */
+  uint16_t breaks = 0;
+  /** @brief The number of commands sent */
+  uint16_t commands = 0;
+  /** @brief The number of values the sensor returns */
+  uint8_t valueCount = 1;
+  /** @brief The number of responses the sensor has sent */
+  uint16_t responses = 0;
+
+  /** @brief Reset the clock and the sensor */
+  void reset(uint8_t values) {
+    clock = breaks = commands = responses = 0;
+    valueCount                            = values;
+    _lineEnd                              = 0;
+    _pending[0]                           = '\0';
+    _haveLine                             = false;
+  }
+
+  /** @brief The first value of response n; the others are derived from it */
+  static int16_t firstValue(uint16_t n) {
+    return 100 + n % 900;
+  }
+
+  /** @brief Put a command on the wire and queue the reply, if any */
+  void transmit(const char* command, bool wake) {
+    commands++;
+    bool asleep = clock - _lineEnd > 87000UL;
+    if (wake) {
+      breaks++;
+      clock += 12000;
+    }
+    clock += CHAR_MICROS * (1 + strlen(command));
+    _pending[0] = '\0';
+    if (asleep && !wake) return;
+    if (command[0] != '0' || command[1] != 'R' || command[2] != '0') return;
+
+    uint8_t len = snprintf(_pending, sizeof(_pending), "0+0.%03d",
+                           firstValue(responses));
+    for (uint8_t v = 1; v < valueCount; v++) {
+      len += snprintf(_pending + len, sizeof(_pending) - len, "+%u.%02u", 10 + v,
+                      v * 11);
+    }
+    responses++;
+    _pendingAt = clock + 10000UL + CHAR_MICROS * (len + 2);
+  }
+
+  /** @brief The time the pending reply has been sent by */
+  uint32_t nextLineAt() {
+    return _pending[0] ? _pendingAt : 0xFFFFFFFF;
+  }
+
+  /** @brief Get the pending reply, once it has been sent */
+  bool receive(char* text) {
+    if (!_pending[0] || (int32_t)(clock - _pendingAt) < 0) return false;
+    strcpy(text, _pending);
+    _pending[0] = '\0';
+    _lineEnd    = _pendingAt;
+    return true;
+  }
+
+ protected:
+  void sendCommand(const char* command, bool wake) override {
+    transmit(command, wake);
+  }
+  bool peekLine(SDI12Line& line) override {
+    if (!_haveLine) _haveLine = receive(_line);
+    if (!_haveLine) return false;
+    line.first        = _line;
+    line.firstLength  = strlen(_line);
+    line.second       = _line;
+    line.secondLength = 0;
+    return true;
+  }
+  void consume() override {
+    _haveLine = false;
+  }
+  uint32_t now() override {
+    return clock;
+  }
+
+ private:
+  char     _pending[SDI12_BUFFER_SIZE] = {0};
+  uint32_t _pendingAt                  = 0;
+  uint32_t _lineEnd                    = 0;
+  char     _line[SDI12_BUFFER_SIZE]    = {0};
+  bool     _haveLine                   = false;
+};
+
+SimulatedSampler bus(mySDI12, samples);
+uint32_t         samplesRead;
+uint32_t         valuesRead;
+uint32_t         badSamples;
+/** The last value parsed the usual way, so the parsing isn't optimized away */
+float lastValue;
+
+/** @brief One poll the usual way, on the virtual clock */
+void usualSample() {
+  bus.transmit("0R0!", true);
+  bus.clock += 100000UL;  // delay(100)
+  uint32_t next = bus.nextLineAt();
+  if (next == 0xFFFFFFFF) {
+    bus.clock += 1000000UL;  // the Stream timeout
+    return;
+  }
+  if ((int32_t)(next - bus.clock) > 0) bus.clock = next;  // readStringUntil('\n')
+  char text[SDI12_BUFFER_SIZE];
+  bus.receive(text);
+
+  // parseFloat() for each value, with its arithmetic
+  const char* p     = text + 1;
+  uint8_t     count = 0;
+  while (*p == '+' || *p == '-') {
+    bool  isNegative = *p++ == '-';
+    bool  isFraction = false;
+    long  value      = 0;
+    float fraction   = 1.0;
+    while ((*p >= '0' && *p <= '9') || (*p == '.' && !isFraction)) {
+      if (*p == '.') {
+        isFraction = true;
+      } else {
+        value = value * 10 + *p - '0';
+        if (isFraction) fraction *= 0.1;
+      }
+      p++;
+    }
+    lastValue = (isNegative ? -value : value) * fraction;
+    count++;
+  }
+  samplesRead++;
+  valuesRead += count;
+}
+
+/** @brief Check and count the samples SDI12Sampler has put in the ring */
+void drainSamples() {
+  SDI12Sample s;
+  while (samples.pop(s)) {
+    int16_t expected = SimulatedSampler::firstValue(samplesRead);
+    if (s.address != '0' || s.count != bus.valueCount ||
+        (int16_t)(s.values[0] * 1000 + 0.5) != expected) {
+      badSamples++;
+    }
+    samplesRead++;
+    valuesRead += s.count;
+  }
+}
+
+/** @brief Poll SDI12Sampler, as a loop() that also does 1 ms of other work would */
+void pollSampler() {
+  if (!bus.poll()) bus.clock += 1000;
+  drainSamples();
+}
+
+void printResult(const char* label) {
+  Serial.print(label);
+  Serial.print(": ");
+  Serial.print(samplesRead * 1000000.0 / bus.clock, 2);
+  Serial.print(" samples/s, ");
+  Serial.print(samplesRead);
+  Serial.print(" samples, ");
+  Serial.print(valuesRead);
+  Serial.print(" values, ");
+  Serial.print(bus.breaks);
+  Serial.println(" breaks");
+}
+
+void setup() {
+  Serial.begin(SERIAL_BAUD);
+  while (!Serial)
+    ;
+
+  const uint8_t valueCounts[] = {1, 2, 4};
+  for (uint8_t values : valueCounts) {
+    Serial.print("Values in each response: ");
+    Serial.println(values);
+
+    bus.reset(values);
+    samplesRead = valuesRead = 0;
+    while (bus.clock < RUN_MICROS) usualSample();
+    printResult("  sendCommand(), delay(), readStringUntil(), parseFloat()");
+
+    bus.reset(values);
+    samplesRead = valuesRead = badSamples = 0;
+    bus.start("0");
+    while (bus.clock < RUN_MICROS) pollSampler();
+    printResult("  SDI12Sampler");
+    // let the command on the wire finish before the clock is reset
+    bus.stop();
+    while (bus.isRunning()) pollSampler();
+    Serial.print("  timeouts: ");
+    Serial.print(bus.getTimeouts());
+    Serial.print(", dropped: ");
+    Serial.print(samples.dropped());
+    Serial.print(", wrong: ");
+    Serial.println(badSamples);
+  }
+}
+
+void loop() {}
@@ -0,0 +1,140 @@
+/**
+ * @file TimingBenchmark.ino
+ * @copyright (c) 2013-2020 Stroud Water Research Center (SWRC)
+ *                          and the EnviroDIY Development Team
+ *            This example is published under the BSD-3 license.
+ *
+ * @brief Tool to time the library's hot paths on the target board.
+ *
+ * Nothing needs to be attached to the data pin, but it should not be floating - tie it
+ * low through a resistor so the receive ISR sees an idle (marking) line.
+ *
+ * Reported, averaged over many repetitions:
+ * - the time for one read of the SDI-12 timer; on espressif boards, build once with and
+ * once without `SDI12_ESP_CYCLE_COUNTER` to compare micros() against the cycle counter
+ * - the time spent in one call of the receive interrupt handler on an idle line (the
+ * timer read, the pin read, and the start-bit check)
+ * - the same for the SDI12Bus compile-time pin handler, on boards with a fixed pin map
+ * - the time spent in one call of the oversampling receiver's timer ISR and the
+ * resulting CPU load, when built with `SDI12_OVERSAMPLE`
+ * - the time to switch the line from holding/transmitting to listening
+ * - the time to switch the line from listening to holding
+ * - the total time to write a single character with write(), including the line state
+ * changes before and after it; the character itself takes 10 bit times, ~8333 µs, on
+ * the wire
+ * - the total time to write 10 characters one write() at a time, and with a single
+ * print(); the difference is the time spent changing the line state and in the gaps
+ * between characters
+ */
+
+#include <SDI12.h>
+
+#define SERIAL_BAUD 115200 /*!< The baud rate for the output serial port */
+#define DATA_PIN 7         /*!< The pin of the SDI-12 data bus */
+#define REPS 1000          /*!< The number of repetitions to average over */
+
+/** Define the SDI-12 bus */
+SDI12 mySDI12(DATA_PIN);
+/** A timer object, so READTIME can be timed on its own */
+SDI12Timer sdi12timer;
+
+void printResult(const char* label, uint32_t elapsed_micros, uint32_t reps) {
+  Serial.print(label);
+  Serial.print(": ");
+  Serial.print((float)elapsed_micros / reps, 3);
+  Serial.println(" µs");
+}
+
+void setup() {
+  Serial.begin(SERIAL_BAUD);
+  while (!Serial)
+    ;
+
+  Serial.println("Opening SDI-12 bus...");
+  mySDI12.begin();
+  delay(500);  // allow things to settle
+}
+
+void loop() {
+  uint32_t start;
+  uint32_t elapsed;
+
+  // Time reading the SDI-12 timer, which is done at least once for every change on the
+  // line
+  volatile sdi12timer_t tick;
+  start = micros();
+  for (uint16_t i = 0; i < REPS; i++) { tick = READTIME; }
+  elapsed = micros() - start;
+  (void)tick;
+  printResult("Timer read", elapsed, REPS);
+
+  // Time the receive ISR on an idle line.  The line is pulled low, so while listening
+  // the only calls to the handler are the ones made here.
+  mySDI12.forceListen();
+  start = micros();
+  for (uint16_t i = 0; i < REPS; i++) { SDI12::handleInterrupt(); }
+  elapsed = micros() - start;
+  printResult("Receive ISR, idle line", elapsed, REPS);
+
+#if defined(SDI12_FIXED_PIN_MAP)
+  // The same, through the compile-time pin handler
+  start = micros();
+  for (uint16_t i = 0; i < REPS; i++) { SDI12Bus<DATA_PIN>::handleInterrupt(); }
+  elapsed = micros() - start;
+  printResult("Fixed pin receive ISR, idle line", elapsed, REPS);
+#endif
+
+#if defined(SDI12_OVERSAMPLE) && defined(TICKS_PER_SAMPLE_Q8)
+  // The oversampling receiver's timer ISR; it runs at 4800 Hz the whole time the bus
+  // is listening, so the CPU load is 4800 * this time
+  start = micros();
+  for (uint16_t i = 0; i < REPS; i++) { SDI12::handleSampleTimer(); }
+  elapsed = micros() - start;
+  printResult("Oversampling timer ISR, idle line", elapsed, REPS);
+  Serial.print("Oversampling receiver CPU load: ");
+  Serial.print((float)elapsed / REPS * 4800.0 / 10000.0, 3);
+  Serial.println(" %");
+#endif
+
+  // Time the switch to listening (ie, the TX->LISTEN turnaround)
+  elapsed = 0;
+  for (uint16_t i = 0; i < REPS; i++) {
+    mySDI12.forceHold();
+    start = micros();
+    mySDI12.forceListen();
+    elapsed += micros() - start;
+  }
+  printResult("Switch to listening", elapsed, REPS);
+
+  // Time the switch back to holding
+  elapsed = 0;
+  for (uint16_t i = 0; i < REPS; i++) {
+    mySDI12.forceListen();
+    start = micros();
+    mySDI12.forceHold();
+    elapsed += micros() - start;
+  }
+  printResult("Switch to holding", elapsed, REPS);
+
+  // Time writing single characters; each character is 10 bits at 1200 baud
+  start = micros();
+  for (uint16_t i = 0; i < REPS / 10; i++) { mySDI12.write('0'); }
+  elapsed = micros() - start;
+  printResult("Single character write", elapsed, REPS / 10);
+
+  // Time writing 10 characters separately and all at once
+  start = micros();
+  for (uint8_t i = 0; i < 10; i++) { mySDI12.write('0' + i); }
+  elapsed = micros() - start;
+  printResult("10 single character writes", elapsed, 1);
+  start = micros();
+  mySDI12.print("0123456789");
+  elapsed = micros() - start;
+  printResult("10 character print", elapsed, 1);
+
+  mySDI12.forceHold();
+  mySDI12.clearBuffer();
+  Serial.println("-------------------------------------------------------------------"
+                 "------------");
+  delay(5000);
+}